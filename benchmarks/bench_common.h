@@ -0,0 +1,52 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+//
+// Helpers shared by benchmarks: input fields, either read from `test_data/` or synthesized.
+//
+
+#include "sperr_helper.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace sperr_bench {
+
+// A smooth field (a sum of a few waves) plus a little noise, which resembles simulation output
+//    more than pure noise does. It's deterministic, so results are comparable across runs.
+inline auto synthetic_field(sperr::dims_type dims, uint32_t seed = 7) -> sperr::vecd_type
+{
+  auto gen = std::mt19937(seed);
+  auto noise = std::normal_distribution<double>(0.0, 0.01);
+
+  auto field = sperr::vecd_type(dims[0] * dims[1] * dims[2]);
+  size_t idx = 0;
+  for (size_t z = 0; z < dims[2]; z++) {
+    const auto fz = double(z) / double(dims[2]);
+    for (size_t y = 0; y < dims[1]; y++) {
+      const auto fy = double(y) / double(dims[1]);
+      for (size_t x = 0; x < dims[0]; x++) {
+        const auto fx = double(x) / double(dims[0]);
+        field[idx++] = std::sin(6.0 * fx + 1.0) * std::cos(4.0 * fy) + 0.5 * std::sin(9.0 * fz) +
+                       0.25 * std::cos(20.0 * (fx + fy + fz)) + noise(gen);
+      }
+    }
+  }
+
+  return field;
+}
+
+// Read a float field from `test_data/`, which is copied to the build directory. If the file
+//    isn't available, fall back to a synthetic field of the same dimensions.
+inline auto load_field(const std::string& name, sperr::dims_type dims) -> sperr::vecd_type
+{
+  auto buf = sperr::read_whole_file<float>("../test_data/" + name);
+  if (buf.size() != dims[0] * dims[1] * dims[2])
+    return synthetic_field(dims);
+  return sperr::vecd_type(buf.cbegin(), buf.cend());
+}
+
+}  // namespace sperr_bench
+
+#endif
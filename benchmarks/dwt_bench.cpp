@@ -0,0 +1,113 @@
+#include "CDF97.h"
+
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+//
+// Forward and inverse CDF 9/7 wavelet transforms of 1D, 2D, and 3D synthetic fields.
+//    Both even and odd lengths are included, because they take different code paths.
+//    Each iteration hands a fresh copy of the input to `CDF97`; the copy isn't timed.
+//
+enum class Dir { Forward, Inverse };
+
+template <Dir D>
+void run_xform(benchmark::State& state, sperr::dims_type dims)
+{
+  auto input = sperr_bench::synthetic_field(dims);
+  auto cdf = sperr::CDF97();
+
+  auto forward = [&cdf, &dims] {
+    if (dims[2] > 1)
+      cdf.dwt3d();
+    else if (dims[1] > 1)
+      cdf.dwt2d();
+    else
+      cdf.dwt1d();
+  };
+  auto inverse = [&cdf, &dims] {
+    if (dims[2] > 1)
+      cdf.idwt3d();
+    else if (dims[1] > 1)
+      cdf.idwt2d();
+    else
+      cdf.idwt1d();
+  };
+
+  // Inverse transforms start from wavelet coefficients.
+  if constexpr (D == Dir::Inverse) {
+    cdf.take_data(sperr::vecd_type(input), dims);
+    forward();
+    input = cdf.release_data();
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    cdf.take_data(sperr::vecd_type(input), dims);
+    state.ResumeTiming();
+    if constexpr (D == Dir::Forward)
+      forward();
+    else
+      inverse();
+    benchmark::DoNotOptimize(cdf.view_data().data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * int64_t(input.size()));
+  state.SetBytesProcessed(state.iterations() * int64_t(input.size() * sizeof(double)));
+}
+
+template <Dir D>
+void BM_dwt1d(benchmark::State& state)
+{
+  run_xform<D>(state, {size_t(state.range(0)), 1, 1});
+}
+
+template <Dir D>
+void BM_dwt2d(benchmark::State& state)
+{
+  const auto n = size_t(state.range(0));
+  run_xform<D>(state, {n, n, 1});
+}
+
+template <Dir D>
+void BM_dwt3d(benchmark::State& state)
+{
+  const auto n = size_t(state.range(0));
+  run_xform<D>(state, {n, n, n});
+}
+
+BENCHMARK_TEMPLATE(BM_dwt1d, Dir::Forward)
+    ->Arg(4096)
+    ->Arg(65535)
+    ->Arg(1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_dwt1d, Dir::Inverse)
+    ->Arg(4096)
+    ->Arg(65535)
+    ->Arg(1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_dwt2d, Dir::Forward)
+    ->Arg(128)
+    ->Arg(999)
+    ->Arg(2048)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_dwt2d, Dir::Inverse)
+    ->Arg(128)
+    ->Arg(999)
+    ->Arg(2048)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_dwt3d, Dir::Forward)
+    ->Arg(64)
+    ->Arg(127)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_dwt3d, Dir::Inverse)
+    ->Arg(64)
+    ->Arg(127)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+}  // anonymous namespace
@@ -0,0 +1,312 @@
+#include "Bitmask.h"
+#include "Bitstream.h"
+#include "Conditioner.h"
+#include "Outlier_Coder.h"
+#include "SPECK3D_FLT.h"
+
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// A pseudo-random bit pattern that's cheap to generate.
+auto pattern_bit(size_t i) -> bool
+{
+  return ((i * 2654435761u) >> 13) & 1u;
+}
+
+//
+// Bitstream: sequential writes and reads of individual bits.
+//
+void BM_bitstream_write(benchmark::State& state)
+{
+  const auto nbits = size_t(state.range(0));
+  auto stream = sperr::Bitstream(nbits);
+  for (auto _ : state) {
+    stream.rewind();
+    for (size_t i = 0; i < nbits; i++)
+      stream.wbit(pattern_bit(i));
+    stream.flush();
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(nbits));
+}
+
+void BM_bitstream_read(benchmark::State& state)
+{
+  const auto nbits = size_t(state.range(0));
+  auto stream = sperr::Bitstream(nbits);
+  for (size_t i = 0; i < nbits; i++)
+    stream.wbit(pattern_bit(i));
+  stream.flush();
+
+  for (auto _ : state) {
+    stream.rewind();
+    size_t ones = 0;
+    for (size_t i = 0; i < nbits; i++)
+      ones += stream.rbit();
+    benchmark::DoNotOptimize(ones);
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(nbits));
+}
+
+//
+// Bitmask: random-access writes and reads, and the scans that SPECK relies on.
+//
+void BM_bitmask_write(benchmark::State& state)
+{
+  const auto nbits = size_t(state.range(0));
+  auto mask = sperr::Bitmask(nbits);
+  for (auto _ : state) {
+    for (size_t i = 0; i < nbits; i++)
+      mask.wbit(i, pattern_bit(i));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(nbits));
+}
+
+void BM_bitmask_read(benchmark::State& state)
+{
+  const auto nbits = size_t(state.range(0));
+  auto mask = sperr::Bitmask(nbits);
+  for (size_t i = 0; i < nbits; i++)
+    mask.wbit(i, pattern_bit(i));
+
+  for (auto _ : state) {
+    size_t ones = 0;
+    for (size_t i = 0; i < nbits; i++)
+      ones += mask.rbit(i);
+    benchmark::DoNotOptimize(ones);
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(nbits));
+}
+
+// Scan a sparse mask (one true bit every 1,000 bits) in windows of 64 bits.
+void BM_bitmask_scan(benchmark::State& state)
+{
+  const auto nbits = size_t(state.range(0));
+  auto mask = sperr::Bitmask(nbits);
+  for (size_t i = 0; i < nbits; i += 1000)
+    mask.wtrue(i);
+
+  for (auto _ : state) {
+    size_t found = 0;
+    for (size_t i = 0; i + 64 <= nbits; i += 64)
+      found += mask.has_true(i, 64);
+    found += (mask.find_true(0, nbits) >= 0);
+    found += mask.count_true();
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(nbits));
+}
+
+// Visit all true bits in order, as SPECK's sorting and refinement passes do. The second argument
+//    is the number of true bits per 1,000 bits: masks are sparse in the first bitplanes, and
+//    dense in the last ones.
+void BM_bitmask_next_true(benchmark::State& state)
+{
+  const auto nbits = size_t(state.range(0));
+  const auto per_mille = size_t(state.range(1));
+  auto mask = sperr::Bitmask(nbits);
+  auto gen = std::mt19937(7);
+  auto distrib = std::uniform_int_distribution<size_t>(0, 999);
+  for (size_t i = 0; i < nbits; i++) {
+    if (distrib(gen) < per_mille)
+      mask.wtrue(i);
+  }
+
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (auto i : mask.true_bits())
+      sum += i;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(nbits));
+}
+
+BENCHMARK(BM_bitstream_write)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_bitstream_read)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_bitmask_write)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_bitmask_read)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_bitmask_scan)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_bitmask_next_true)
+    ->Args({1 << 24, 1})
+    ->Args({1 << 24, 50})
+    ->Args({1 << 24, 500})
+    ->Args({1 << 24, 1000});
+
+//
+// Quantization: expose the midtread quantizer of SPECK_FLT, which is otherwise only reachable
+//    through a full compression.
+//
+class Quantizer : public sperr::SPECK3D_FLT {
+ public:
+  void use_vals(sperr::vecd_type vals, double q)
+  {
+    m_vals_d = std::move(vals);
+    m_q = q;
+  }
+  auto quantize(double max_mag) -> sperr::RTNType
+  {
+    auto rtn = m_decide_integer_len(max_mag);
+    if (rtn == sperr::RTNType::Good)
+      m_dispatch_uint([this](auto zero) { m_midtread_quantize<decltype(zero)>(); });
+    return rtn;
+  }
+  void inv_quantize()
+  {
+    m_dispatch_uint([this](auto zero) { m_midtread_inv_quantize<decltype(zero)>(); });
+  }
+};
+
+// The argument is the number of bits of the biggest quantized integer, which decides the
+//    integer type in use.
+void BM_quantize(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{128, 128, 64};
+  auto vals = sperr_bench::synthetic_field(dims);
+  auto max_mag = 0.0;
+  for (auto v : vals)
+    max_mag = std::max(max_mag, std::abs(v));
+  const auto q = max_mag / std::ldexp(1.0, int(state.range(0)));
+
+  auto quantizer = Quantizer();
+  for (auto _ : state) {
+    state.PauseTiming();
+    quantizer.use_vals(vals, q);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(quantizer.quantize(max_mag));
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(vals.size()));
+}
+
+void BM_inv_quantize(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{128, 128, 64};
+  auto vals = sperr_bench::synthetic_field(dims);
+  auto max_mag = 0.0;
+  for (auto v : vals)
+    max_mag = std::max(max_mag, std::abs(v));
+  const auto q = max_mag / std::ldexp(1.0, int(state.range(0)));
+
+  auto quantizer = Quantizer();
+  quantizer.use_vals(vals, q);
+  quantizer.quantize(max_mag);
+  for (auto _ : state) {
+    quantizer.inv_quantize();
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(vals.size()));
+}
+
+BENCHMARK(BM_quantize)->Arg(7)->Arg(15)->Arg(31)->Arg(40)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_inv_quantize)->Arg(7)->Arg(15)->Arg(31)->Arg(40)->Unit(benchmark::kMicrosecond);
+
+//
+// Conditioner: forward and inverse conditioning of the vorticity field in `test_data/`.
+//
+void BM_condition(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto vals = sperr_bench::load_field("vorticity.128_128_41", dims);
+
+  auto condi = sperr::Conditioner();
+  auto buf = sperr::vecd_type();
+  for (auto _ : state) {
+    state.PauseTiming();
+    buf = vals;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(condi.condition(buf, dims));
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(vals.size() * sizeof(double)));
+}
+
+void BM_inverse_condition(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{128, 128, 41};
+  auto buf = sperr_bench::load_field("vorticity.128_128_41", dims);
+
+  auto condi = sperr::Conditioner();
+  const auto header = condi.condition(buf, dims);
+  for (auto _ : state) {
+    condi.inverse_condition(buf, dims, header);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(buf.size() * sizeof(double)));
+}
+
+BENCHMARK(BM_condition)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_inverse_condition)->Unit(benchmark::kMicrosecond);
+
+//
+// Outlier_Coder: encode and decode a list of outliers. The argument is the number of outliers
+//    per 1,000 values.
+//
+auto make_outliers(size_t len, size_t per_mille, double tol) -> std::vector<sperr::Outlier>
+{
+  auto gen = std::mt19937(7);
+  auto pos = std::vector<size_t>(len);
+  std::iota(pos.begin(), pos.end(), size_t{0});
+  std::shuffle(pos.begin(), pos.end(), gen);
+  pos.resize(len * per_mille / 1000);
+  std::sort(pos.begin(), pos.end());
+
+  auto err = std::uniform_real_distribution<double>(1.01 * tol, 4.0 * tol);
+  auto flip = std::bernoulli_distribution(0.5);
+  auto LOS = std::vector<sperr::Outlier>();
+  LOS.reserve(pos.size());
+  for (auto p : pos)
+    LOS.emplace_back(p, flip(gen) ? err(gen) : -err(gen));
+  return LOS;
+}
+
+void BM_outlier_encode(benchmark::State& state)
+{
+  const size_t len = 1 << 20;
+  const double tol = 1e-3;
+  const auto LOS = make_outliers(len, state.range(0), tol);
+
+  auto coder = sperr::Outlier_Coder();
+  coder.set_length(len);
+  coder.set_tolerance(tol);
+  for (auto _ : state) {
+    state.PauseTiming();
+    coder.use_outlier_list(LOS);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(coder.encode());
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(LOS.size()));
+}
+
+void BM_outlier_decode(benchmark::State& state)
+{
+  const size_t len = 1 << 20;
+  const double tol = 1e-3;
+  const auto LOS = make_outliers(len, state.range(0), tol);
+
+  auto encoder = sperr::Outlier_Coder();
+  encoder.set_length(len);
+  encoder.set_tolerance(tol);
+  encoder.use_outlier_list(LOS);
+  encoder.encode();
+  auto stream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(stream);
+
+  auto decoder = sperr::Outlier_Coder();
+  decoder.set_length(len);
+  decoder.set_tolerance(tol);
+  for (auto _ : state) {
+    decoder.use_bitstream(stream.data(), stream.size());
+    benchmark::DoNotOptimize(decoder.decode());
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(LOS.size()));
+}
+
+BENCHMARK(BM_outlier_encode)->Arg(1)->Arg(10)->Arg(50)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_outlier_decode)->Arg(1)->Arg(10)->Arg(50)->Unit(benchmark::kMicrosecond);
+
+}  // anonymous namespace
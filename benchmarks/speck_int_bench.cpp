@@ -0,0 +1,151 @@
+#include "CDF97.h"
+
+#include "SPECK1D_INT_DEC.h"
+#include "SPECK1D_INT_ENC.h"
+#include "SPECK2D_INT_DEC.h"
+#include "SPECK2D_INT_ENC.h"
+#include "SPECK3D_INT_DEC.h"
+#include "SPECK3D_INT_ENC.h"
+
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+
+template <size_t N, typename T>
+using Encoder = std::conditional_t<
+    N == 1,
+    sperr::SPECK1D_INT_ENC<T>,
+    std::conditional_t<N == 2, sperr::SPECK2D_INT_ENC<T>, sperr::SPECK3D_INT_ENC<T>>>;
+
+template <size_t N, typename T>
+using Decoder = std::conditional_t<
+    N == 1,
+    sperr::SPECK1D_INT_DEC<T>,
+    std::conditional_t<N == 2, sperr::SPECK2D_INT_DEC<T>, sperr::SPECK3D_INT_DEC<T>>>;
+
+template <size_t N>
+auto make_dims(size_t n) -> sperr::dims_type
+{
+  if constexpr (N == 1)
+    return {n, 1, 1};
+  else if constexpr (N == 2)
+    return {n, n, 1};
+  else
+    return {n, n, n};
+}
+
+// Quantized wavelet coefficients of a synthetic field, scaled so that the biggest one fills
+//    up the integer type T. (64-bit integers are capped at 2^40, which is plenty of bitplanes.)
+template <size_t N, typename T>
+auto wavelet_coeffs(sperr::dims_type dims) -> std::pair<sperr::uninit_vec_type<T>, sperr::Bitmask>
+{
+  auto cdf = sperr::CDF97();
+  cdf.take_data(sperr_bench::synthetic_field(dims), dims);
+  if constexpr (N == 1)
+    cdf.dwt1d();
+  else if constexpr (N == 2)
+    cdf.dwt2d();
+  else
+    cdf.dwt3d();
+  const auto& vals = cdf.view_data();
+
+  auto max_mag = 0.0;
+  for (auto v : vals)
+    max_mag = std::max(max_mag, std::abs(v));
+  const auto top = sizeof(T) < 8 ? double(std::numeric_limits<T>::max()) : std::ldexp(1.0, 40);
+  const auto q = max_mag / top;
+
+  auto coeffs = sperr::uninit_vec_type<T>(vals.size());
+  auto signs = sperr::Bitmask(vals.size());
+  for (size_t i = 0; i < vals.size(); i++) {
+    coeffs[i] = static_cast<T>(std::min(std::round(std::abs(vals[i]) / q), top));
+    signs.wbit(i, vals[i] >= 0.0);
+  }
+
+  return {std::move(coeffs), std::move(signs)};
+}
+
+//
+// Encode quantized wavelet coefficients. Each iteration hands a fresh copy of the coefficients
+//    to the encoder; the copy isn't timed.
+//
+template <size_t N, typename T>
+void BM_encode(benchmark::State& state)
+{
+  const auto dims = make_dims<N>(state.range(0));
+  const auto [coeffs, signs] = wavelet_coeffs<N, T>(dims);
+
+  auto encoder = Encoder<N, T>();
+  encoder.set_dims(dims);
+  for (auto _ : state) {
+    state.PauseTiming();
+    encoder.use_coeffs(coeffs, signs);
+    state.ResumeTiming();
+    encoder.encode();
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * int64_t(coeffs.size()));
+  state.counters["bpp"] = encoder.encoded_bitstream_len() * 8.0 / double(coeffs.size());
+}
+
+template <size_t N, typename T>
+void BM_decode(benchmark::State& state)
+{
+  const auto dims = make_dims<N>(state.range(0));
+  auto [coeffs, signs] = wavelet_coeffs<N, T>(dims);
+  const auto total_vals = coeffs.size();
+
+  auto encoder = Encoder<N, T>();
+  encoder.set_dims(dims);
+  encoder.use_coeffs(std::move(coeffs), std::move(signs));
+  encoder.encode();
+  auto stream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(stream);
+
+  auto decoder = Decoder<N, T>();
+  decoder.set_dims(dims);
+  for (auto _ : state) {
+    decoder.use_bitstream(stream.data(), stream.size());
+    decoder.decode();
+    benchmark::DoNotOptimize(decoder.view_coeffs().data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * int64_t(total_vals));
+  state.SetBytesProcessed(state.iterations() * int64_t(stream.size()));
+}
+
+BENCHMARK_TEMPLATE(BM_encode, 1, uint8_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 1, uint16_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 1, uint32_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 1, uint64_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 1, uint8_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 1, uint16_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 1, uint32_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 1, uint64_t)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_encode, 2, uint8_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 2, uint16_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 2, uint32_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 2, uint64_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 2, uint8_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 2, uint16_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 2, uint32_t)->Arg(512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 2, uint64_t)->Arg(512)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_encode, 3, uint8_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 3, uint16_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 3, uint32_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_encode, 3, uint64_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 3, uint8_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 3, uint16_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 3, uint32_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_decode, 3, uint64_t)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+
+}  // anonymous namespace
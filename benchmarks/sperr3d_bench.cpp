@@ -0,0 +1,113 @@
+#include "SPERR3D_OMP_C.h"
+#include "SPERR3D_OMP_D.h"
+
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+//
+// End-to-end 3D compression and decompression with a varying number of threads.
+//    Inputs: the vorticity field in `test_data/` (a few chunks), and a bigger synthetic field
+//    (many chunks). Without OpenMP, the number of threads has no effect.
+//
+struct Input {
+  sperr::dims_type dims;
+  sperr::dims_type chunks;
+  sperr::vecd_type vals;
+};
+
+auto vorticity() -> const Input&
+{
+  static const auto input = Input{{128, 128, 41},
+                                  {64, 64, 41},
+                                  sperr_bench::load_field("vorticity.128_128_41", {128, 128, 41})};
+  return input;
+}
+
+auto synthetic() -> const Input&
+{
+  static const auto input =
+      Input{{192, 192, 192}, {64, 64, 64}, sperr_bench::synthetic_field({192, 192, 192})};
+  return input;
+}
+
+void compress(benchmark::State& state, const Input& in)
+{
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(in.dims, in.chunks);
+  encoder.set_psnr(100.0);
+  encoder.set_num_threads(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(encoder.compress(in.vals.data(), in.vals.size()));
+
+  const auto stream = encoder.get_encoded_bitstream();
+  state.SetItemsProcessed(state.iterations() * int64_t(in.vals.size()));
+  state.counters["bpp"] = stream.size() * 8.0 / double(in.vals.size());
+}
+
+void decompress(benchmark::State& state, const Input& in)
+{
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(in.dims, in.chunks);
+  encoder.set_psnr(100.0);
+  encoder.compress(in.vals.data(), in.vals.size());
+  const auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(state.range(0));
+  for (auto _ : state) {
+    decoder.use_bitstream(stream.data(), stream.size());
+    benchmark::DoNotOptimize(decoder.decompress(stream.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(in.vals.size()));
+}
+
+void BM_compress_vorticity(benchmark::State& state)
+{
+  compress(state, vorticity());
+}
+void BM_decompress_vorticity(benchmark::State& state)
+{
+  decompress(state, vorticity());
+}
+void BM_compress_synthetic(benchmark::State& state)
+{
+  compress(state, synthetic());
+}
+void BM_decompress_synthetic(benchmark::State& state)
+{
+  decompress(state, synthetic());
+}
+
+// Thread counts: 1, 2, 4, ... up to the number of hardware threads.
+void thread_counts(benchmark::internal::Benchmark* b)
+{
+  const auto max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  for (unsigned n = 1; n < max_threads; n *= 2)
+    b->Arg(n);
+  b->Arg(max_threads);
+}
+
+BENCHMARK(BM_compress_vorticity)
+    ->Apply(thread_counts)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_decompress_vorticity)
+    ->Apply(thread_counts)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_compress_synthetic)
+    ->Apply(thread_counts)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_decompress_synthetic)
+    ->Apply(thread_counts)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // anonymous namespace
@@ -8,6 +8,8 @@
 
 #include "sperr_helper.h"
 
+#include <tuple>
+
 namespace sperr {
 
 using condi_type = std::array<uint8_t, 17>;
@@ -19,6 +21,11 @@ class Conditioner {
 
   auto is_constant(uint8_t) const -> bool;
 
+  // The minimum and maximum values of the conditioned data, collected during the most recent
+  //    `condition()` call on a non-constant field. They're carried forward so the caller doesn't
+  //    need another sweep of the data to find the data range.
+  auto get_range() const -> std::array<double, 2>;
+
   // Save a double to the last 8 bytes of a condi_type.
   void save_q(condi_type& header, double q) const;
   auto retrieve_q(condi_type header) const -> double;
@@ -31,9 +38,15 @@ class Conditioner {
   size_t m_num_strides = m_default_num_strides;
 
   vecd_type m_stride_buf;
+  std::array<double, 2> m_range = {0.0, 0.0};
 
   // Buffers passed in here are guaranteed to have correct lengths and conditions.
-  auto m_calc_mean(const vecd_type& buf) -> double;
+  //    In one pass, it calculates the mean and also detects if `buf` is a constant field.
+  //    The returned boolean is true if `buf` is a constant field.
+  auto m_calc_mean_and_constant(const vecd_type& buf) -> std::tuple<double, bool>;
+
+  // In one pass, subtract `mean` from every element and record the resulting range.
+  void m_subtract_mean(vecd_type& buf, double mean);
 
   // Adjust the value of `m_num_strides` so it'll be a divisor of `len`.
   void m_adjust_strides(size_t len);
@@ -33,6 +33,8 @@ class Outlier_Coder {
   // Output
   //
   auto view_outlier_list() const -> const std::vector<Outlier>&;
+  auto release_outlier_list() -> std::vector<Outlier>&&;
+  auto encoded_bitstream_len() const -> size_t;
   void append_encoded_bitstream(vec8_type& buf) const;
   auto get_stream_full_len(const void*) const -> size_t;
 
@@ -60,10 +62,10 @@ class Outlier_Coder {
                SPECK1D_INT_DEC<uint64_t>>
       m_decoder;
 
-  std::variant<std::vector<uint8_t>,
-               std::vector<uint16_t>,
-               std::vector<uint32_t>,
-               std::vector<uint64_t>>
+  std::variant<uninit_vec_type<uint8_t>,
+               uninit_vec_type<uint16_t>,
+               uninit_vec_type<uint32_t>,
+               uninit_vec_type<uint64_t>>
       m_vals_ui;
 
   void m_instantiate_uvec_coders(UINTType);
@@ -0,0 +1,86 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+//
+// Optional instrumentation of compression and decompression: wall times of individual stages,
+//    and a few counters of the integer SPECK coder. Timers and counters are only collected when
+//    SPERR is configured with SPERR_PROFILE=ON; otherwise they compile to nothing, and all
+//    profiles stay empty.
+//
+
+#include "sperr_helper.h"
+
+#include <chrono>
+#include <string>
+
+namespace sperr {
+
+#ifdef SPERR_PROFILE
+constexpr bool profiling = true;
+#else
+constexpr bool profiling = false;
+#endif
+
+// Stages that are timed. Each covers both the forward and the inverse operation.
+enum class Stage : size_t {
+  Condition = 0,  // the conditioner
+  DWT,            // wavelet transforms
+  QEstimate,      // estimating the quantization step size
+  Quantize,       // quantization
+  Sorting,        // SPECK sorting passes
+  Refinement,     // SPECK refinement passes
+  Outlier,        // outlier coding
+  Gather,         // gathering chunks from, or scattering chunks to, a bigger volume
+  Count
+};
+
+struct Profile {
+  std::array<double, size_t(Stage::Count)> seconds = {};  // Wall time of each stage.
+
+  // SPECK counters, one value per bitplane, starting from the most significant bitplane.
+  std::vector<uint64_t> sorting_bits;     // Bits produced (or consumed) by sorting passes.
+  std::vector<uint64_t> refinement_bits;  // Bits produced (or consumed) by refinement passes.
+  std::vector<uint64_t> lis_sizes;        // Number of sets in the LIS before sorting passes.
+  std::vector<uint64_t> significant;      // Coefficients found significant by sorting passes.
+
+  size_t bytes_allocated = 0;  // Memory held by working buffers, in bytes.
+  size_t bytes_reused = 0;     // Working buffer bytes served by memory kept from earlier chunks.
+  size_t num_chunks = 0;       // Number of chunks (or compressor runs) aggregated.
+
+  // Add up another profile, e.g., to aggregate profiles of individual chunks.
+  void merge(const Profile& other);
+
+  // A JSON object with all the timers and counters.
+  auto to_json() const -> std::string;
+};
+
+// A JSON object with the aggregated profile (`total`) and profiles of individual chunks (`chunks`).
+auto profile_report_json(const std::vector<Profile>& chunks) -> std::string;
+
+// Add the lifetime of this timer to a stage of a profile, or do nothing if profiling is off.
+class Stage_Timer {
+ public:
+  Stage_Timer(Profile& profile, Stage stage) : m_profile(profile), m_stage(stage)
+  {
+    if constexpr (profiling)
+      m_start = std::chrono::steady_clock::now();
+  }
+  Stage_Timer(const Stage_Timer&) = delete;
+  Stage_Timer& operator=(const Stage_Timer&) = delete;
+  ~Stage_Timer()
+  {
+    if constexpr (profiling) {
+      auto d = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start);
+      m_profile.seconds[size_t(m_stage)] += d.count();
+    }
+  }
+
+ private:
+  Profile& m_profile;
+  const Stage m_stage;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+};  // namespace sperr
+
+#endif
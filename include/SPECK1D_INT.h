@@ -60,6 +60,10 @@ class SPECK1D_INT : public SPECK_INT<T> {
   //
   void m_clean_LIS() final;
   void m_initialize_lists() final;
+  void m_save_lists() final;
+  void m_restore_lists() final;
+  auto m_LIS_stats() const -> std::array<size_t, 2> final;
+  virtual void m_additional_initialization() {};  // empty by default
 
   auto m_partition_set(Set1D) const -> std::array<Set1D, 2>;
 
@@ -67,6 +71,7 @@ class SPECK1D_INT : public SPECK_INT<T> {
   // SPECK1D_INT specific data members
   //
   std::vector<std::vector<Set1D>> m_LIS;
+  std::vector<std::vector<Set1D>> m_ckpt_LIS;  // Decoding only; for checkpoints.
 };
 
 };  // namespace sperr
@@ -26,6 +26,8 @@ class SPECK1D_INT_ENC final : public SPECK1D_INT<T> {
   using SPECK1D_INT<T>::m_partition_set;
 
   void m_sorting_pass() final;
+  void m_additional_initialization() final;
+  void m_bitplane_init() final;
 
   void m_process_S(size_t idx1, size_t idx2, SigType, size_t& counter, bool output);
   void m_process_P(size_t idx, SigType, size_t& counter, bool output);
@@ -34,6 +36,21 @@ class SPECK1D_INT_ENC final : public SPECK1D_INT<T> {
   // Decide if a set is significant or not.
   // If it is significant, also identify the point that makes it significant.
   auto m_decide_significance(const Set1D&) const -> std::optional<size_t>;
+
+  // A max-tree that speeds up `m_decide_significance()` on long sets. Coefficients are grouped
+  //    in blocks of `m_block_len`, and the leaves of the tree hold the biggest MSB position of
+  //    each block. The tree is a complete binary tree stored in an array: node `i` has children
+  //    `2i` and `2i+1`, and the leaves start at `m_tree_leaves`. It's built once per encoding
+  //    and never updated: a set in the LIS only covers insignificant coefficients, which keep
+  //    their original values, so the tree stays exact for every set tested.
+  static constexpr size_t m_block_len = 64;
+  std::vector<int8_t> m_tree;
+  size_t m_tree_leaves = 0;
+  int8_t m_msb_threshold = -1;
+
+  // The first block in [`first`, `last`) that has a coefficient no smaller than the current
+  //    threshold, or `last` if there isn't one.
+  auto m_find_block(size_t first, size_t last) const -> size_t;
 };
 
 };  // namespace sperr
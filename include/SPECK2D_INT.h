@@ -12,6 +12,7 @@ class Set2D {
   uint32_t length_x = 0;
   uint32_t length_y = 0;
   uint16_t part_level = 0;
+  uint32_t node = 0;  // Encoding only: the node of this set in the encoder's max-MSB quadtree.
 
  public:
   auto is_pixel() const -> bool { return (size_t{length_x} * length_y == 1); };
@@ -21,8 +22,11 @@ class Set2D {
 
 //
 // Main SPECK2D_INT class; intended to be the base class of both encoder and decoder.
+//    `Derived` is the encoder or decoder class itself (CRTP), which provides `m_process_S()`,
+//    `m_process_P()`, and `m_process_I()`. They're called without virtual dispatch, so the
+//    compiler is free to inline them into the recursion of `m_code_S()` and `m_code_I()`.
 //
-template <typename T>
+template <typename T, class Derived>
 class SPECK2D_INT : public SPECK_INT<T> {
  protected:
   //
@@ -37,14 +41,16 @@ class SPECK2D_INT : public SPECK_INT<T> {
   void m_sorting_pass() final;
   void m_clean_LIS() final;
   void m_initialize_lists() final;
+  void m_save_lists() final;
+  void m_restore_lists() final;
+  auto m_LIS_stats() const -> std::array<size_t, 2> final;
 
   void m_code_S(size_t idx1, size_t idx2);
   void m_code_I();
 
-  virtual void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide) = 0;
-  virtual void m_process_P(size_t idx, size_t& counter, bool need_decide) = 0;
-  virtual void m_process_I(bool need_decide) = 0;
-  virtual void m_additional_initialization() {};
+  // `Derived` may hide this one to do its own initialization.
+  void m_additional_initialization() {}
+  auto m_derived() -> Derived& { return static_cast<Derived&>(*this); }
 
   auto m_partition_S(Set2D) const -> std::array<Set2D, 4>;
   auto m_partition_I() -> std::array<Set2D, 3>;
@@ -54,6 +60,16 @@ class SPECK2D_INT : public SPECK_INT<T> {
   //
   Set2D m_I;
   std::vector<std::vector<Set2D>> m_LIS;
+  Set2D m_ckpt_I;  // Decoding only; for checkpoints.
+  std::vector<std::vector<Set2D>> m_ckpt_LIS;
+
+  // Encoding only: the shape of a quadtree that follows the partitioning of sets, so the encoder
+  //    can tell the significance of a set with one lookup (see SPECK2D_INT_ENC). `m_tree_child[i]`
+  //    is the first of the four consecutive children of node `i`, in the order subsets are
+  //    produced by `m_partition_S()` or `m_partition_I()`, and it's 0 if node `i` is a leaf.
+  //    The partition functions pass node indices on to subsets when the tree exists; subsets of a
+  //    leaf get node 0, which isn't part of the tree.
+  std::vector<uint32_t> m_tree_child;
 };
 
 };  // namespace sperr
@@ -9,8 +9,11 @@ namespace sperr {
 // Main SPECK2D_INT_ENC class
 //
 template <typename T>
-class SPECK2D_INT_ENC final : public SPECK2D_INT<T> {
+class SPECK2D_INT_ENC final : public SPECK2D_INT<T, SPECK2D_INT_ENC<T>> {
  private:
+  using base_type = SPECK2D_INT<T, SPECK2D_INT_ENC>;
+  friend base_type;  // The base class calls the `m_process_*()` functions directly.
+
   //
   // Bring members from parent classes to this derived class.
   //
@@ -21,15 +24,18 @@ class SPECK2D_INT_ENC final : public SPECK2D_INT<T> {
   using SPECK_INT<T>::m_coeff_buf;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK2D_INT<T>::m_LIS;
-  using SPECK2D_INT<T>::m_I;
-  using SPECK2D_INT<T>::m_code_S;
-  using SPECK2D_INT<T>::m_code_I;
-
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide) final;
-  void m_process_P(size_t idx, size_t& counter, bool need_decide) final;
-  void m_process_I(bool need_decide) final;
-  void m_additional_initialization() final;
+  using base_type::m_LIS;
+  using base_type::m_I;
+  using base_type::m_code_S;
+  using base_type::m_code_I;
+  using base_type::m_partition_S;
+  using base_type::m_partition_I;
+  using base_type::m_tree_child;
+
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide);
+  void m_process_P(size_t idx, size_t& counter, bool need_decide);
+  void m_process_I(bool need_decide);
+  void m_additional_initialization();
   void m_bitplane_init() final;
   void m_refinement_extra() final;
 
@@ -40,6 +46,16 @@ class SPECK2D_INT_ENC final : public SPECK2D_INT<T> {
   // m_coeff_buf. Significance tests compare entries against `m_msb_threshold`.
   std::vector<int8_t> m_msb_buf;
   int8_t m_msb_threshold = -1;
+
+  // The max-MSB quadtree: `m_tree_max[i]` is the biggest MSB position within node `i`, so the
+  //    significance of a set in the tree is a single lookup. It's built once per encoding, and
+  //    sets no bigger than `m_tree_leaf_size` are leaves; their subsets are scanned directly.
+  static constexpr size_t m_tree_leaf_size = 16;
+  std::vector<int8_t> m_tree_max;
+  void m_build_tree();
+  auto m_build_node(const Set2D&) -> int8_t;
+  auto m_new_nodes(size_t num) -> uint32_t;
+  auto m_scan_max(const Set2D&) const -> int8_t;
 };
 
 };  // namespace sperr
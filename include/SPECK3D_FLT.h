@@ -12,6 +12,12 @@ class SPECK3D_FLT : public SPECK_FLT {
 
   void m_wavelet_xform() override;
   void m_inverse_wavelet_xform(bool) override;
+
+  // Chunks with a dimension longer than 65,535 use 32-bit coordinates in SPECK3D sets.
+  //    Note: the dimensions need to be set before decoding a bitstream.
+  bool m_wide_encoder = false;
+  bool m_wide_decoder = false;
+  auto m_use_wide_sets() const -> bool;
 };
 
 };  // namespace sperr
@@ -3,19 +3,124 @@
 
 #include "SPECK_INT.h"
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <tuple>
 
 namespace sperr {
 
+//
+// A small cache of read-only objects that only depend on the dimensions of a volume, such as
+//    the initial LIS. Most chunks of a volume have the same dimensions, so these objects are made
+//    once and then shared by coders in all threads.
+//
+// The cache is bounded by bytes: it holds at most `max_bytes` bytes of objects, evicting the least
+//    recently used ones. An object is only cached the second time its dimensions are requested,
+//    so one-off dimensions don't pay for, or pin, memory they never reuse. Objects bigger than
+//    `max_bytes / 4` are never cached. `clear()` releases all cached objects.
+//
+template <typename V>
+class Shape_Cache {
+ public:
+  static constexpr size_t max_bytes = size_t{256} * 1024 * 1024;
+
+  // Return the object for `dims`, calling `make()` to make it if it's not cached yet.
+  //    `bytes_of()` tells how many bytes an object holds.
+  template <typename F, typename B>
+  auto get(dims_type dims, F&& make, B&& bytes_of) -> std::shared_ptr<const V>
+  {
+    auto seen = false;
+    {
+      auto lock = std::lock_guard(m_mutex);
+      if (auto obj = m_find(dims))
+        return obj;
+      seen = m_saw(dims);
+    }
+
+    // Don't hold the lock while making an object; another thread making the same one is harmless.
+    auto obj = std::make_shared<const V>(make());
+    const auto bytes = bytes_of(*obj);
+    if (!seen || bytes > max_bytes / 4)
+      return obj;
+
+    auto lock = std::lock_guard(m_mutex);
+    if (auto cached = m_find(dims))
+      return cached;
+    while (m_bytes + bytes > max_bytes) {  // Evict the least recently used objects.
+      m_bytes -= m_entries.front().bytes;
+      m_entries.erase(m_entries.begin());
+    }
+    m_entries.push_back({dims, obj, bytes});
+    m_bytes += bytes;
+    return obj;
+  }
+
+  void clear()
+  {
+    auto lock = std::lock_guard(m_mutex);
+    m_entries.clear();
+    m_entries.shrink_to_fit();
+    m_bytes = 0;
+  }
+
+ private:
+  struct Entry {
+    dims_type dims;
+    std::shared_ptr<const V> obj;
+    size_t bytes;
+  };
+  static constexpr size_t seen_capacity = 16;
+
+  std::mutex m_mutex;
+  std::vector<Entry> m_entries;  // From the least to the most recently used.
+  size_t m_bytes = 0;
+  std::vector<dims_type> m_seen;  // Recently requested dimensions, cached or not.
+
+  // Find a cached object, and mark it as the most recently used. The lock needs to be held.
+  auto m_find(dims_type dims) -> std::shared_ptr<const V>
+  {
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                           [dims](const auto& e) { return e.dims == dims; });
+    if (it == m_entries.end())
+      return nullptr;
+    std::rotate(it, it + 1, m_entries.end());
+    return m_entries.back().obj;
+  }
+
+  // Record that `dims` is requested, and tell if it was requested before. The lock needs to be
+  //    held.
+  auto m_saw(dims_type dims) -> bool
+  {
+    if (std::find(m_seen.cbegin(), m_seen.cend(), dims) != m_seen.cend())
+      return true;
+    if (m_seen.size() == seen_capacity)
+      m_seen.erase(m_seen.begin());
+    m_seen.push_back(dims);
+    return false;
+  }
+};
+
+// Release the memory held by the caches of objects shared by SPECK3D coders (initial LISs and
+//    morton order permutations), e.g., after compressing a volume with big chunks. Coders keep
+//    working afterwards; they make these objects again when needed.
+void release_shape_caches();
+
+//
+// Coordinates of a set are stored as `C`, which is `uint16_t` for most chunks so a set takes
+//    24 bytes, and `uint32_t` for chunks that have a dimension longer than 65,535.
+//
+template <typename C>
 class Set3D {
  public:
   uint64_t morton_idx = 0;
-  uint16_t start_x = 0;
-  uint16_t start_y = 0;
-  uint16_t start_z = 0;
-  uint16_t length_x = 0;
-  uint16_t length_y = 0;
-  uint16_t length_z = 0;
+  C start_x = 0;
+  C start_y = 0;
+  C start_z = 0;
+  C length_x = 0;
+  C length_y = 0;
+  C length_z = 0;
 
   void make_empty() { length_x = 0; }
   auto num_elem() const -> size_t { return (size_t{length_x} * length_y * length_z); }
@@ -23,9 +128,17 @@ class Set3D {
 
 //
 // Main SPECK3D_INT class; intended to be the base class of both encoder and decoder.
+//    `Derived` is the encoder or decoder class itself (CRTP), which provides `m_process_S()`,
+//    `m_process_P()`, and `m_process_P_lite()`. They're called without virtual dispatch, so the
+//    compiler is free to inline them into `m_sorting_pass()` and the recursion of `m_code_S()`.
 //
-template <typename T>
+template <typename T, typename C, class Derived>
 class SPECK3D_INT : public SPECK_INT<T> {
+ public:
+  // The longest dimension that this class can work on. `encode()` and `decode()` fail on longer
+  //    ones; use `C = uint32_t` for them.
+  static constexpr size_t max_dim = std::numeric_limits<C>::max();
+
  protected:
   //
   // Bring members from the base class to this derived class.
@@ -39,21 +152,39 @@ class SPECK3D_INT : public SPECK_INT<T> {
   void m_initialize_lists() final;
   void m_sorting_pass() final;
   void m_clean_LIS() final;
+  void m_save_lists() final;
+  void m_restore_lists() final;
+  auto m_LIS_stats() const -> std::array<size_t, 2> final;
+  auto m_dims_supported() const -> bool final;
 
-  virtual void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool) = 0;
-  virtual void m_process_P(size_t i, size_t m, size_t& c, bool) = 0;  // Called by `m_code_S()`.
-  virtual void m_process_P_lite(size_t idx) = 0;  // Called by `m_sorting_pass()` directly.
-  virtual void m_additional_initialization() {};  // empty by default
+  // `Derived` may hide this one to do its own initialization.
+  void m_additional_initialization() {}
+  auto m_derived() -> Derived& { return static_cast<Derived&>(*this); }
 
   void m_code_S(size_t idx1, size_t idx2);
-  auto m_partition_S_XYZ(Set3D, uint16_t) const -> std::tuple<std::array<Set3D, 8>, uint16_t>;
-  auto m_partition_S_XY(Set3D, uint16_t) const -> std::tuple<std::array<Set3D, 4>, uint16_t>;
-  auto m_partition_S_Z(Set3D, uint16_t) const -> std::tuple<std::array<Set3D, 2>, uint16_t>;
+  using set_type = Set3D<C>;
+  using lis_type = std::vector<std::vector<set_type>>;
+
+  // The initial LIS, with each set's `morton_idx` assigned in the order that `m_sorting_pass()`
+  //    visits them. It only depends on `m_dims`, so `m_initialize_lists()` makes it once per
+  //    distinct dimensions and copies it from a cache afterwards.
+  auto m_make_initial_LIS() const -> lis_type;
+  auto m_partition_S_XYZ(set_type, uint16_t) const
+      -> std::tuple<std::array<set_type, 8>, uint16_t>;
+  auto m_partition_S_XY(set_type, uint16_t) const -> std::tuple<std::array<set_type, 4>, uint16_t>;
+  auto m_partition_S_Z(set_type, uint16_t) const -> std::tuple<std::array<set_type, 2>, uint16_t>;
+
+  // Power-of-two cubic volumes (e.g., 64^3, 128^3) are the most common chunk shape. Then every set
+  //    is a power-of-two cube too, and every partition splits evenly into 8 non-empty cubes.
+  //    `m_code_S()` takes a shorter path for this case.
+  bool m_pow2_cube = false;
+  auto m_partition_S_cube(set_type) const -> std::array<set_type, 8>;
 
   //
   // SPECK3D_INT specific data members
   //
-  std::vector<std::vector<Set3D>> m_LIS;
+  lis_type m_LIS;
+  lis_type m_ckpt_LIS;  // Decoding only; for checkpoints.
 };
 
 };  // namespace sperr
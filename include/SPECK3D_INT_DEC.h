@@ -8,9 +8,12 @@ namespace sperr {
 //
 // Main SPECK3D_INT_DEC class
 //
-template <typename T>
-class SPECK3D_INT_DEC final : public SPECK3D_INT<T> {
+template <typename T, typename C = uint16_t>
+class SPECK3D_INT_DEC final : public SPECK3D_INT<T, C, SPECK3D_INT_DEC<T, C>> {
  private:
+  using base_type = SPECK3D_INT<T, C, SPECK3D_INT_DEC>;
+  friend base_type;  // The base class calls the `m_process_*()` functions directly.
+
   //
   // Bring members from parent classes to this derived class.
   //
@@ -18,12 +21,12 @@ class SPECK3D_INT_DEC final : public SPECK3D_INT<T> {
   using SPECK_INT<T>::m_LSP_new;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK3D_INT<T>::m_LIS;
-  using SPECK3D_INT<T>::m_code_S;
+  using base_type::m_LIS;
+  using base_type::m_code_S;
 
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read) final;
-  void m_process_P(size_t idx, size_t no_use, size_t& counter, bool read) final;
-  void m_process_P_lite(size_t idx) final;
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read);
+  void m_process_P(size_t idx, size_t no_use, size_t& counter, bool read);
+  void m_process_P_lite(size_t idx);
 };
 
 };  // namespace sperr
@@ -5,17 +5,23 @@
 
 namespace sperr {
 
+// Permutations from morton order to raster order, shared by all encoders.
+auto morton_perm_cache() -> Shape_Cache<std::vector<uint32_t>>&;
+
 //
 // Main SPECK3D_INT_ENC class
 //
-template <typename T>
-class SPECK3D_INT_ENC final : public SPECK3D_INT<T> {
+template <typename T, typename C = uint16_t>
+class SPECK3D_INT_ENC final : public SPECK3D_INT<T, C, SPECK3D_INT_ENC<T, C>> {
  private:
+  using base_type = SPECK3D_INT<T, C, SPECK3D_INT_ENC>;
+  friend base_type;  // The base class calls the `m_process_*()` functions directly.
+
   //
   // Consistant with the base class.
   //
   using uint_type = T;
-  using vecui_type = std::vector<uint_type>;
+  using vecui_type = uninit_vec_type<uint_type>;
 
   //
   // Bring members from parent classes to this derived class.
@@ -27,14 +33,14 @@ class SPECK3D_INT_ENC final : public SPECK3D_INT<T> {
   using SPECK_INT<T>::m_coeff_buf;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK3D_INT<T>::m_LIS;
-  using SPECK3D_INT<T>::m_partition_S_XYZ;
-  using SPECK3D_INT<T>::m_code_S;
-
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool output) final;
-  void m_process_P(size_t idx, size_t morton, size_t& counter, bool output) final;
-  void m_process_P_lite(size_t idx) final;
-  void m_additional_initialization() final;
+  using base_type::m_LIS;
+  using base_type::m_partition_S_XYZ;
+  using base_type::m_code_S;
+
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool output);
+  void m_process_P(size_t idx, size_t morton, size_t& counter, bool output);
+  void m_process_P_lite(size_t idx);
+  void m_additional_initialization();
   void m_bitplane_init() final;
   void m_refinement_extra() final;
 
@@ -46,7 +52,12 @@ class SPECK3D_INT_ENC final : public SPECK3D_INT<T> {
   // `m_morton_threshold` is the MSB position of `m_threshold`, updated each bitplane via
   // m_bitplane_init(). Significance tests compare m_morton_buf entries against this value.
   int8_t m_morton_threshold = -1;
-  void m_deposit_set(Set3D);
+  void m_deposit_set(Set3D<C>);
+
+  // The permutation from morton order to raster order: the `i`th value of `m_morton_buf` is
+  //    made from `m_coeff_buf[perm[i]]`.
+  auto m_make_morton_perm() const -> std::vector<uint32_t>;
+  void m_fill_morton_perm(Set3D<C>, std::vector<uint32_t>& perm) const;
 };
 
 };  // namespace sperr
@@ -10,7 +10,8 @@
 #include "Outlier_Coder.h"
 #include "SPECK_INT.h"
 
-#include <variant>
+#include <memory>
+#include <tuple>
 
 namespace sperr {
 
@@ -30,7 +31,7 @@ class SPECK_FLT {
   void copy_data(const T* p, size_t len);
 
   // Accept incoming data: take ownership of a memory block
-  void take_data(std::vector<double>&&);
+  void take_data(vecd_type&&);
 
   // Use an encoded bitstream
   // Note: `len` is the number of bytes.
@@ -40,11 +41,20 @@ class SPECK_FLT {
   // Output
   //
   void append_encoded_bitstream(vec8_type& buf) const;
+  auto encoded_bitstream_len() const -> size_t;  // what `append_encoded_bitstream()` appends
   auto view_decoded_data() const -> const vecd_type&;
   auto view_hierarchy() const -> const std::vector<vecd_type>&;
   auto release_decoded_data() -> vecd_type&&;
   auto release_hierarchy() -> std::vector<vecd_type>&&;
 
+  // Optional: during compression, also build a rate-distortion table that records the estimated
+  //    SSE when the bitstream is truncated at the end of each bitplane. It's off by default.
+  void enable_rd_table(bool);
+  auto view_rd_table() const -> const rd_table_type&;
+
+  // Timers and counters of the most recent compression or decompression; see Profile.h.
+  auto view_profile() const -> const Profile&;
+
   //
   // General configuration and info.
   //
@@ -54,6 +64,11 @@ class SPECK_FLT {
   void set_dims(dims_type);
   auto integer_len() const -> size_t;
 
+  // Optional: how big buffers of input values (by `copy_data()`) and decoded values get their
+  //    memory; see `MemPolicy`. Data passed in by `take_data()` keeps its own policy.
+  //    It's `MemPolicy::Default` by default.
+  void set_mem_policy(MemPolicy);
+
 #ifdef EXPERIMENTING
   void set_direct_q(double q);
 #endif
@@ -64,42 +79,94 @@ class SPECK_FLT {
   auto compress() -> RTNType;
   auto decompress(bool multi_res = false) -> RTNType;
 
+  // Progressive decoding: after `use_bitstream()` and `decompress()` on a portion of a bitstream,
+  //    pass in a longer portion of the same bitstream here to refine the decompressed data.
+  //    The integer SPECK decoder resumes from where it ran out of bits instead of starting over.
+  //    If resuming isn't possible, it falls back to `use_bitstream()` followed by `decompress()`.
+  //    Resuming is only possible after `set_resumable(true)`, which makes the integer SPECK
+  //    decoder keep a checkpoint when it runs out of bits. It's off by default.
+  auto refine(const void* p, size_t len, bool multi_res = false) -> RTNType;
+  void set_resumable(bool);
+
  protected:
   UINTType m_uint_flag = UINTType::UINT64;
   bool m_has_outlier = false;           // encoding (PWE mode) and decoding
+  bool m_resumable = false;             // decoding only
   CompMode m_mode = CompMode::Unknown;  // encoding only
   double m_q = 0.0;                     // encoding and decoding
   double m_quality = 0.0;               // encoding only, represent either PSNR, PWE, or BPP.
+  uint64_t m_max_ui = 0;                // encoding only, the biggest value in `m_vals_ui`.
+  bool m_rd_enabled = false;            // encoding only
+  rd_table_type m_rd_table;             // encoding only
   vecd_type m_vals_orig;                // encoding only (PWE mode)
+  std::vector<Outlier> m_LOS;           // encoding only (PWE mode)
   dims_type m_dims = {0, 0, 0};
+  MemPolicy m_mem_policy = MemPolicy::Default;
   vecd_type m_vals_d;
   condi_type m_condi_bitstream;
   Bitmask m_sign_array;
   std::vector<vecd_type> m_hierarchy;  // multi-resolution decoding
+  Profile m_profile;
 
   CDF97 m_cdf;
   Conditioner m_conditioner;
   Outlier_Coder m_out_coder;
 
-  std::variant<std::vector<uint8_t>,
-               std::vector<uint16_t>,
-               std::vector<uint32_t>,
-               std::vector<uint64_t>>
+  // Integer coefficients and integer SPECK coders, one of each integer length. Only the ones of
+  //    length `m_uint_flag` are in use at a time, but the others keep their memory, so chunks that
+  //    need different integer lengths don't make this class reallocate or re-create them.
+  template <typename T>
+  using coder_ptr = std::unique_ptr<SPECK_INT<T>>;
+  std::tuple<uninit_vec_type<uint8_t>,
+             uninit_vec_type<uint16_t>,
+             uninit_vec_type<uint32_t>,
+             uninit_vec_type<uint64_t>>
       m_vals_ui;
-
-  std::variant<std::unique_ptr<SPECK_INT<uint8_t>>,
-               std::unique_ptr<SPECK_INT<uint16_t>>,
-               std::unique_ptr<SPECK_INT<uint32_t>>,
-               std::unique_ptr<SPECK_INT<uint64_t>>>
+  std::tuple<coder_ptr<uint8_t>, coder_ptr<uint16_t>, coder_ptr<uint32_t>, coder_ptr<uint64_t>>
       m_encoder, m_decoder;
 
-  // Instantiate `m_vals_ui` based on the chosen integer length.
-  void m_instantiate_int_vec();
-
-  // Derived classes instantiate the correct `m_encoder` and `m_decoder` depending on
-  // 3D/2D/1D classes, and on the integer length in use.
+  // Call `f` with a zero of the unsigned integer type of length `m_uint_flag`. It's the only place
+  //    that dispatches on the integer length; `f` then runs a templated function on that type.
+  template <typename F>
+  auto m_dispatch_uint(F&& f) const
+  {
+    switch (m_uint_flag) {
+      case UINTType::UINT8:
+        return f(uint8_t{0});
+      case UINTType::UINT16:
+        return f(uint16_t{0});
+      case UINTType::UINT32:
+        return f(uint32_t{0});
+      default:
+        return f(uint64_t{0});
+    }
+  }
+
+  // Derived classes make sure that the encoder or decoder of integer length `m_uint_flag` exists,
+  //    depending on 3D/2D/1D classes. `m_instantiate_coder()` helps them do that.
   virtual void m_instantiate_encoder() = 0;
   virtual void m_instantiate_decoder() = 0;
+  template <typename Coders, typename F>
+  void m_instantiate_coder(Coders& coders, F&& make)
+  {
+    m_dispatch_uint([&coders, &make](auto zero) {
+      auto& coder = std::get<coder_ptr<decltype(zero)>>(coders);
+      if (coder == nullptr)
+        coder = make(zero);
+    });
+  }
+
+  // The integer part of the pipeline, which runs with the integer type `T` picked by
+  //    `m_uint_flag`: quantization and encoding, parsing a SPECK bitstream, decoding, and
+  //    resuming decoding with more bits. Decoding is followed by `m_reconstruct()`.
+  template <typename T>
+  auto m_encode_ints() -> RTNType;
+  template <typename T>
+  auto m_parse_speck_stream(const uint8_t* p, size_t len) -> RTNType;
+  template <typename T>
+  auto m_decode_ints(bool multi_res) -> RTNType;
+  template <typename T>
+  auto m_refine_ints(const void* p, size_t len, bool multi_res) -> RTNType;
 
   // Both wavelet transforms operate on `m_vals_d`.
   virtual void m_wavelet_xform() = 0;
@@ -108,9 +175,43 @@ class SPECK_FLT {
   // This base class provides two midtread quantization implementations.
   //    Quantization reads from `m_vals_d`, and writes to `m_vals_ui` and `m_sign_array`.
   //    Inverse quantization reads from `m_vals_ui` and `m_sign_array`, and writes to `m_vals_d`.
-  auto m_midtread_quantize() -> RTNType;
+  //    Before quantization, `m_decide_integer_len()` sets `m_uint_flag` given `max_mag`, the
+  //    biggest magnitude in `m_vals_d`. Quantization records the biggest integer in `m_max_ui`;
+  //    if it doesn't fit in `m_uint_flag` after all, `m_encode_ints()` moves to a wider type.
+  virtual auto m_decide_integer_len(double max_mag) -> RTNType;
+  template <typename T>
+  void m_midtread_quantize();
+  template <typename T>
   void m_midtread_inv_quantize();
 
+  // Rate-distortion table support: first, build a histogram of the quantized integers in
+  //    `m_vals_ui`, bucketed by their most significant bits. Second, after encoding, use the
+  //    histogram and the encoder's bitplane boundaries to estimate `m_rd_table`.
+  template <typename T>
+  void m_msb_histogram(std::array<size_t, 64>& counts, std::array<double, 64>& sumsq) const;
+  template <typename T>
+  void m_build_rd_table(const std::array<size_t, 64>& counts, const std::array<double, 64>& sumsq);
+
+  // Parse the outlier coder bitstream following the SPECK bitstream. A partially available
+  //    outlier coder bitstream is simply discarded.
+  auto m_parse_outlier_stream(const uint8_t* p, size_t len) -> RTNType;
+
+  // Decompression steps after integer SPECK decoding: inverse quantization, inverse wavelet
+  //    transform, outlier correction, and inverse conditioning.
+  template <typename T>
+  auto m_reconstruct(bool multi_res) -> RTNType;
+
+  // Decompress a bitstream from scratch, when `refine()` can't resume decoding.
+  auto m_start_over(const void* p, size_t len, bool multi_res) -> RTNType;
+
+  // Make `m_vals_d` allocate memory following `m_mem_policy`. It drops the content of `m_vals_d`
+  //    if it has to switch policies.
+  void m_apply_mem_policy();
+
+  // Profiling: start a new profile, and add the memory held by this class to it at the end.
+  void m_profile_reset();
+  void m_profile_memory();
+
   // Estimate MSE assuming midtread quantization strategy.
   auto m_estimate_mse_midtread(double q) const -> double;
 
@@ -9,6 +9,9 @@
 
 #include "Bitmask.h"
 #include "Bitstream.h"
+#include "Profile.h"
+
+#include <optional>
 
 namespace sperr {
 
@@ -18,13 +21,28 @@ namespace sperr {
 //
 auto speck_int_get_num_bitplanes(const void* bitstream) -> uint8_t;
 
+//
+// Another helper for profiling: the number of sets in a list of insignificant sets (LIS),
+//    and the bytes it holds.
+//
+template <typename Set>
+auto lis_stats(const std::vector<std::vector<Set>>& lis) -> std::array<size_t, 2>
+{
+  auto stats = std::array<size_t, 2>{0, lis.capacity() * sizeof(std::vector<Set>)};
+  for (const auto& v : lis) {
+    stats[0] += v.size();
+    stats[1] += v.capacity() * sizeof(Set);
+  }
+  return stats;
+}
+
 //
 // Class SPECK_INT
 //
 template <typename T>
 class SPECK_INT {
   using uint_type = T;
-  using vecui_type = std::vector<uint_type>;
+  using vecui_type = uninit_vec_type<uint_type>;
 
  public:
   // Constructor and destructor
@@ -48,12 +66,27 @@ class SPECK_INT {
   // Retrieve the number of bytes of a SPECK bitstream (including header) from its header.
   auto get_stream_full_len(const void*) const -> uint64_t;
 
-  // Actions
-  void encode();
-  void decode();
+  // Actions. They return `RTNType::Error` without doing anything if the dimensions are longer
+  //    than the coder supports (see `SPECK3D_INT::max_dim`).
+  auto encode() -> RTNType;
+  auto decode() -> RTNType;
+
+  // Progressive decoding: after `decode()` on a partial bitstream, pass in a longer portion of
+  //    the same bitstream here (starting from its header, just like `use_bitstream()`) to refine
+  //    the decoded coefficients. Decoding resumes from the beginning of the bitplane where the
+  //    previous decoding ran out of bits, instead of starting over.
+  //    It returns `RTNType::Error` if there's nothing to resume from; see `can_resume()`.
+  //    Resuming needs a checkpoint, which costs a copy of the decoder's state at every bitplane,
+  //    so the decoder only keeps one after `set_resumable(true)`. It's off by default.
+  auto decode_more(const void* p, size_t len) -> RTNType;
+  auto can_resume() const -> bool;
+  void set_resumable(bool);
 
   // Input
   auto use_coeffs(vecui_type coeffs, Bitmask signs) -> RTNType;
+  // If the caller already knows the biggest coefficient (e.g., found during quantization),
+  //    passing it in here saves the encoder a pass over `coeffs` to find it again.
+  auto use_coeffs(vecui_type coeffs, Bitmask signs, uint_type max_coeff) -> RTNType;
   void use_bitstream(const void* p, size_t len);
 
   // Output
@@ -63,6 +96,10 @@ class SPECK_INT {
   auto release_signs() -> Bitmask&&;
   auto view_coeffs() const -> const vecui_type&;
   auto view_signs() const -> const Bitmask&;
+  // Encoding only: the number of bits produced by the end of each bitplane that is completed.
+  auto view_bitplane_ends() const -> const std::vector<uint64_t>&;
+  // Timers and counters of the most recent encoding or decoding; see Profile.h.
+  auto view_profile() const -> const Profile&;
 
  protected:
   // Core SPECK procedures
@@ -71,21 +108,53 @@ class SPECK_INT {
   virtual void m_initialize_lists() = 0;
   virtual void m_bitplane_init() {}
   virtual void m_refinement_extra() {}
+  virtual auto m_dims_supported() const -> bool { return true; }
   void m_refinement_pass_encode();
   void m_refinement_pass_decode();
 
+  // Run the sorting or refinement pass of one bitplane, and profile it if profiling is on.
+  void m_sorting_pass_profiled(bool encoding);
+  void m_refinement_pass_profiled(bool encoding);
+  void m_profile_memory();
+
+  // Decode bitplanes starting from `first_bitplane`, saving a checkpoint at the beginning of
+  //    every bitplane if resumable and only a partial bitstream is available.
+  void m_decode_bitplanes(uint8_t first_bitplane);
+  void m_save_checkpoint(uint8_t bitplane);
+  void m_restore_checkpoint();
+
+  // Derived classes save and restore their own lists (LIS, etc.) to support checkpoints.
+  virtual void m_save_lists() = 0;
+  virtual void m_restore_lists() = 0;
+
+  // Derived classes report the number of sets in their LIS, and the bytes it holds.
+  virtual auto m_LIS_stats() const -> std::array<size_t, 2> = 0;
+
   // Data members
   uint64_t m_total_bits = 0;  // The number of bits of a complete SPECK stream.
   uint64_t m_avail_bits = 0;  // Decoding only. `m_avail_bits` <= `m_total_bits`
   size_t m_budget = std::numeric_limits<size_t>::max();
   uint_type m_threshold = 0;
   uint8_t m_num_bitplanes = 0;
+  std::optional<uint_type> m_max_coeff;  // Encoding only; the biggest value in `m_coeff_buf`.
 
   dims_type m_dims = {0, 0, 0};
   vecui_type m_coeff_buf;
   std::vector<uint64_t> m_LSP_new;
   Bitmask m_LSP_mask, m_LIP_mask, m_sign_array;
   Bitstream m_bit_buffer;
+  std::vector<uint64_t> m_bitplane_ends;  // Encoding only.
+  Profile m_profile;
+
+  // Decoding only: the decoder's state at the beginning of the bitplane where a partial bitstream
+  //    ran out of bits, so decoding can resume from there when more bits become available.
+  bool m_resumable = false;
+  bool m_has_checkpoint = false;
+  uint8_t m_ckpt_bitplane = 0;
+  uint_type m_ckpt_threshold = 0;
+  size_t m_ckpt_bit_pos = 0;
+  vecui_type m_ckpt_coeff_buf;
+  Bitmask m_ckpt_LSP_mask, m_ckpt_LIP_mask, m_ckpt_sign_array;
 };
 
 };  // namespace sperr
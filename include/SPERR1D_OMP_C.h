@@ -0,0 +1,60 @@
+//
+// This is a class that compresses a long 1D array, and utilizes OpenMP to achieve
+// parallelization: the input array is divided into segments, and each segment is compressed
+// individually. It mirrors what SPERR3D_OMP_C does for volumes. The output bitstream contains
+// a segment index, so that any range of the array can be decoded without decoding the rest
+// (see SPERR1D_OMP_D).
+//
+
+#ifndef SPERR1D_OMP_C_H
+#define SPERR1D_OMP_C_H
+
+#include "SPECK1D_FLT.h"
+
+namespace sperr {
+
+class SPERR1D_OMP_C {
+ public:
+  // If 0 is passed in, the maximal number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Note on `segment_len`: the last segment can be shorter if the array length is not divisible
+  //    by `segment_len`. It needs to be between 1 and 2^32 - 1.
+  void set_length_and_segment(size_t len, size_t segment_len);
+
+  void set_psnr(double);
+  void set_tolerance(double);
+  void set_bitrate(double);
+
+  // Apply compression on an array pointed to by `buf`.
+  template <typename T>
+  auto compress(const T* buf, size_t buf_len) -> RTNType;
+
+  // Output: produce a vector containing the encoded bitstream.
+  auto get_encoded_bitstream() const -> vec8_type;
+
+ private:
+  bool m_orig_is_float = true;  // The original input precision is saved in header.
+  CompMode m_mode = CompMode::Unknown;
+  double m_quality = 0.0;
+  size_t m_len = 0;
+  size_t m_segment_len = 1'048'576;  // 8MB of doubles
+
+  std::vector<vec8_type> m_encoded_streams;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK1D_FLT>> m_compressors;
+#else
+  std::unique_ptr<SPECK1D_FLT> m_compressor;
+#endif
+
+  // The eventual header size would be this magic number + num_segments * 4
+  const size_t m_header_magic = 14;
+
+  auto m_generate_header() const -> vec8_type;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -0,0 +1,55 @@
+//
+// This is a class that decompresses a 1D bitstream produced by SPERR1D_OMP_C. It can decompress
+// the whole array, or any range of it, in which case only the segments overlapping that range
+// are decoded. Segments are decoded in parallel using OpenMP.
+//
+
+#ifndef SPERR1D_OMP_D_H
+#define SPERR1D_OMP_D_H
+
+#include "SPECK1D_FLT.h"
+
+namespace sperr {
+
+class SPERR1D_OMP_D {
+ public:
+  // If 0 is passed in here, the maximum number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Parse the header of this stream, and stores the pointer.
+  auto use_bitstream(const void*, size_t) -> RTNType;
+
+  // Decompress the whole array, or elements in [start, start + len) only.
+  //    The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
+  //    Either way, the decoded values are available through `view_decoded_data()`.
+  auto decompress(const void* bitstream) -> RTNType;
+  auto decompress_range(const void* bitstream, size_t start, size_t len) -> RTNType;
+
+  auto view_decoded_data() const -> const vecd_type&;
+  auto release_decoded_data() -> vecd_type&&;
+
+  auto get_length() const -> size_t;
+  auto get_segment_len() const -> size_t;
+
+ private:
+  size_t m_len = 0;
+  size_t m_segment_len = 0;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK1D_FLT>> m_decompressors;
+#else
+  std::unique_ptr<SPECK1D_FLT> m_decompressor;
+#endif
+
+  vecd_type m_decoded_buf;
+  std::vector<size_t> m_offsets;  // Address offset and length of each segment, interleaved.
+  const uint8_t* m_bitstream_ptr = nullptr;
+
+  // Header size would be the magic number + num_segments * 4
+  const size_t m_header_magic = 14;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -0,0 +1,57 @@
+//
+// This is a class that compresses a batch of same-sized 2D slices, such as the levels of a 3D
+// field that are to be compressed as 2D, and utilizes OpenMP to process multiple slices in
+// parallel. All slices are encoded into a single container with a slice offset table, so that
+// any individual slice can be decoded without touching the others (see SPERR2D_OMP_D).
+//
+
+#ifndef SPERR2D_OMP_C_H
+#define SPERR2D_OMP_C_H
+
+#include "SPECK2D_FLT.h"
+
+namespace sperr {
+
+class SPERR2D_OMP_C {
+ public:
+  // If 0 is passed in, the maximal number of threads will be used.
+  void set_num_threads(size_t);
+
+  // `dims` is {X, Y, number of slices}. Slices are stored one after another in the input buffer.
+  void set_dims(dims_type dims);
+
+  void set_psnr(double);
+  void set_tolerance(double);
+  void set_bitrate(double);
+
+  // Apply compression on a batch of slices pointed to by `buf`.
+  template <typename T>
+  auto compress(const T* buf, size_t buf_len) -> RTNType;
+
+  // Output: produce a vector containing the encoded bitstream.
+  auto get_encoded_bitstream() const -> vec8_type;
+
+ private:
+  bool m_orig_is_float = true;  // The original input precision is saved in header.
+  CompMode m_mode = CompMode::Unknown;
+  double m_quality = 0.0;
+  dims_type m_dims = {0, 0, 0};  // {X, Y, number of slices}
+
+  std::vector<vec8_type> m_encoded_streams;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK2D_FLT>> m_compressors;
+#else
+  std::unique_ptr<SPECK2D_FLT> m_compressor;
+#endif
+
+  // The eventual header size would be this magic number + num_slices * 4
+  const size_t m_header_magic = 14;
+
+  auto m_generate_header() const -> vec8_type;
+};
+
+}  // End of namespace sperr
+
+#endif
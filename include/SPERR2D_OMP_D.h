@@ -0,0 +1,62 @@
+//
+// This is a class that decompresses a batch of 2D slices produced by SPERR2D_OMP_C. It can
+// decompress all slices in parallel using OpenMP, or any individual slice alone.
+//
+
+#ifndef SPERR2D_OMP_D_H
+#define SPERR2D_OMP_D_H
+
+#include "SPECK2D_FLT.h"
+
+namespace sperr {
+
+class SPERR2D_OMP_D {
+ public:
+  // If 0 is passed in here, the maximum number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Parse the header of this stream, and stores the pointer.
+  auto use_bitstream(const void*, size_t) -> RTNType;
+
+  // Decompress all slices. The pointer passed in here MUST be the same as the one passed
+  //    to `use_bitstream()`.
+  auto decompress(const void* bitstream) -> RTNType;
+
+  // Decompress a single slice. Again, the pointer MUST be the same as the one passed
+  //    to `use_bitstream()`. The decoded slice is available through `view_decoded_slice()`.
+  auto decompress_slice(const void* bitstream, size_t idx) -> RTNType;
+
+  auto view_decoded_data() const -> const vecd_type&;
+  auto release_decoded_data() -> vecd_type&&;
+  auto view_decoded_slice() const -> const vecd_type&;
+  auto release_decoded_slice() -> vecd_type&&;
+
+  // {X, Y, number of slices}
+  auto get_dims() const -> dims_type;
+
+  // {offset, length} of the bitstream of slice `idx`, relative to the beginning of the container.
+  //    It allows a caller to read only the bytes of the slice of interest from a file, for example.
+  auto get_slice_range(size_t idx) const -> std::array<size_t, 2>;
+
+ private:
+  dims_type m_dims = {0, 0, 0};  // {X, Y, number of slices}
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK2D_FLT>> m_decompressors;
+#else
+  std::unique_ptr<SPECK2D_FLT> m_decompressor;
+#endif
+
+  vecd_type m_vol_buf;
+  vecd_type m_slice_buf;
+  std::vector<size_t> m_offsets;  // Address offset and length of each slice, interleaved.
+  const uint8_t* m_bitstream_ptr = nullptr;
+
+  // Header size would be the magic number + num_slices * 4
+  const size_t m_header_magic = 14;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -0,0 +1,114 @@
+//
+// A container packs many 3D SPERR bitstreams, typically one for each variable at each time step,
+//    into a single file, together with an index to access any of them directly.
+//
+// The container file consists of the following parts:
+//  -- a file header: magic "SPERRCTN" (8 bytes), a version number (1 byte), unused (7 bytes)
+//  -- bitstreams produced by `SPERR3D_OMP_C`, appended one after another
+//  -- an index, where each entry has a name length (2 bytes), the name, a time step (8 bytes),
+//     and the offset and length of its bitstream (8 + 8 bytes)
+//  -- a trailer: offset of the index (8 bytes), number of entries (8 bytes), magic (8 bytes)
+//
+// Appending to an existing container never overwrites anything: new bitstreams, then a new
+//    index and trailer covering all entries, are written after the old trailer.
+//
+
+#ifndef SPERR3D_CONTAINER_H
+#define SPERR3D_CONTAINER_H
+
+#include "SPERR3D_OMP_C.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace sperr {
+
+struct SPERR3D_Container_Entry {
+  std::string name;
+  size_t timestep = 0;
+  size_t offset = 0;  // Absolute offset of the bitstream in the container file.
+  size_t len = 0;     // Length of the bitstream.
+};
+
+class SPERR3D_Container_Writer {
+ public:
+  SPERR3D_Container_Writer() = default;
+  SPERR3D_Container_Writer(const SPERR3D_Container_Writer&) = delete;
+  SPERR3D_Container_Writer& operator=(const SPERR3D_Container_Writer&) = delete;
+  ~SPERR3D_Container_Writer();  // Calls `close()` if it's not called yet.
+
+  // Create a new container, or keep adding to an existing one when `append` is true.
+  auto open(const std::string& filename, bool append = false) -> RTNType;
+
+  // Add a bitstream for `name` at `timestep`. A (name, time step) pair can only be added once.
+  //    These functions can be called from multiple threads at the same time; the second version
+  //    writes the output of an encoder, so compression in different threads runs concurrently.
+  auto append(const std::string& name, size_t timestep, const void* stream, size_t len)
+      -> RTNType;
+  auto append(const std::string& name, size_t timestep, const SPERR3D_OMP_C& encoder) -> RTNType;
+
+  // Write the index and the trailer, and close the file. It needs to be called after all
+  //    `append()` calls have returned.
+  auto close() -> RTNType;
+
+ private:
+  std::FILE* m_file = nullptr;
+  size_t m_file_len = 0;  // Where the next bitstream goes.
+  std::vector<SPERR3D_Container_Entry> m_entries;
+  std::mutex m_mutex;
+};
+
+class SPERR3D_Container_Reader {
+ public:
+  SPERR3D_Container_Reader() = default;
+  SPERR3D_Container_Reader(const SPERR3D_Container_Reader&) = delete;
+  SPERR3D_Container_Reader& operator=(const SPERR3D_Container_Reader&) = delete;
+  ~SPERR3D_Container_Reader();
+
+  // Open a container and parse its index. The file is memory-mapped where supported, so only
+  //    the index and the bytes actually decoded are read from disk.
+  auto open(const std::string& filename) -> RTNType;
+
+  // All entries, sorted by name and then by time step.
+  auto view_entries() const -> const std::vector<SPERR3D_Container_Entry>&;
+
+  // Find an entry, or return nullptr if it doesn't exist.
+  auto find(const std::string& name, size_t timestep) const -> const SPERR3D_Container_Entry*;
+
+  // Retrieve the bitstream of an entry, truncated to `pct` percent (see
+  //    `SPERR3D_Stream_Tools::progressive_read()`). Returns an empty vector upon failure.
+  auto get_stream(const std::string& name, size_t timestep, unsigned pct = 100) const
+      -> vec8_type;
+
+  // Retrieve a partial bitstream of an entry, which only keeps chunks that intersect with
+  //    `region` (see `SPERR3D_Stream_Tools::plan_ranges()`).
+  auto get_region(const std::string& name,
+                  size_t timestep,
+                  std::array<size_t, 6> region,
+                  unsigned pct = 100) const -> vec8_type;
+
+  // Decompress `region` of an entry into `dst`, which then has (region[1] x region[3] x
+  //    region[5]) values. If 0 is passed in as `num_threads`, the maximal number of threads
+  //    will be used.
+  auto decompress_region(const std::string& name,
+                         size_t timestep,
+                         std::array<size_t, 6> region,
+                         vecd_type& dst,
+                         size_t num_threads = 1) const -> RTNType;
+
+ private:
+  std::string m_filename;
+  const uint8_t* m_map = nullptr;  // The memory-mapped file, if available.
+  size_t m_file_len = 0;
+  std::vector<SPERR3D_Container_Entry> m_entries;
+
+  // Get `len` bytes at `offset` of the file: either point into `m_map`, or read them into `buf`.
+  //    Returns nullptr upon failure.
+  auto m_fetch(size_t offset, size_t len, vec8_type& buf) const -> const uint8_t*;
+  void m_unmap();
+};
+
+}  // End of namespace sperr
+
+#endif
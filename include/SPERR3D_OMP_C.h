@@ -27,6 +27,23 @@ class SPERR3D_OMP_C {
   void set_direct_q(double);
 #endif
 
+  // Optional: also record a compact rate-distortion table for each chunk in the bitstream, so
+  //    the bitstream can later be truncated to a target quality or size (see
+  //    `SPERR3D_Stream_Tools`). It's off by default.
+  void enable_rd_table(bool);
+
+  // Optional: use a large header, which keeps 64-bit volume and chunk dimensions, and an index
+  //    of 64-bit chunk offsets. The index is placed right after the header, or at the very end
+  //    of the bitstream when `footer_index` is true, so a writer doesn't need to know chunk
+  //    lengths before writing them. A large header is used anyway when any dimension or chunk
+  //    length doesn't fit in the default header. It's off by default.
+  void set_large_header(bool large, bool footer_index = false);
+
+  // Optional: how buffers of chunks get their memory; see `MemPolicy`. Each chunk is gathered
+  //    by the thread that compresses it, so its pages are first touched by, and placed on the
+  //    NUMA node of, that thread. It's `MemPolicy::Default` by default.
+  void set_mem_policy(MemPolicy);
+
   // Apply compression on a volume pointed to by `buf`.
   template <typename T>
   auto compress(const T* buf, size_t buf_len) -> RTNType;
@@ -34,13 +51,37 @@ class SPERR3D_OMP_C {
   // Output: produce a vector containing the encoded bitstream.
   auto get_encoded_bitstream() const -> vec8_type;
 
- private:
+  // Output: write the encoded bitstream to a buffer provided by the caller, which needs to hold
+  //    at least `get_encoded_bitstream_len()` bytes. Otherwise, it returns `WrongLength`.
+  auto get_encoded_bitstream_len() const -> size_t;
+  auto write_encoded_bitstream(void* dst, size_t dst_len) const -> RTNType;
+
+  // An upper bound of `get_encoded_bitstream_len()`, given an upper bound of the bitstream length
+  //    of each chunk (in the order of `chunk_volume()`). The header, rate-distortion section, and
+  //    chunk index are counted the same way as in an encoded bitstream, following the dimensions
+  //    and options already set. It returns 0 if the number of chunks doesn't match.
+  auto max_encoded_bitstream_len(const std::vector<size_t>& max_chunk_lens) const -> size_t;
+
+  // Timers and counters of each chunk of the most recent compression; see Profile.h.
+  auto view_chunk_profiles() const -> const std::vector<Profile>&;
+
+ protected:
   bool m_orig_is_float = true;  // The original input precision is saved in header.
   CompMode m_mode = CompMode::Unknown;
   double m_quality = 0.0;
   dims_type m_dims = {0, 0, 0};        // Dimension of the entire volume
   dims_type m_chunk_dims = {0, 0, 0};  // Preferred dimensions for a chunk
   std::vector<vec8_type> m_encoded_streams;
+  std::vector<Profile> m_chunk_profiles;
+
+  // Rate-distortion tables of individual chunks, and the data range of the entire volume.
+  bool m_rd_enabled = false;
+  double m_data_range = 0.0;
+  std::vector<rd_table_type> m_rd_tables;
+
+  bool m_large_header = false;
+  bool m_footer_index = false;
+  MemPolicy m_mem_policy = MemPolicy::Default;
 
 #ifdef USE_OMP
   size_t m_num_threads = 1;
@@ -56,20 +97,57 @@ class SPERR3D_OMP_C {
   std::unique_ptr<SPECK3D_FLT> m_compressor;
 #endif
 
+  // One chunk buffer per thread. Chunks that a thread compresses one after another reuse its
+  //    memory, rather than each allocating (and page faulting) a buffer of its own.
+  std::vector<vecd_type> m_thread_bufs;
+
   // The eventual header size would be this magic number + num_chunks * 4
   const size_t m_header_magic_nchunks = 20;
   const size_t m_header_magic_1chunk = 14;
+  // A large header is this magic number + (num_chunks + 1) * 8, unless the index is a footer.
+  const size_t m_header_magic_large = 68;
 
   //
   // Private methods
   //
-  auto m_generate_header() const -> vec8_type;
-
-  // Gather a chunk from a bigger volume.
+  // The header only depends on the lengths of chunk bitstreams (`lens`), not their content.
+  auto m_generate_header(const std::vector<size_t>& lens) const -> vec8_type;
+  auto m_header_len(const std::vector<size_t>& lens) const -> size_t;
+  auto m_header_len(const std::vector<size_t>& lens, bool has_rd) const -> size_t;
+  auto m_use_large_header(const std::vector<size_t>& lens) const -> bool;
+  auto m_stream_lens() const -> std::vector<size_t>;  // Lengths of `m_encoded_streams`.
+  auto m_rd_section_len() const -> size_t;
+  void m_write_rd_section(uint8_t* dst) const;
+
+  // Absolute offsets of all chunks in the bitstream, followed by where the last chunk ends.
+  auto m_chunk_index(const std::vector<size_t>& lens) const -> std::vector<uint64_t>;
+
+  // Check the input and prepare data structures before compressing `num_chunks` chunks.
+  template <typename T>
+  auto m_prepare_chunks(const T* buf, size_t buf_len, size_t num_chunks) -> RTNType;
+
+  // Compress the `idx`-th chunk, whose data is in `buf`, and save its bitstream (and
+  //    rate-distortion table) in slot `idx`. `buf` is handed back afterwards; its memory can be
+  //    reused, but not its content.
+  auto m_encode_chunk(SPECK3D_FLT& compressor,
+                      size_t idx,
+                      std::array<size_t, 6> chunk,
+                      vecd_type& buf) -> RTNType;
+
+  // The compressor, and the chunk buffer, of the calling OpenMP thread.
+  auto m_thread_compressor() -> SPECK3D_FLT&;
+  auto m_thread_buf() -> vecd_type&;
+
+  // Gather a chunk from a bigger volume into `chunk_buf`, reusing its memory if it follows
+  //    `m_mem_policy`; the reused bytes are counted in `profile`.
   // If the requested chunk lives outside of the volume, whole or part,
-  //    this function returns an empty vector.
+  //    `chunk_buf` is left empty.
   template <typename T>
-  auto m_gather_chunk(const T* vol, dims_type vol_dim, std::array<size_t, 6> chunk) -> vecd_type;
+  void m_gather_chunk(const T* vol,
+                      dims_type vol_dim,
+                      std::array<size_t, 6> chunk,
+                      vecd_type& chunk_buf,
+                      Profile& profile);
 };
 
 }  // End of namespace sperr
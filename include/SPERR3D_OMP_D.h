@@ -23,6 +23,34 @@ class SPERR3D_OMP_D {
   // The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
   auto decompress(const void* bitstream, bool multi_res = false) -> RTNType;
 
+  // Decompress only the chunks that intersect with `region` (start and length in X, Y, and Z),
+  //    and put the values of the region in `dst`, which then has (region[1] x region[3] x
+  //    region[5]) values. The bitstream only needs to keep those chunks, e.g., one assembled by
+  //    `SPERR3D_Stream_Tools::assemble_ranges()`. The entire volume is never allocated, and
+  //    `view_decoded_data()` is left unchanged.
+  //    The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
+  auto decompress_region(const void* bitstream, std::array<size_t, 6> region, vecd_type& dst)
+      -> RTNType;
+
+  // Progressive decoding: keep the decoding state of every chunk after `decompress()`, so that
+  //    `refine()` can resume decoding with more bytes instead of starting over. This costs memory
+  //    proportional to the entire volume, thus it's off by default.
+  void set_resumable(bool);
+
+  // Optional: how the decompressed volume, its hierarchy, and the buffers of chunks get their
+  //    memory; see `MemPolicy`. The volume isn't zeroed up front; instead, each part of it is
+  //    first touched by, and placed on the NUMA node of, the thread that decompresses the chunk
+  //    that lands there. It's `MemPolicy::Default` by default.
+  void set_mem_policy(MemPolicy);
+
+  // After `use_bitstream()` and `decompress()` on a portion of a bitstream (e.g., produced by
+  //    `SPERR3D_Stream_Tools::progressive_read()`), pass in a longer portion of the same bitstream
+  //    (or the complete bitstream) here to refine the decompressed volume. Each chunk resumes
+  //    decoding from where it ran out of bits. Without a resumable state, it falls back to
+  //    `use_bitstream()` followed by `decompress()`. Either way, `bitstream` becomes the new
+  //    stream in use.
+  auto refine(const void* bitstream, size_t len, bool multi_res = false) -> RTNType;
+
   auto view_decoded_data() const -> const sperr::vecd_type&;
   auto view_hierarchy() const -> const std::vector<vecd_type>&;
   auto release_decoded_data() -> sperr::vecd_type&&;
@@ -31,6 +59,9 @@ class SPERR3D_OMP_D {
   auto get_dims() const -> sperr::dims_type;
   auto get_chunk_dims() const -> sperr::dims_type;
 
+  // Timers and counters of each chunk of the most recent decompression; see Profile.h.
+  auto view_chunk_profiles() const -> const std::vector<Profile>&;
+
  private:
   sperr::dims_type m_dims = {0, 0, 0};        // Dimension of the entire volume
   sperr::dims_type m_chunk_dims = {0, 0, 0};  // Preferred dimensions for a chunk
@@ -50,15 +81,28 @@ class SPERR3D_OMP_D {
   std::unique_ptr<SPECK3D_FLT> m_decompressor;
 #endif
 
+  // One decompressor per chunk, which keeps the decoding state of each chunk for `refine()`.
+  bool m_resumable = false;
+  bool m_can_refine = false;
+  std::vector<std::unique_ptr<SPECK3D_FLT>> m_chunk_decompressors;
+
+  MemPolicy m_mem_policy = MemPolicy::Default;
   sperr::vecd_type m_vol_buf;
   std::vector<vecd_type> m_hierarchy;  // multi-resolution decoding
   std::vector<size_t> m_offsets;       // Address offset to locate each bitstream chunk.
+  std::vector<Profile> m_chunk_profiles;
   const uint8_t* m_bitstream_ptr = nullptr;
 
   // Header size would be the magic number + num_chunks * 4
   const size_t m_header_magic_nchunks = 20;
   const size_t m_header_magic_1chunk = 14;
 
+  // Decompress (or refine) every chunk and assemble them.
+  auto m_decompress_chunks(bool multi_res, bool refine) -> RTNType;
+
+  // Make sure there's a decompressor for every thread.
+  void m_make_thread_decompressors();
+
   // Put this chunk to a bigger volume
   // Memory errors will occur if the big and small volumes are not the same size as described.
   void m_scatter_chunk(vecd_type& big_vol,
@@ -0,0 +1,64 @@
+//
+// This class compresses a raw volume on disk into a bitstream on disk with three pipelined
+//    stages, so reading, compressing, and writing happen at the same time:
+//  -- a reader, which reads the volume one slab of chunks at a time and gathers chunks;
+//  -- a pool of compressor threads, each compressing one chunk at a time;
+//  -- a writer, which writes finished chunk bitstreams to the output file in order.
+// The stages are connected by bounded queues, and at most a limited number of chunks are in
+//    flight. The reader also keeps one slab of X * Y * chunk_Z values, so the memory footprint
+//    grows with the X-Y extent of the volume and the chunk size, but not with its Z extent.
+//
+// The output is a regular SPERR3D bitstream that always uses a large header (see
+//    `SPERR3D_OMP_C::set_large_header()`), because the header needs a fixed size before any
+//    chunk length is known. The header is written last.
+//
+
+#ifndef SPERR3D_PIPELINE_C_H
+#define SPERR3D_PIPELINE_C_H
+
+#include "SPERR3D_OMP_C.h"
+
+namespace sperr {
+
+class SPERR3D_Pipeline_C : private SPERR3D_OMP_C {
+ public:
+  using SPERR3D_OMP_C::enable_rd_table;
+  using SPERR3D_OMP_C::set_bitrate;
+  using SPERR3D_OMP_C::set_dims_and_chunks;
+  using SPERR3D_OMP_C::set_mem_policy;
+  using SPERR3D_OMP_C::set_psnr;
+  using SPERR3D_OMP_C::set_tolerance;
+  using SPERR3D_OMP_C::view_chunk_profiles;
+
+  // The number of compressor threads. If 0 is passed in, the number of hardware threads is used.
+  void set_num_threads(size_t);
+
+  // The maximal number of chunks in flight, i.e., read but not written yet. It's 0 by default,
+  //    meaning twice the number of compressor threads.
+  void set_queue_depth(size_t);
+
+  // Optional: place the chunk index at the end of the bitstream instead of in the header.
+  void set_footer_index(bool);
+
+  // Compress the raw volume in file `input` (of type T), and write the bitstream to file `output`.
+  template <typename T>
+  auto compress_file(const std::string& input, const std::string& output) -> RTNType;
+
+  // Statistics of the most recent `compress_file()`: the wall time in seconds, and the fraction
+  //    of that time each stage (read, compress, write) was busy. The compress stage is averaged
+  //    over all compressor threads.
+  auto get_elapsed_time() const -> double;
+  auto get_stage_utilization() const -> std::array<double, 3>;
+
+ private:
+  size_t m_num_workers = 1;
+  size_t m_queue_depth = 0;
+  std::vector<std::unique_ptr<SPECK3D_FLT>> m_pool;
+
+  double m_elapsed = 0.0;
+  std::array<double, 3> m_busy = {0.0, 0.0, 0.0};  // Busy seconds of each stage.
+};
+
+}  // End of namespace sperr
+
+#endif
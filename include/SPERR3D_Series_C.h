@@ -0,0 +1,49 @@
+//
+// This class compresses a time series of same-shaped volumes, one time step at a time. It keeps
+//    everything that doesn't change between time steps: the chunk geometry, the per-thread
+//    compressors, their internal buffers, the gathered chunks, and the output bitstream, so
+//    their memory stays at its high-water mark instead of being allocated again every step.
+//
+// Each time step produces a regular SPERR3D bitstream, exactly the same as `SPERR3D_OMP_C`
+//    produces on the same volume.
+//
+
+#ifndef SPERR3D_SERIES_C_H
+#define SPERR3D_SERIES_C_H
+
+#include "SPERR3D_OMP_C.h"
+
+namespace sperr {
+
+class SPERR3D_Series_C : public SPERR3D_OMP_C {
+ public:
+  // Compress the volume of one time step pointed to by `buf`.
+  //
+  // Optionally, `next_buf` points to the volume of the following time step. Its chunks are then
+  //    gathered by each thread right after it finishes encoding the same chunk of this step, so
+  //    gathering the next step overlaps with encoding this one. In that case, the next call
+  //    needs to pass in `next_buf` as `buf`, and its content shouldn't change in between.
+  template <typename T>
+  auto compress(const T* buf, size_t buf_len, const T* next_buf = nullptr) -> RTNType;
+
+  // Output: assemble the bitstream of the most recent time step in a buffer that is reused
+  //    across time steps. The returned reference is valid until the next call to `compress()`.
+  auto assemble_encoded_bitstream() -> const vec8_type&;
+
+ private:
+  // Chunk geometry, which is only re-calculated when the dimensions change.
+  dims_type m_idx_dims = {0, 0, 0};
+  dims_type m_idx_chunk_dims = {0, 0, 0};
+  std::vector<std::array<size_t, 6>> m_chunk_idx;
+
+  // Chunks of the volume that is going to be compressed next, if they're gathered already.
+  std::vector<vecd_type> m_chunk_bufs;
+  const void* m_staged = nullptr;
+  bool m_staged_is_float = true;
+
+  vec8_type m_output;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -8,6 +8,12 @@ namespace sperr {
 //
 // The 3D SPERR header definition is in SPERR3D_OMP_C.cpp::m_generate_header().
 //
+// A bitstream with a large header, or with a rate-distortion section, records this version number
+//    instead of the major version. It has the highest bit set, so decoders that predate these
+//    header extensions reject such bitstreams as a version mismatch, rather than misparsing them.
+constexpr uint8_t extended_header_version =
+    static_cast<uint8_t>(SPERR_VERSION_MAJOR) | uint8_t{0x80};
+
 struct SPERR3D_Header {
   // Info directly stored in the header
   uint8_t major_version = 0;
@@ -15,24 +21,54 @@ struct SPERR3D_Header {
   bool is_3D = false;
   bool is_float = false;
   bool multi_chunk = false;
+  bool has_rd_table = false;
+  bool large_header = false;  // 64-bit dimensions and an index of 64-bit chunk offsets.
   dims_type vol_dims = {0, 0, 0};
   dims_type chunk_dims = {0, 0, 0};
+  size_t rd_table_len = 0;  // The rate-distortion section, which follows all chunks.
+  size_t index_offset = 0;  // Large header only: where the chunk index is in the bitstream.
 
   // Info calculated from above
   size_t header_len = 0;
   size_t stream_len = 0;
+  size_t index_len = 0;        // Large header only: length of the chunk index in bytes.
+  bool footer_index = false;   // Large header only: if the chunk index follows everything else.
+  size_t rd_table_offset = 0;  // Only available after `chunk_offsets` are available.
+  std::vector<size_t> chunk_offsets;
+};
+
+//
+// A plan to fetch a portion of a bitstream, e.g., from object storage; see `plan_ranges()`.
+//
+struct SPERR3D_Range_Plan {
+  // Byte ranges to fetch, as pairs of offsets and lengths, in increasing order of offsets.
+  std::vector<size_t> ranges;
+
+  // Offset and length of each chunk to keep, in the original bitstream. Zero length means that
+  //    the chunk is not needed.
   std::vector<size_t> chunk_offsets;
+
+  // Header of the resulting partial bitstream.
+  vec8_type header;
 };
 
 class SPERR3D_Stream_Tools {
  public:
+  // Number of threads to read sections of a file. If 0 is passed in, the maximal number of
+  //    threads will be used. It's 1 by default.
+  void set_num_threads(size_t);
+
   // Read the first 20 bytes of a bitstream, and determine the total length of the header.
   // Need 20 bytes because it's the larger of the header magic number (in multi-chunk case).
   auto get_header_len(std::array<uint8_t, 20>) const -> size_t;
 
   // Read a bitstream that's at least as long as what's determined by `get_header_len()`, and
   // return an object of `SPERR3D_Stream_Header`.
+  // Note: if the bitstream keeps its chunk index in a footer (see
+  //    `SPERR3D_OMP_C::set_large_header()`), the returned `chunk_offsets` is empty. In that case,
+  //    fetch `index_len` bytes at `index_offset`, and pass them to `read_chunk_index()`.
   auto get_stream_header(const void*) const -> SPERR3D_Header;
+  void read_chunk_index(SPERR3D_Header&, const void* index_buf) const;
 
   // Function that reads in portions of a file only to facilitate progressive access.
   // (This function does not read the whole file.)
@@ -45,20 +81,78 @@ class SPERR3D_Stream_Tools {
   //  - multiple chunks: probably easier to just use the full bitstream length.
   auto progressive_truncate(const void* stream, size_t stream_len, unsigned pct) const -> vec8_type;
 
+  // Quality-targeted counterparts of the two functions above: instead of keeping the same
+  //    percentage of every chunk, they allocate bytes across chunks to equalize their
+  //    distortion-rate slopes, until the estimated PSNR reaches `psnr`, or the entire truncated
+  //    bitstream reaches `num_bytes` bytes. (Every chunk keeps at least its header, so a tiny
+  //    `num_bytes` might not be met.)
+  //    These functions need the rate-distortion tables recorded by the encoder (see
+  //    `SPERR3D_OMP_C::enable_rd_table()`), and return an empty vector if there are none.
+  auto read_to_psnr(const std::string& filename, double psnr) const -> vec8_type;
+  auto read_to_bytes(const std::string& filename, size_t num_bytes) const -> vec8_type;
+  auto truncate_to_psnr(const void* stream, size_t stream_len, double psnr) const -> vec8_type;
+  auto truncate_to_bytes(const void* stream, size_t stream_len, size_t num_bytes) const
+      -> vec8_type;
+
+  // Plan which byte ranges of a bitstream to fetch in order to decode a region of interest,
+  //    before fetching anything but its header (see `get_header_len()`, `get_stream_header()`).
+  //    `region` is specified as {x_start, x_len, y_start, y_len, z_start, z_len}. Chunks that
+  //    intersect with it are kept, truncated to `pct` percent just like `progressive_read()`.
+  //    Ranges less than `max_gap` bytes apart are merged into one, trading a few extra bytes
+  //    for fewer requests.
+  auto plan_ranges(const SPERR3D_Header& header,
+                   std::array<size_t, 6> region,
+                   unsigned pct,
+                   size_t max_gap = 0) const -> SPERR3D_Range_Plan;
+
+  // Assemble a valid partial bitstream from the ranges fetched following `plan`; `fetched`
+  //    holds all ranges concatenated in order. Chunks that are not needed are recorded as empty,
+  //    and `SPERR3D_OMP_D` decodes them as zeros.
+  auto assemble_ranges(const SPERR3D_Range_Plan& plan,
+                       const void* fetched,
+                       size_t fetched_len) const -> vec8_type;
+
  private:
+  size_t m_num_threads = 1;
   const size_t m_header_magic_nchunks = 20;
   const size_t m_header_magic_1chunk = 14;
+  const size_t m_header_magic_large = 68;
 
   // To simplify logic with progressive read, we set a minimum number of bytes to read from
   // a chunk, unless the chunk doesn't have that many bytes (e.g., a constant chunk).
   const size_t m_progressive_min_chunk_bytes = 64;
 
+  // Read and parse the header of a bitstream from a file, or from a bitstream in memory.
+  //    They also read the chunk index if it's in a footer. The file version returns an empty
+  //    vector upon failure, and the memory version returns a header without chunk offsets.
+  auto m_read_header(const std::string& filename) const -> std::tuple<vec8_type, SPERR3D_Header>;
+  auto m_parse_stream(const void* stream, size_t stream_len) const -> SPERR3D_Header;
+
   // Given the header of a bitstream and a desired percentage to truncate, return an
   //    updated header and a list of {offset, len} to access.
   //    Note: this function assumes that the header is complete.
   auto m_progressive_helper(const void* header_buf,
-                            size_t buf_len,
+                            SPERR3D_Header header,
                             unsigned pct) const -> std::tuple<vec8_type, std::vector<size_t>>;
+
+  // Same as `m_progressive_helper()`, but allocates bytes to chunks based on the rate-distortion
+  //    section `rd_buf`, until the estimated PSNR reaches `psnr` or the total length reaches
+  //    `num_bytes`, whichever happens first.
+  auto m_rd_helper(SPERR3D_Header header, const void* rd_buf, double psnr, size_t num_bytes) const
+      -> std::tuple<vec8_type, std::vector<size_t>>;
+  auto m_rd_read(const std::string& filename, double psnr, size_t num_bytes) const -> vec8_type;
+  auto m_rd_truncate(const void* stream, size_t stream_len, double psnr, size_t num_bytes) const
+      -> vec8_type;
+
+  // Decide how many bytes to keep of a chunk that has `orig_len` bytes, when keeping `pct` percent.
+  auto m_progressive_len(size_t orig_len, unsigned pct) const -> size_t;
+
+  // Create a header for a portion of the bitstream described by `header`, with chunk
+  //    lengths in `chunk_offsets` (in the format of `SPERR3D_Header::chunk_offsets`).
+  //    A large header keeps its chunk index inline.
+  auto m_portion_header(const SPERR3D_Header& header,
+                        const std::vector<size_t>& chunk_offsets) const -> vec8_type;
+  auto m_portion_header_len(const SPERR3D_Header& header) const -> size_t;
 };
 
 }  // End of namespace sperr
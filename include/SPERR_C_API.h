@@ -82,15 +82,80 @@ int sperr_decomp_2d(
 
 /*
  * Parse the header of a bitstream and extract various information. The bitstream can be produced
- * by sperr_comp_3d(), or by sperr_comp_2d() with the `out_inc_header` option on.
+ * by sperr_comp_3d(), sperr_comp_2d_batch(), or by sperr_comp_2d() with the `out_inc_header`
+ * option on. A 1D bitstream produced by SPERR1D_OMP_C is also recognized: `dimx` is its length,
+ * and `dimy` and `dimz` are 1.
  */
 void sperr_parse_header(
     const void* src, /* Input: a SPERR bitstream */
     size_t* dimx,    /* Output: X dimension length */
     size_t* dimy,    /* Output: Y dimension length */
-    size_t* dimz,    /* Output: Z dimension length (2D slices will have dimz == 1) */
+    size_t* dimz,    /* Output: Z dimension length (2D slices will have dimz == 1, and a batch of
+                                2D slices will have dimz == number of slices) */
     int* is_float);  /* Output: if the original input is in float (1) or double (0) precision */
 
+/*
+ * Compress a batch of same-sized 2D slices, for example, the levels of a 3D field that are to be
+ * compressed as 2D. Slices are stored one after another in `src`, and are compressed in parallel.
+ * The modes are the same as in sperr_comp_2d().
+ *
+ * The output bitstream always includes a header and a table locating each slice, so it can be
+ * decompressed as a whole using sperr_decomp_2d_batch(), or one slice at a time using
+ * sperr_decomp_2d_slice().
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ *  2: one or more parameters isn't valid.
+ * -1: other error
+ */
+int sperr_comp_2d_batch(
+    const void* src,   /* Input: buffer that contains `num_slices` 2D slices */
+    int is_float,      /* Input: input buffer type: 1 == float, 0 == double */
+    size_t dimx,       /* Input: X (fastest-varying) dimension of each slice */
+    size_t dimy,       /* Input: Y dimension of each slice */
+    size_t num_slices, /* Input: number of slices */
+    int mode,          /* Input: compression mode to use */
+    double quality,    /* Input: target quality */
+    size_t nthreads,   /* Input: number of OpenMP threads to use. 0 means using all threads. */
+    void** dst,        /* Output: buffer for the output bitstream, allocated by this function */
+    size_t* dst_len);  /* Output: length of `dst` in byte */
+
+/*
+ * Decompress all slices of a bitstream produced by sperr_comp_2d_batch().
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ * -1: other error
+ */
+int sperr_decomp_2d_batch(
+    const void* src,    /* Input: buffer that contains a compressed bitstream */
+    size_t src_len,     /* Input: length of the input bitstream in byte */
+    int output_float,   /* Input: output data type: 1 == float, 0 == double */
+    size_t nthreads,    /* Input: number of OMP threads to use. 0 means using all threads. */
+    size_t* dimx,       /* Output: X (fast-varying) dimension of each slice */
+    size_t* dimy,       /* Output: Y dimension of each slice */
+    size_t* num_slices, /* Output: number of slices */
+    void** dst);        /* Output: buffer for all output slices, allocated by this function */
+
+/*
+ * Decompress a single slice of a bitstream produced by sperr_comp_2d_batch().
+ *    The slice dimension can be learned from sperr_parse_header().
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ *  2: `idx` is out of range.
+ * -1: other error
+ */
+int sperr_decomp_2d_slice(
+    const void* src,  /* Input: buffer that contains a compressed bitstream */
+    size_t src_len,   /* Input: length of the input bitstream in byte */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t idx,       /* Input: index of the slice to decompress, starting from 0 */
+    void** dst);      /* Output: buffer for the output 2D slice, allocated by this function */
+
 /*
  * Compress a a 3D volume targetting different quality controls (modes):
  *   mode == 1 --> fixed bit-per-pixel (BPP)
@@ -155,6 +220,218 @@ int sperr_trunc_3d(
     void** dst,       /* Output: buffer for the truncated bitstream, allocated by this function */
     size_t* dst_len); /* Output: length of `dst` in byte */
 
+/*
+ * ----------------------------------------------------------------------------------------------
+ * Reusable contexts.
+ *
+ * The functions above create fresh compressor/decompressor objects and allocate a new output
+ * buffer on every call. When many same-sized inputs are processed (e.g., thousands of 2D slices
+ * in every time step), the caller can instead create a context once, and pass it to the
+ * `sperr_ctx_*` functions below. A context keeps the (de)compressor objects and their internal
+ * buffers alive across calls, and these functions write into buffers provided by the caller, so
+ * no memory allocation is needed per call once the context has warmed up.
+ *
+ * A context is not thread-safe: use one context per thread.
+ *
+ * On top of the return values described for their non-context counterparts, these functions
+ * also return 3 when the caller-provided `dst` is too small. In that case, the number of
+ * bytes needed is stored in `dst_len`.
+ * ----------------------------------------------------------------------------------------------
+ */
+typedef struct sperr_ctx sperr_ctx;
+
+/*
+ * Create a context, which needs to be free'd by `sperr_ctx_free()`.
+ * Returns NULL upon failure.
+ */
+sperr_ctx* sperr_ctx_create(void);
+
+/*
+ * Free a context created by `sperr_ctx_create()`. Passing in NULL is a no-op.
+ */
+void sperr_ctx_free(sperr_ctx* ctx);
+
+/*
+ * Query the size of a buffer that's big enough to hold the output of sperr_ctx_comp_2d() or
+ * sperr_ctx_comp_3d() with the same parameters.
+ *
+ *  - In fixed bitrate mode (mode == 1), the returned size is an upper bound.
+ *  - In PSNR and PWE modes (mode == 2, 3), the output size depends on the data. The returned size
+ *    is that of the uncompressed input in double precision plus headers, which is big enough for
+ *    any practical use. If it isn't, the compression function returns 3.
+ *
+ * Returns 0 if one or more parameters are not valid.
+ */
+size_t sperr_comp_2d_max_size(
+    size_t dimx,         /* Input: X (fastest-varying) dimension */
+    size_t dimy,         /* Input: Y (slowest-varying) dimension */
+    int mode,            /* Input: compression mode to use */
+    double quality,      /* Input: target quality */
+    int out_inc_header); /* Input: include a header in the output bitstream? */
+
+size_t sperr_comp_3d_max_size(
+    size_t dimx,    /* Input: X (fastest-varying) dimension */
+    size_t dimy,    /* Input: Y dimension */
+    size_t dimz,    /* Input: Z (slowest-varying) dimension */
+    size_t chunk_x, /* Input: preferred chunk dimension in X */
+    size_t chunk_y, /* Input: preferred chunk dimension in Y */
+    size_t chunk_z, /* Input: preferred chunk dimension in Z */
+    int mode,       /* Input: compression mode to use */
+    double quality); /* Input: target quality */
+
+/*
+ * Same as sperr_comp_2d(), but uses a context and writes to a buffer provided by the caller.
+ */
+int sperr_ctx_comp_2d(
+    sperr_ctx* ctx,     /* Input: a context created by sperr_ctx_create() */
+    const void* src,    /* Input: buffer that contains a 2D slice */
+    int is_float,       /* Input: input buffer type: 1 == float, 0 == double */
+    size_t dimx,        /* Input: X (fastest-varying) dimension */
+    size_t dimy,        /* Input: Y (slowest-varying) dimension */
+    int mode,           /* Input: compression mode to use */
+    double quality,     /* Input: target quality */
+    int out_inc_header, /* Input: include a header in the output bitstream? 1 == yes, 0 == no */
+    void* dst,          /* Output: buffer for the output bitstream, provided by the caller */
+    size_t dst_cap,     /* Input: capacity of `dst` in byte */
+    size_t* dst_len);   /* Output: length of the output bitstream in byte */
+
+/*
+ * Same as sperr_decomp_2d(), but uses a context and writes to a buffer provided by the caller.
+ * The buffer `dst` needs to hold (dimx x dimy) floats (or doubles).
+ */
+int sperr_ctx_decomp_2d(
+    sperr_ctx* ctx,   /* Input: a context created by sperr_ctx_create() */
+    const void* src,  /* Input: buffer that contains a compressed bitstream AND no header! */
+    size_t src_len,   /* Input: length of the input bitstream in byte */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t dimx,      /* Input: X (fast-varying) dimension */
+    size_t dimy,      /* Input: Y (slowest-varying) dimension */
+    void* dst);       /* Output: buffer for the output 2D slice, provided by the caller */
+
+/*
+ * Same as sperr_comp_3d(), but uses a context and writes to a buffer provided by the caller.
+ */
+int sperr_ctx_comp_3d(
+    sperr_ctx* ctx,   /* Input: a context created by sperr_ctx_create() */
+    const void* src,  /* Input: buffer that contains a 3D volume */
+    int is_float,     /* Input: input buffer type: 1 == float, 0 = double */
+    size_t dimx,      /* Input: X (fastest-varying) dimension */
+    size_t dimy,      /* Input: Y dimension */
+    size_t dimz,      /* Input: Z (slowest-varying) dimension */
+    size_t chunk_x,   /* Input: preferred chunk dimension in X */
+    size_t chunk_y,   /* Input: preferred chunk dimension in Y */
+    size_t chunk_z,   /* Input: preferred chunk dimension in Z */
+    int mode,         /* Input: compression mode to use */
+    double quality,   /* Input: target quality */
+    size_t nthreads,  /* Input: number of OpenMP threads to use. 0 means using all threads. */
+    void* dst,        /* Output: buffer for the output bitstream, provided by the caller */
+    size_t dst_cap,   /* Input: capacity of `dst` in byte */
+    size_t* dst_len); /* Output: length of the output bitstream in byte */
+
+/*
+ * Same as sperr_decomp_3d(), but uses a context and writes to a buffer provided by the caller.
+ * The volume dimensions can be learned beforehand using sperr_parse_header(). In case of return
+ * value 3, the volume dimensions are still filled.
+ */
+int sperr_ctx_decomp_3d(
+    sperr_ctx* ctx,   /* Input: a context created by sperr_ctx_create() */
+    const void* src,  /* Input: buffer that contains a compressed bitstream */
+    size_t src_len,   /* Input: length of the input bitstream in byte */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t nthreads,  /* Input: number of OMP threads to use. 0 means using all threads. */
+    size_t* dimx,     /* Output: X (fast-varying) dimension */
+    size_t* dimy,     /* Output: Y dimension */
+    size_t* dimz,     /* Output: Z (slowest-varying) dimension */
+    void* dst,        /* Output: buffer for the output 3D volume, provided by the caller */
+    size_t dst_cap,   /* Input: capacity of `dst` in byte */
+    size_t* dst_len); /* Output: length of the output volume in byte */
+
+/*
+ * ----------------------------------------------------------------------------------------------
+ * Containers.
+ *
+ * A container packs many 3D bitstreams, one for each (variable name, time step), into a single
+ * file together with an index, so that any region of any variable at any time step can be
+ * decompressed without scanning the file. See SPERR3D_Container.h for its format.
+ * ----------------------------------------------------------------------------------------------
+ */
+typedef struct sperr_container_writer sperr_container_writer;
+typedef struct sperr_container_reader sperr_container_reader;
+
+/*
+ * Create a container, or keep adding to an existing one when `append` is 1. The writer needs to
+ * be closed by `sperr_container_writer_close()`. Returns NULL upon failure.
+ */
+sperr_container_writer* sperr_container_writer_open(const char* filename, int append);
+
+/*
+ * Compress a 3D volume, and add it to a container as `name` at `timestep`. The compression
+ * parameters are the same as in sperr_comp_3d(). Multiple threads can call this function with
+ * the same writer at the same time.
+ *
+ * Return value meanings:
+ *  0: success
+ *  2: one or more parameters isn't valid, or `name` at `timestep` is already in the container.
+ * -1: other error
+ */
+int sperr_container_append_3d(
+    sperr_container_writer* writer, /* Input: a writer created by sperr_container_writer_open() */
+    const char* name,               /* Input: name of the variable */
+    size_t timestep,                /* Input: time step of the variable */
+    const void* src,                /* Input: buffer that contains a 3D volume */
+    int is_float,                   /* Input: input buffer type: 1 == float, 0 = double */
+    size_t dimx,                    /* Input: X (fastest-varying) dimension */
+    size_t dimy,                    /* Input: Y dimension */
+    size_t dimz,                    /* Input: Z (slowest-varying) dimension */
+    size_t chunk_x,                 /* Input: preferred chunk dimension in X */
+    size_t chunk_y,                 /* Input: preferred chunk dimension in Y */
+    size_t chunk_z,                 /* Input: preferred chunk dimension in Z */
+    int mode,                       /* Input: compression mode to use */
+    double quality,                 /* Input: target quality */
+    size_t nthreads); /* Input: number of OpenMP threads to use. 0 means using all threads. */
+
+/*
+ * Write the index of a container, close the file, and free the writer.
+ * Returns 0 upon success, and -1 otherwise. The writer is free'd in both cases.
+ */
+int sperr_container_writer_close(sperr_container_writer* writer);
+
+/*
+ * Open a container for reading, which needs to be closed by `sperr_container_reader_close()`.
+ * Returns NULL upon failure.
+ */
+sperr_container_reader* sperr_container_reader_open(const char* filename);
+
+/*
+ * Close a container opened by `sperr_container_reader_open()`. Passing in NULL is a no-op.
+ */
+void sperr_container_reader_close(sperr_container_reader* reader);
+
+/*
+ * Decompress a region of `name` at `timestep` in a container. Only the chunks that intersect
+ * with the region are read and decompressed. The output buffer `dst` contains
+ * (lenx x leny x lenz) floats (or doubles).
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ *  2: `name` at `timestep` isn't in the container, or the region isn't in the volume.
+ * -1: other error
+ */
+int sperr_container_decomp_3d(
+    const sperr_container_reader* reader, /* Input: a reader */
+    const char* name,                     /* Input: name of the variable */
+    size_t timestep,                      /* Input: time step of the variable */
+    size_t x0,                            /* Input: start of the region in X */
+    size_t y0,                            /* Input: start of the region in Y */
+    size_t z0,                            /* Input: start of the region in Z */
+    size_t lenx,                          /* Input: length of the region in X */
+    size_t leny,                          /* Input: length of the region in Y */
+    size_t lenz,                          /* Input: length of the region in Z */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t nthreads,  /* Input: number of OMP threads to use. 0 means using all threads. */
+    void** dst);      /* Output: buffer for the output region, allocated by this function */
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 } /* end of namespace C_API */
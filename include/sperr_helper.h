@@ -14,6 +14,8 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #ifndef USE_VANILLA_CONFIG
@@ -24,13 +26,107 @@ namespace sperr {
 
 using std::size_t;  // Seems most appropriate
 
+//
+// How big buffers (at least `huge_page_size` bytes) in `uninit_vec_type` get their memory:
+//    Default:   from the regular heap, in pages of the system's default size (usually 4 KiB).
+//    HugePages: from anonymous memory that's advised to be backed by transparent huge pages.
+//    HugeTLB:   from the pool of reserved 2 MiB huge pages (`MAP_HUGETLB`); it falls back to
+//               HugePages when the pool can't serve the request.
+// Huge pages reduce TLB misses of strided accesses, e.g., the Z passes of a wavelet transform.
+//    They're only available on Linux; elsewhere, all policies behave the same as Default.
+//
+enum class MemPolicy : unsigned char { Default, HugePages, HugeTLB };
+
+constexpr size_t huge_page_size = size_t{2} * 1024 * 1024;
+
+// Allocate and deallocate at least `bytes` bytes following a policy other than Default.
+//    The memory is aligned to `huge_page_size` on Linux, and isn't touched by these functions,
+//    so each page is placed on the NUMA node of the thread that writes it first.
+auto huge_page_alloc(size_t bytes, MemPolicy) -> void*;
+void huge_page_free(void* p, size_t bytes);
+
+//
+// An allocator that default-initializes, rather than value-initializes, new elements. With it,
+//    `resize(n)` and `vector(n)` of arithmetic types leave the new elements uninitialized instead
+//    of zeroing them. Big buffers that are overwritten right away then skip a full memory pass,
+//    and their pages are first touched by the (possibly parallel) code that writes them.
+//    A value is still honored when given, e.g., `resize(n, 0.0)`.
+//
+// It also carries a `MemPolicy`, which travels with the memory when a vector is moved, copy
+//    assigned, or swapped. E.g., `vecd_type(vecd_type::allocator_type(MemPolicy::HugePages))`
+//    is an empty vector whose big allocations use huge pages.
+//
+template <typename T>
+class default_init_allocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  default_init_allocator() = default;
+  explicit default_init_allocator(MemPolicy policy) noexcept : m_policy(policy) {}
+  template <typename U>
+  default_init_allocator(const default_init_allocator<U>& other) noexcept
+      : m_policy(other.policy())
+  {
+  }
+
+  auto policy() const noexcept -> MemPolicy { return m_policy; }
+
+  auto allocate(size_t n) -> T*
+  {
+    if (m_use_huge_pages(n))
+      return static_cast<T*>(huge_page_alloc(n * sizeof(T), m_policy));
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, size_t n) noexcept
+  {
+    if (m_use_huge_pages(n))
+      huge_page_free(p, n * sizeof(T));
+    else
+      std::allocator<T>().deallocate(p, n);
+  }
+
+  template <typename U>
+  void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>)
+  {
+    ::new (static_cast<void*>(p)) U;
+  }
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args)
+  {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  friend auto operator==(const default_init_allocator& a, const default_init_allocator& b) -> bool
+  {
+    return a.m_policy == b.m_policy;
+  }
+  friend auto operator!=(const default_init_allocator& a, const default_init_allocator& b) -> bool
+  {
+    return a.m_policy != b.m_policy;
+  }
+
+ private:
+  MemPolicy m_policy = MemPolicy::Default;
+
+  auto m_use_huge_pages(size_t n) const -> bool
+  {
+    return m_policy != MemPolicy::Default && n * sizeof(T) >= huge_page_size;
+  }
+};
+
 //
 // A few shortcuts
 //
 template <typename T>
 using vec_type = std::vector<T>;
-using vecd_type = vec_type<double>;
-using vecf_type = vec_type<float>;
+template <typename T>
+using uninit_vec_type = std::vector<T, default_init_allocator<T>>;
+using vecd_type = uninit_vec_type<double>;
+using vecf_type = uninit_vec_type<float>;
 using vec8_type = vec_type<uint8_t>;
 using dims_type = std::array<size_t, 3>;
 
@@ -63,6 +159,14 @@ enum class RTNType {
   Error
 };
 
+// A point on the rate-distortion curve of a bitstream: if the bitstream is truncated to `bytes`
+//    bytes, decoding it gives an estimated sum of squared errors (SSE) of `sse`.
+struct RD_Point {
+  size_t bytes = 0;
+  double sse = 0.0;
+};
+using rd_table_type = std::vector<RD_Point>;
+
 //
 // Helper functions
 //
@@ -141,9 +245,15 @@ auto read_whole_file(std::string filename) -> vec_type<T>;
 // Read sections of a file (extract sections from a memory buffer), and append those sections
 //    to the end of `dst`. The read from file version avoids reading not-requested sections.
 //    The sections are defined by pairs of offsets and lengths, both in number of bytes.
+//    On POSIX systems, the read from file version sorts sections by offset and coalesces the ones
+//    less than `gap_threshold` bytes apart, so that each run of sections is read with a single
+//    vectored read directly into `dst`. Runs are read using `num_threads` threads (0 means
+//    the maximum number of threads).
 auto read_sections(std::string filename,
                    const std::vector<size_t>& sections,
-                   vec8_type& dst) -> RTNType;
+                   vec8_type& dst,
+                   size_t num_threads = 1,
+                   size_t gap_threshold = 65536) -> RTNType;
 auto extract_sections(const void* buf,
                       size_t buf_len,
                       const std::vector<size_t>& sections,
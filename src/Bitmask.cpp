@@ -4,9 +4,39 @@
 #include <cassert>
 #include <limits>
 
+#if defined __AVX2__ || defined __AVX512F__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Position of the lowest true bit of a non-zero word.
+auto lowest_true(uint64_t word) -> size_t
+{
+  assert(word != 0);
 #if __cplusplus >= 202002L
-#include <bit>
+  return std::countr_zero(word);
+#else
+  size_t i = 0;
+  while (!((word >> i) & uint64_t{1}))
+    i++;
+  return i;
+#endif
+}
+
+auto popcount(uint64_t word) -> size_t
+{
+#if __cplusplus >= 202002L
+  return std::popcount(word);
+#else
+  size_t counter = 0;
+  for (; word != 0; word &= word - 1)
+    counter++;
+  return counter;
 #endif
+}
+
+}  // anonymous namespace
 
 sperr::Bitmask::Bitmask(size_t nbits)
 {
@@ -43,85 +73,16 @@ auto sperr::Bitmask::rbit(size_t idx) const -> bool
 
 auto sperr::Bitmask::has_true(size_t start, size_t len) const -> bool
 {
-  auto long_idx = start >> 6;
-  auto processed_bits = int64_t{0};
-  auto word = m_buf[long_idx];
-
-  // Collect the remaining bits from the start long.
-  auto begin_idx = start & 63;
-  auto nbits = std::min(size_t{64}, begin_idx + len);
-  for (auto i = begin_idx; i < nbits; i++) {
-    if (word & (uint64_t{1} << i))
-      return true;
-    processed_bits++;
-  }
-
-  // Examine the subsequent full longs.
-  while (processed_bits + 64 <= len) {
-    word = m_buf[++long_idx];
-    if (word) {
-      return true;
-    }
-    processed_bits += 64;
-  }
-
-  // Examine the remaining bits
-  if (processed_bits < len) {
-    nbits = len - processed_bits;
-    assert(nbits < 64);
-    word = m_buf[++long_idx];
-    for (int64_t i = 0; i < nbits; i++) {
-      if (word & (uint64_t{1} << i))
-        return true;
-    }
-  }
-
-  return false;
+  return m_find_true(start, start + len) < start + len;
 }
 
 auto sperr::Bitmask::find_true(size_t start, size_t len) const -> int64_t
 {
-  auto long_idx = start >> 6;
-  auto processed_bits = int64_t{0};
-  auto word = m_buf[long_idx];
-
-  // Collect the remaining bits from the start long.
-  auto begin_idx = start & 63;
-  auto nbits = std::min(size_t{64}, begin_idx + len);
-  for (auto i = begin_idx; i < nbits; i++) {
-    if (word & (uint64_t{1} << i))
-      return processed_bits;
-    processed_bits++;
-  }
-
-  // Examine the subsequent full longs.
-  while (processed_bits + 64 <= len) {
-    word = m_buf[++long_idx];
-    if (word) {
-#if __cplusplus >= 202002L
-      int64_t i = std::countr_zero(word);
-      return processed_bits + i;
-#else
-      for (int64_t i = 0; i < 64; i++)
-        if (word & (uint64_t{1} << i))
-          return processed_bits + i;
-#endif
-    }
-    processed_bits += 64;
-  }
-
-  // Examine the remaining bits
-  if (processed_bits < len) {
-    nbits = len - processed_bits;
-    assert(nbits < 64);
-    word = m_buf[++long_idx];
-    for (int64_t i = 0; i < nbits; i++) {
-      if (word & (uint64_t{1} << i))
-        return processed_bits + i;
-    }
-  }
-
-  return -1;
+  const auto pos = m_find_true(start, start + len);
+  if (pos < start + len)
+    return int64_t(pos - start);
+  else
+    return -1;
 }
 
 auto sperr::Bitmask::count_true() const -> size_t
@@ -131,26 +92,87 @@ auto sperr::Bitmask::count_true() const -> size_t
     return counter;
 
   // Note that unused bits in the last long are not guaranteed to be all 0's.
-  for (size_t i = 0; i < m_buf.size() - 1; i++) {
-    auto val = m_buf[i];
-#if __cplusplus >= 202002L
-    counter += std::popcount(val);
-#else
-    if (val != 0) {
-      for (size_t j = 0; j < 64; j++)
-        counter += ((val >> j) & uint64_t{1});
-    }
-#endif
-  }
-  const auto val = m_buf.back();
-  if (val != 0) {
-    for (size_t j = 0; j < m_num_bits - (m_buf.size() - 1) * 64; j++)
-      counter += ((val >> j) & uint64_t{1});
+  const auto* const p = m_buf.data();
+  const auto num_full = m_buf.size() - 1;
+  size_t i = 0;
+#if defined __AVX512VPOPCNTDQ__
+  auto sum = _mm512_setzero_si512();
+  for (; i + 8 <= num_full; i += 8)
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i)));
+  counter += _mm512_reduce_add_epi64(sum);
+#elif defined __AVX2__
+  // Count the bits of each byte by looking up its two nibbles, then sum the bytes of each long.
+  const auto lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,  // 16 nibbles
+                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const auto low4 = _mm256_set1_epi8(0x0f);
+  auto sum = _mm256_setzero_si256();
+  for (; i + 4 <= num_full; i += 4) {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    const auto lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low4));
+    const auto hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
   }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+  counter += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+  for (; i < num_full; i++)
+    counter += popcount(p[i]);
+
+  const auto tail_bits = m_num_bits - num_full * 64;
+  auto last = m_buf.back();
+  if (tail_bits < 64)
+    last &= (uint64_t{1} << tail_bits) - 1;
+  counter += popcount(last);
 
   return counter;
 }
 
+auto sperr::Bitmask::m_find_true(size_t begin, size_t end) const -> size_t
+{
+  if (begin >= end)
+    return end;
+
+  // Bits before `begin` in the first word, and bits from `end` on in the last word, are
+  //    masked off instead of tested one by one.
+  auto w = begin >> 6;
+  const auto last_w = (end - 1) >> 6;
+  auto word = m_buf[w] & (~uint64_t{0} << (begin & 63));
+  while (w < last_w) {
+    if (word != 0)
+      return (w << 6) + lowest_true(word);
+    w = m_skip_zero_words(w + 1, last_w);
+    word = m_buf[w];
+  }
+  if (end & 63)
+    word &= (uint64_t{1} << (end & 63)) - 1;
+  if (word != 0)
+    return (w << 6) + lowest_true(word);
+  else
+    return end;
+}
+
+auto sperr::Bitmask::m_skip_zero_words(size_t first, size_t last) const -> size_t
+{
+  const auto* const p = m_buf.data();
+#if defined __AVX512F__
+  for (; first + 8 <= last; first += 8) {
+    const auto v = _mm512_loadu_si512(p + first);
+    if (_mm512_test_epi64_mask(v, v))
+      break;
+  }
+#elif defined __AVX2__
+  for (; first + 4 <= last; first += 4) {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + first));
+    if (!_mm256_testz_si256(v, v))
+      break;
+  }
+#endif
+  while (first < last && p[first] == 0)
+    first++;
+  return first;
+}
+
 void sperr::Bitmask::wlong(size_t idx, uint64_t value)
 {
   m_buf[idx >> 6] = value;
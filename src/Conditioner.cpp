@@ -1,4 +1,4 @@
-#include <algorithm>  // std::all_of()
+#include <algorithm>  // std::min(), std::max()
 #include <cassert>
 #include <cmath>    // std::sqrt()
 #include <cstring>  // std::memcpy()
@@ -24,8 +24,12 @@ auto sperr::Conditioner::condition(vecd_type& buf, dims_type dims) -> condi_type
                                   false};  // [7]: is this a constant field?
 
   // Operation 1
+  //    Constant field detection and mean calculation are carried out in the same pass.
   //
-  if (std::all_of(buf.cbegin(), buf.cend(), [v0 = buf[0]](auto v) { return v == v0; })) {
+  m_adjust_strides(buf.size());
+  const auto [mean, is_const] = m_calc_mean_and_constant(buf);
+
+  if (is_const) {
     meta[m_constant_field_idx] = true;
     const double val = buf[0];
     const uint64_t nval = buf.size();
@@ -44,10 +48,9 @@ auto sperr::Conditioner::condition(vecd_type& buf, dims_type dims) -> condi_type
   }
 
   // Operation 2
+  //    Subtracting the mean also records the range of the resulting values.
   //
-  m_adjust_strides(buf.size());
-  const auto mean = m_calc_mean(buf);
-  std::for_each(buf.begin(), buf.end(), [mean](auto& v) { v -= mean; });
+  m_subtract_mean(buf, mean);
 
   // Assemble a header of the following info order:
   // meta   mean  (empty)
@@ -116,22 +119,54 @@ auto sperr::Conditioner::retrieve_q(condi_type header) const -> double
   return q;
 }
 
-auto sperr::Conditioner::m_calc_mean(const vecd_type& buf) -> double
+auto sperr::Conditioner::get_range() const -> std::array<double, 2>
+{
+  return m_range;
+}
+
+auto sperr::Conditioner::m_calc_mean_and_constant(const vecd_type& buf) -> std::tuple<double, bool>
 {
   assert(buf.size() % m_num_strides == 0);
 
   m_stride_buf.resize(m_num_strides);
   const size_t stride_size = buf.size() / m_num_strides;
+  const auto v0 = buf[0];
+  bool is_const = true;
 
+  // Note: the summation order is kept the same as `std::accumulate()` on each stride, so the
+  //    resulting mean is bit-for-bit identical to a separate summation pass.
   for (size_t s = 0; s < m_num_strides; s++) {
-    auto begin = buf.begin() + stride_size * s;
-    auto end = begin + stride_size;
-    m_stride_buf[s] = std::accumulate(begin, end, double{0.0}) / static_cast<double>(stride_size);
+    const auto* const begin = buf.data() + stride_size * s;
+    auto sum = double{0.0};
+    auto same = true;
+    for (size_t i = 0; i < stride_size; i++) {
+      sum += begin[i];
+      same &= (begin[i] == v0);
+    }
+    m_stride_buf[s] = sum / static_cast<double>(stride_size);
+    is_const &= same;
   }
 
   double sum = std::accumulate(m_stride_buf.begin(), m_stride_buf.end(), double{0.0});
 
-  return (sum / static_cast<double>(m_stride_buf.size()));
+  return {sum / static_cast<double>(m_stride_buf.size()), is_const};
+}
+
+void sperr::Conditioner::m_subtract_mean(vecd_type& buf, double mean)
+{
+  assert(!buf.empty());
+
+  auto* const p = buf.data();
+  auto minv = p[0] - mean;
+  auto maxv = minv;
+  for (size_t i = 0; i < buf.size(); i++) {
+    const auto v = p[i] - mean;
+    p[i] = v;
+    minv = std::min(minv, v);
+    maxv = std::max(maxv, v);
+  }
+
+  m_range = {minv, maxv};
 }
 
 void sperr::Conditioner::m_adjust_strides(size_t len)
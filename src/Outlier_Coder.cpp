@@ -33,6 +33,16 @@ auto sperr::Outlier_Coder::view_outlier_list() const -> const std::vector<Outlie
   return m_LOS;
 }
 
+auto sperr::Outlier_Coder::release_outlier_list() -> std::vector<Outlier>&&
+{
+  return std::move(m_LOS);
+}
+
+auto sperr::Outlier_Coder::encoded_bitstream_len() const -> size_t
+{
+  return std::visit([](auto&& enc) { return enc.encoded_bitstream_len(); }, m_encoder);
+}
+
 void sperr::Outlier_Coder::append_encoded_bitstream(vec8_type& buf) const
 {
   // Just append the bitstream produced by `m_encoder` is fine.
@@ -127,6 +137,11 @@ auto sperr::Outlier_Coder::encode() -> RTNType
 
   std::visit([](auto&& enc) { enc.encode(); }, m_encoder);
 
+  // Take back the integer correctors and signs from the encoder, so the next encoding reuses
+  //    their memory instead of allocating it again.
+  std::visit([&vec = m_vals_ui](auto&& enc) { vec = enc.release_coeffs(); }, m_encoder);
+  m_sign_array = std::visit([](auto&& enc) { return enc.release_signs(); }, m_encoder);
+
   return RTNType::Good;
 }
 
@@ -0,0 +1,87 @@
+#include "Profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>  // std::plus
+#include <iterator>    // std::size()
+
+namespace {
+
+constexpr const char* stage_names[] = {"condition", "dwt",        "q_estimate", "quantize",
+                                       "sorting",   "refinement", "outlier",    "gather_scatter"};
+static_assert(std::size(stage_names) == size_t(sperr::Stage::Count));
+
+// Add `src` to `dst` element-wise, growing `dst` if needed.
+void add_counters(std::vector<uint64_t>& dst, const std::vector<uint64_t>& src)
+{
+  if (dst.size() < src.size())
+    dst.resize(src.size(), 0);
+  std::transform(src.cbegin(), src.cend(), dst.cbegin(), dst.begin(), std::plus<uint64_t>());
+}
+
+void append_array(std::string& json, const char* name, const std::vector<uint64_t>& vals)
+{
+  json += ", \"";
+  json += name;
+  json += "\": [";
+  for (size_t i = 0; i < vals.size(); i++) {
+    if (i > 0)
+      json += ", ";
+    json += std::to_string(vals[i]);
+  }
+  json += "]";
+}
+
+}  // anonymous namespace
+
+void sperr::Profile::merge(const Profile& other)
+{
+  std::transform(other.seconds.cbegin(), other.seconds.cend(), seconds.cbegin(), seconds.begin(),
+                 std::plus<double>());
+  add_counters(sorting_bits, other.sorting_bits);
+  add_counters(refinement_bits, other.refinement_bits);
+  add_counters(lis_sizes, other.lis_sizes);
+  add_counters(significant, other.significant);
+  bytes_allocated += other.bytes_allocated;
+  bytes_reused += other.bytes_reused;
+  num_chunks += other.num_chunks;
+}
+
+auto sperr::Profile::to_json() const -> std::string
+{
+  auto json = std::string("{\"seconds\": {");
+  char buf[64];
+  for (size_t i = 0; i < seconds.size(); i++) {
+    std::snprintf(buf, sizeof(buf), "%s\"%s\": %.6f", (i > 0 ? ", " : ""), stage_names[i],
+                  seconds[i]);
+    json += buf;
+  }
+  json += "}";
+  append_array(json, "sorting_bits", sorting_bits);
+  append_array(json, "refinement_bits", refinement_bits);
+  append_array(json, "lis_sizes", lis_sizes);
+  append_array(json, "significant", significant);
+  json += ", \"bytes_allocated\": " + std::to_string(bytes_allocated);
+  json += ", \"bytes_reused\": " + std::to_string(bytes_reused);
+  json += ", \"num_chunks\": " + std::to_string(num_chunks) + "}";
+
+  return json;
+}
+
+auto sperr::profile_report_json(const std::vector<Profile>& chunks) -> std::string
+{
+  auto total = Profile();
+  for (const auto& p : chunks)
+    total.merge(p);
+
+  auto json = "{\"profiling\": " + std::string(profiling ? "true" : "false");
+  json += ", \"total\": " + total.to_json() + ", \"chunks\": [";
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (i > 0)
+      json += ", ";
+    json += chunks[i].to_json();
+  }
+  json += "]}\n";
+
+  return json;
+}
@@ -31,6 +31,9 @@ void sperr::SPECK1D_INT<T>::m_initialize_lists()
   auto sets = m_partition_set(set);
   m_LIS[sets[0].get_level()].emplace_back(sets[0]);
   m_LIS[sets[1].get_level()].emplace_back(sets[1]);
+
+  // Encoder and decoder might have different additional tasks.
+  m_additional_initialization();
 }
 
 template <typename T>
@@ -55,6 +58,24 @@ auto sperr::SPECK1D_INT<T>::m_partition_set(Set1D set) const -> std::array<Set1D
   return subsets;
 }
 
+template <typename T>
+void sperr::SPECK1D_INT<T>::m_save_lists()
+{
+  m_ckpt_LIS = m_LIS;  // Copy assignment reuses memory already allocated by `m_ckpt_LIS`.
+}
+
+template <typename T>
+void sperr::SPECK1D_INT<T>::m_restore_lists()
+{
+  m_LIS = m_ckpt_LIS;
+}
+
+template <typename T>
+auto sperr::SPECK1D_INT<T>::m_LIS_stats() const -> std::array<size_t, 2>
+{
+  return lis_stats(m_LIS);
+}
+
 template class sperr::SPECK1D_INT<uint64_t>;
 template class sperr::SPECK1D_INT<uint32_t>;
 template class sperr::SPECK1D_INT<uint16_t>;
@@ -5,42 +5,14 @@
 #include <cstring>  // std::memcpy()
 #include <numeric>
 
-#if __cplusplus >= 202002L
-#include <bit>
-#endif
-
 template <typename T>
 void sperr::SPECK1D_INT_ENC<T>::m_sorting_pass()
 {
   // Since we have a separate representation of LIP, let's process that list first!
   //
-  const auto bits_x64 = m_LIP_mask.size() - m_LIP_mask.size() % 64;
-
-  for (size_t i = 0; i < bits_x64; i += 64) {
-    auto value = m_LIP_mask.rlong(i);
-
-#if __cplusplus >= 202002L
-    while (value) {
-      size_t j = std::countr_zero(value);
-      m_process_P(i + j, SigType::Dunno, j, true);
-      value &= value - 1;
-    }
-#else
-    if (value != 0) {
-      for (size_t j = 0; j < 64; j++) {
-        if ((value >> j) & uint64_t{1}) {
-          size_t dummy = 0;
-          m_process_P(i + j, SigType::Dunno, dummy, true);
-        }
-      }
-    }
-#endif
-  }
-  for (auto i = bits_x64; i < m_LIP_mask.size(); i++) {
-    if (m_LIP_mask.rbit(i)) {
-      size_t dummy = 0;
-      m_process_P(i, SigType::Dunno, dummy, true);
-    }
+  for (auto i : m_LIP_mask.true_bits()) {
+    size_t dummy = 0;
+    m_process_P(i, SigType::Dunno, dummy, true);
   }
 
   // Then we process regular sets in LIS.
@@ -167,13 +139,98 @@ auto sperr::SPECK1D_INT_ENC<T>::m_decide_significance(const Set1D& set) const
   assert(set.get_length() != 0);
 
   const auto gtr = [thld = m_threshold](auto v) { return v >= thld; };
-  auto first = m_coeff_buf.cbegin() + set.get_start();
-  auto last = first + set.get_length();
-  auto found = std::find_if(first, last, gtr);
-  if (found != last)
-    return static_cast<size_t>(std::distance(first, found));
-  else
-    return {};
+  const auto start = set.get_start();
+  const auto end = start + set.get_length();
+  auto first = m_coeff_buf.cbegin() + start;
+  auto last = m_coeff_buf.cbegin() + end;
+
+  // Short sets are faster to scan directly.
+  if (set.get_length() < 2 * m_block_len) {
+    auto found = std::find_if(first, last, gtr);
+    if (found != last)
+      return static_cast<size_t>(std::distance(first, found));
+    else
+      return {};
+  }
+
+  // Long sets: scan the partial block at the front, then use the tree to locate the first
+  //    significant block, and finally scan the partial block at the end.
+  const auto block_first = (start + m_block_len - 1) / m_block_len;
+  const auto block_last = end / m_block_len;
+  auto scan = [&](size_t a, size_t b) -> std::optional<size_t> {
+    auto it = std::find_if(m_coeff_buf.cbegin() + a, m_coeff_buf.cbegin() + b, gtr);
+    if (it != m_coeff_buf.cbegin() + b)
+      return static_cast<size_t>(std::distance(first, it));
+    else
+      return {};
+  };
+
+  auto found = scan(start, block_first * m_block_len);
+  if (found)
+    return found;
+  const auto block = m_find_block(block_first, block_last);
+  if (block < block_last) {
+    found = scan(block * m_block_len, (block + 1) * m_block_len);
+    assert(found);
+    return found;
+  }
+  return scan(block_last * m_block_len, end);
+}
+
+template <typename T>
+auto sperr::SPECK1D_INT_ENC<T>::m_find_block(size_t first, size_t last) const -> size_t
+{
+  // Collect the nodes that exactly cover [first, last). Nodes on the left side are found in
+  //    order from left to right, and nodes on the right side in the reverse order.
+  auto left = std::array<size_t, 64>();
+  auto right = std::array<size_t, 64>();
+  size_t num_left = 0, num_right = 0;
+  for (auto l = first + m_tree_leaves, r = last + m_tree_leaves; l < r; l /= 2, r /= 2) {
+    if (l % 2)
+      left[num_left++] = l++;
+    if (r % 2)
+      right[num_right++] = --r;
+  }
+
+  // Descend from the first node that has a significant coefficient to its leftmost such leaf.
+  auto descend = [&tree = m_tree, leaves = m_tree_leaves, thld = m_msb_threshold](size_t node) {
+    while (node < leaves)
+      node = (tree[2 * node] >= thld) ? 2 * node : 2 * node + 1;
+    return node - leaves;
+  };
+  for (size_t i = 0; i < num_left; i++) {
+    if (m_tree[left[i]] >= m_msb_threshold)
+      return descend(left[i]);
+  }
+  for (size_t i = num_right; i > 0; i--) {
+    if (m_tree[right[i - 1]] >= m_msb_threshold)
+      return descend(right[i - 1]);
+  }
+  return last;
+}
+
+template <typename T>
+void sperr::SPECK1D_INT_ENC<T>::m_additional_initialization()
+{
+  const auto num_blocks = (m_coeff_buf.size() + m_block_len - 1) / m_block_len;
+  m_tree_leaves = 1;
+  while (m_tree_leaves < num_blocks)
+    m_tree_leaves *= 2;
+  m_tree.assign(2 * m_tree_leaves, -1);
+
+  for (size_t b = 0; b < num_blocks; b++) {
+    auto first = m_coeff_buf.cbegin() + b * m_block_len;
+    auto last = m_coeff_buf.cbegin() + std::min((b + 1) * m_block_len, m_coeff_buf.size());
+    m_tree[m_tree_leaves + b] = sperr::msb_position(*std::max_element(first, last));
+  }
+  for (auto i = m_tree_leaves - 1; i > 0; i--)
+    m_tree[i] = std::max(m_tree[2 * i], m_tree[2 * i + 1]);
+}
+
+template <typename T>
+void sperr::SPECK1D_INT_ENC<T>::m_bitplane_init()
+{
+  m_msb_threshold = sperr::msb_position(m_threshold);
 }
 
 template class sperr::SPECK1D_INT_ENC<uint64_t>;
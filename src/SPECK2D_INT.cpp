@@ -1,44 +1,18 @@
 #include "SPECK2D_INT.h"
+#include "SPECK2D_INT_DEC.h"
+#include "SPECK2D_INT_ENC.h"
 
 #include <algorithm>
 #include <cassert>
 
-#if __cplusplus >= 202002L
-#include <bit>
-#endif
-
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_sorting_pass()
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_sorting_pass()
 {
   // First, process all insignificant pixels.
   //
-  const auto bits_x64 = m_LIP_mask.size() - m_LIP_mask.size() % 64;
-
-  for (size_t i = 0; i < bits_x64; i += 64) {
-    auto value = m_LIP_mask.rlong(i);
-
-#if __cplusplus >= 202002L
-    while (value) {
-      size_t j = std::countr_zero(value);
-      m_process_P(i + j, j, true);
-      value &= value - 1;
-    }
-#else
-    if (value != 0) {
-      for (size_t j = 0; j < 64; j++) {
-        if ((value >> j) & uint64_t{1}) {
-          size_t dummy = 0;
-          m_process_P(i + j, dummy, true);
-        }
-      }
-    }
-#endif
-  }
-  for (auto i = bits_x64; i < m_LIP_mask.size(); i++) {
-    if (m_LIP_mask.rbit(i)) {
-      size_t dummy = 0;
-      m_process_P(i, dummy, true);
-    }
+  for (auto i : m_LIP_mask.true_bits()) {
+    size_t dummy = 0;
+    m_derived().m_process_P(i, dummy, true);
   }
 
   // Second, process all TypeS sets.
@@ -47,17 +21,17 @@ void sperr::SPECK2D_INT<T>::m_sorting_pass()
     auto idx1 = m_LIS.size() - tmp;
     for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
       size_t dummy = 0;
-      m_process_S(idx1, idx2, dummy, true);
+      m_derived().m_process_S(idx1, idx2, dummy, true);
     }
   }
 
   // Third, process the sole TypeI set.
   //
-  m_process_I(true);
+  m_derived().m_process_I(true);
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_code_S(size_t idx1, size_t idx2)
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_code_S(size_t idx1, size_t idx2)
 {
   auto set = m_LIS[idx1][idx2];
   auto subsets = m_partition_S(set);
@@ -70,18 +44,18 @@ void sperr::SPECK2D_INT<T>::m_code_S(size_t idx1, size_t idx2)
     if (it->is_pixel()) {
       auto pixel_idx = it->start_y * m_dims[0] + it->start_x;
       m_LIP_mask.wtrue(pixel_idx);
-      m_process_P(pixel_idx, counter, need_decide);
+      m_derived().m_process_P(pixel_idx, counter, need_decide);
     }
     else {
       auto newidx1 = it->part_level;
       m_LIS[newidx1].push_back(*it);
-      m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, need_decide);
+      m_derived().m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, need_decide);
     }
   }
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_code_I()
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_code_I()
 {
   auto subsets = m_partition_I();
 
@@ -90,14 +64,14 @@ void sperr::SPECK2D_INT<T>::m_code_I()
     if (!set.is_empty()) {
       auto newidx1 = set.part_level;
       m_LIS[newidx1].push_back(set);
-      m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, true);
+      m_derived().m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, true);
     }
   }
-  m_process_I(counter != 0);
+  m_derived().m_process_I(counter != 0);
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_clean_LIS()
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_clean_LIS()
 {
   for (auto& list : m_LIS) {
     auto it = std::remove_if(list.begin(), list.end(), [](auto& s) { return s.is_empty(); });
@@ -105,8 +79,8 @@ void sperr::SPECK2D_INT<T>::m_clean_LIS()
   }
 }
 
-template <typename T>
-auto sperr::SPECK2D_INT<T>::m_partition_S(Set2D set) const -> std::array<Set2D, 4>
+template <typename T, class Derived>
+auto sperr::SPECK2D_INT<T, Derived>::m_partition_S(Set2D set) const -> std::array<Set2D, 4>
 {
   auto subsets = std::array<Set2D, 4>();
 
@@ -144,11 +118,17 @@ auto sperr::SPECK2D_INT<T>::m_partition_S(Set2D set) const -> std::array<Set2D,
   TL.length_y = approx_len_y;
   TL.part_level = set.part_level + 1;
 
+  if (!m_tree_child.empty() && m_tree_child[set.node] != 0) {
+    const auto first = m_tree_child[set.node];
+    for (uint32_t i = 0; i < 4; i++)
+      subsets[i].node = first + i;
+  }
+
   return subsets;
 }
 
-template <typename T>
-auto sperr::SPECK2D_INT<T>::m_partition_I() -> std::array<Set2D, 3>
+template <typename T, class Derived>
+auto sperr::SPECK2D_INT<T, Derived>::m_partition_I() -> std::array<Set2D, 3>
 {
   auto subsets = std::array<Set2D, 3>();
   auto [approx_len_x, detail_len_x] = sperr::calc_approx_detail_len(m_dims[0], m_I.part_level);
@@ -176,6 +156,14 @@ auto sperr::SPECK2D_INT<T>::m_partition_I() -> std::array<Set2D, 3>
   BL.length_y = detail_len_y;
   BL.part_level = m_I.part_level;
 
+  // The fourth child of an I set in the quadtree is the I set of the next level.
+  if (!m_tree_child.empty()) {
+    const auto first = m_tree_child[m_I.node];
+    for (uint32_t i = 0; i < 3; i++)
+      subsets[i].node = first + i;
+    m_I.node = first + 3;
+  }
+
   // Also update m_I
   m_I.start_x += detail_len_x;
   m_I.start_y += detail_len_y;
@@ -184,8 +172,8 @@ auto sperr::SPECK2D_INT<T>::m_partition_I() -> std::array<Set2D, 3>
   return subsets;
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_initialize_lists()
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_initialize_lists()
 {
   // prepare m_LIS
   auto num_of_parts = sperr::num_of_partitions(std::max(m_dims[0], m_dims[1])) + 1ul;
@@ -214,10 +202,34 @@ void sperr::SPECK2D_INT<T>::m_initialize_lists()
   m_I.part_level = num_of_xforms;
 
   // Encoder and decoder might have different additional tasks.
-  m_additional_initialization();
+  m_derived().m_additional_initialization();
+}
+
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_save_lists()
+{
+  m_ckpt_LIS = m_LIS;  // Copy assignment reuses memory already allocated by `m_ckpt_LIS`.
+  m_ckpt_I = m_I;
+}
+
+template <typename T, class Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_restore_lists()
+{
+  m_LIS = m_ckpt_LIS;
+  m_I = m_ckpt_I;
+}
+
+template <typename T, class Derived>
+auto sperr::SPECK2D_INT<T, Derived>::m_LIS_stats() const -> std::array<size_t, 2>
+{
+  return lis_stats(m_LIS);
 }
 
-template class sperr::SPECK2D_INT<uint8_t>;
-template class sperr::SPECK2D_INT<uint16_t>;
-template class sperr::SPECK2D_INT<uint32_t>;
-template class sperr::SPECK2D_INT<uint64_t>;
+template class sperr::SPECK2D_INT<uint64_t, sperr::SPECK2D_INT_ENC<uint64_t>>;
+template class sperr::SPECK2D_INT<uint32_t, sperr::SPECK2D_INT_ENC<uint32_t>>;
+template class sperr::SPECK2D_INT<uint16_t, sperr::SPECK2D_INT_ENC<uint16_t>>;
+template class sperr::SPECK2D_INT<uint8_t, sperr::SPECK2D_INT_ENC<uint8_t>>;
+template class sperr::SPECK2D_INT<uint64_t, sperr::SPECK2D_INT_DEC<uint64_t>>;
+template class sperr::SPECK2D_INT<uint32_t, sperr::SPECK2D_INT_DEC<uint32_t>>;
+template class sperr::SPECK2D_INT<uint16_t, sperr::SPECK2D_INT_DEC<uint16_t>>;
+template class sperr::SPECK2D_INT<uint8_t, sperr::SPECK2D_INT_DEC<uint8_t>>;
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
 #include <numeric>
 
 template <typename T>
@@ -64,6 +65,10 @@ auto sperr::SPECK2D_INT_ENC<T>::m_decide_S_significance(const Set2D& set) const
 {
   assert(!set.is_empty());
 
+  if (set.node != 0)
+    return m_tree_max[set.node] >= m_msb_threshold;
+
+  // Small sets that aren't part of the quadtree.
   for (auto y = set.start_y; y < (set.start_y + set.length_y); y++) {
     auto first = m_msb_buf.cbegin() + y * m_dims[0] + set.start_x;
     if (std::any_of(first, first + set.length_x,
@@ -76,24 +81,87 @@ auto sperr::SPECK2D_INT_ENC<T>::m_decide_S_significance(const Set2D& set) const
 template <typename T>
 auto sperr::SPECK2D_INT_ENC<T>::m_decide_I_significance() const -> bool
 {
-  // First, test the bottom rectangle.
-  // It's stored in a contiguous chunk of memory till the buffer end.
-  //
-  assert(m_I.length_x == m_dims[0]);
-  auto first = m_msb_buf.cbegin() + size_t{m_I.start_y} * size_t{m_I.length_x};
-  auto len = m_msb_buf.size() - size_t{m_I.start_y} * size_t{m_I.length_x};
-  if (std::any_of(first, first + len, [thld = m_msb_threshold](auto v) { return v >= thld; }))
-    return true;
-
-  // Second, test the rectangle that's directly to the right of the missing top-left corner.
-  //
-  len = m_dims[0] - m_I.start_x;
-  for (auto y = 0u; y < m_I.start_y; y++) {
-    first = m_msb_buf.cbegin() + y * m_dims[0] + m_I.start_x;
-    if (std::any_of(first, first + len, [thld = m_msb_threshold](auto v) { return v >= thld; }))
-      return true;
+  assert(m_I.node != 0);
+  return m_tree_max[m_I.node] >= m_msb_threshold;
+}
+
+template <typename T>
+auto sperr::SPECK2D_INT_ENC<T>::m_new_nodes(size_t num) -> uint32_t
+{
+  const auto first = m_tree_max.size();
+  assert(first + num <= std::numeric_limits<uint32_t>::max());
+  m_tree_max.resize(first + num, -1);
+  m_tree_child.resize(first + num, 0);
+  return static_cast<uint32_t>(first);
+}
+
+template <typename T>
+auto sperr::SPECK2D_INT_ENC<T>::m_scan_max(const Set2D& set) const -> int8_t
+{
+  auto max = int8_t{-1};
+  for (auto y = set.start_y; y < (set.start_y + set.length_y); y++) {
+    auto first = m_msb_buf.cbegin() + y * m_dims[0] + set.start_x;
+    max = std::max(max, *std::max_element(first, first + set.length_x));
   }
-  return false;
+  return max;
+}
+
+template <typename T>
+auto sperr::SPECK2D_INT_ENC<T>::m_build_node(const Set2D& set) -> int8_t
+{
+  assert(set.node != 0);
+  assert(!set.is_empty());
+
+  auto max = int8_t{-1};
+  if (size_t{set.length_x} * set.length_y <= m_tree_leaf_size)
+    max = m_scan_max(set);
+  else {
+    m_tree_child[set.node] = m_new_nodes(4);
+    for (const auto& sub : m_partition_S(set)) {
+      if (!sub.is_empty())
+        max = std::max(max, m_build_node(sub));
+    }
+  }
+  m_tree_max[set.node] = max;
+  return max;
+}
+
+template <typename T>
+void sperr::SPECK2D_INT_ENC<T>::m_build_tree()
+{
+  m_tree_max.clear();
+  m_tree_child.clear();
+  m_new_nodes(1);  // Node 0 stands for sets that aren't part of the tree.
+
+  // The root S set, which is the only set in the LIS right now.
+  for (auto& list : m_LIS) {
+    for (auto& set : list) {
+      set.node = m_new_nodes(1);
+      m_build_node(set);
+    }
+  }
+
+  // The I set of each level has four children: the three subsets partitioned from it, and the
+  //    I set of the next level. Walk down the levels on a copy of `m_I`, then fill in the maxima
+  //    of I sets from the smallest one up.
+  const auto orig_I = m_I;
+  m_I.node = m_new_nodes(1);
+  const auto top_node = m_I.node;
+  auto I_nodes = std::vector<uint32_t>();
+  while (m_I.part_level > 0) {
+    I_nodes.push_back(m_I.node);
+    m_tree_child[m_I.node] = m_new_nodes(4);
+    for (const auto& sub : m_partition_I()) {
+      if (!sub.is_empty())
+        m_build_node(sub);
+    }
+  }
+  for (auto it = I_nodes.crbegin(); it != I_nodes.crend(); ++it) {
+    auto first = m_tree_max.cbegin() + m_tree_child[*it];
+    m_tree_max[*it] = *std::max_element(first, first + 4);
+  }
+  m_I = orig_I;
+  m_I.node = top_node;
 }
 
 template <typename T>
@@ -103,6 +171,7 @@ void sperr::SPECK2D_INT_ENC<T>::m_additional_initialization()
   m_msb_buf.resize(len);
   std::transform(m_coeff_buf.cbegin(), m_coeff_buf.cend(), m_msb_buf.begin(),
                  [](auto v) { return sperr::msb_position(v); });
+  m_build_tree();
 }
 
 template <typename T>
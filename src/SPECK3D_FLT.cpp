@@ -2,45 +2,51 @@
 #include "SPECK3D_INT_DEC.h"
 #include "SPECK3D_INT_ENC.h"
 
+#include <algorithm>
+
+auto sperr::SPECK3D_FLT::m_use_wide_sets() const -> bool
+{
+  return std::any_of(m_dims.cbegin(), m_dims.cend(),
+                     [](auto d) { return d > SPECK3D_INT_ENC<uint8_t>::max_dim; });
+}
+
 void sperr::SPECK3D_FLT::m_instantiate_encoder()
 {
-  switch (m_uint_flag) {
-    case UINTType::UINT8:
-      if (m_encoder.index() != 0 || std::get<0>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint8_t>>();
-      break;
-    case UINTType::UINT16:
-      if (m_encoder.index() != 1 || std::get<1>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint16_t>>();
-      break;
-    case UINTType::UINT32:
-      if (m_encoder.index() != 2 || std::get<2>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint32_t>>();
-      break;
-    default:
-      if (m_encoder.index() != 3 || std::get<3>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint64_t>>();
+  // Coders of all integer lengths use the same kind of sets, so switching between narrow and
+  //    wide sets discards all of them.
+  const auto wide = m_use_wide_sets();
+  if (wide != m_wide_encoder)
+    m_encoder = {};
+  m_wide_encoder = wide;
+
+  if (wide) {
+    m_instantiate_coder(m_encoder, [](auto zero) {
+      return std::make_unique<SPECK3D_INT_ENC<decltype(zero), uint32_t>>();
+    });
+  }
+  else {
+    m_instantiate_coder(m_encoder, [](auto zero) {
+      return std::make_unique<SPECK3D_INT_ENC<decltype(zero), uint16_t>>();
+    });
   }
 }
 
 void sperr::SPECK3D_FLT::m_instantiate_decoder()
 {
-  switch (m_uint_flag) {
-    case UINTType::UINT8:
-      if (m_decoder.index() != 0 || std::get<0>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint8_t>>();
-      break;
-    case UINTType::UINT16:
-      if (m_decoder.index() != 1 || std::get<1>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint16_t>>();
-      break;
-    case UINTType::UINT32:
-      if (m_decoder.index() != 2 || std::get<2>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint32_t>>();
-      break;
-    default:
-      if (m_decoder.index() != 3 || std::get<3>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint64_t>>();
+  const auto wide = m_use_wide_sets();
+  if (wide != m_wide_decoder)
+    m_decoder = {};
+  m_wide_decoder = wide;
+
+  if (wide) {
+    m_instantiate_coder(m_decoder, [](auto zero) {
+      return std::make_unique<SPECK3D_INT_DEC<decltype(zero), uint32_t>>();
+    });
+  }
+  else {
+    m_instantiate_coder(m_decoder, [](auto zero) {
+      return std::make_unique<SPECK3D_INT_DEC<decltype(zero), uint16_t>>();
+    });
   }
 }
 
@@ -1,16 +1,33 @@
 #include "SPECK3D_INT.h"
+#include "SPECK3D_INT_DEC.h"
+#include "SPECK3D_INT_ENC.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <numeric>
 
-#if __cplusplus >= 202002L
-#include <bit>
-#endif
+namespace {
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_clean_LIS()
+// Initial LIS of each coordinate type, shared by all encoders and decoders.
+template <typename C>
+auto initial_LIS_cache() -> sperr::Shape_Cache<std::vector<std::vector<sperr::Set3D<C>>>>&
+{
+  static sperr::Shape_Cache<std::vector<std::vector<sperr::Set3D<C>>>> cache;
+  return cache;
+}
+
+}  // anonymous namespace
+
+void sperr::release_shape_caches()
+{
+  initial_LIS_cache<uint16_t>().clear();
+  initial_LIS_cache<uint32_t>().clear();
+  morton_perm_cache().clear();
+}
+
+template <typename T, typename C, class Derived>
+void sperr::SPECK3D_INT<T, C, Derived>::m_clean_LIS()
 {
   for (auto& list : m_LIS) {
     auto it =
@@ -19,27 +36,52 @@ void sperr::SPECK3D_INT<T>::m_clean_LIS()
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_initialize_lists()
+template <typename T, typename C, class Derived>
+void sperr::SPECK3D_INT<T, C, Derived>::m_initialize_lists()
+{
+  const auto side = m_dims[0];
+  m_pow2_cube = side > 1 && (side & (side - 1)) == 0 && m_dims[1] == side && m_dims[2] == side;
+
+  // Initialize LIS from a copy of the cached initial LIS. Copy assignment reuses memory already
+  //    allocated by `m_LIS`.
+  auto lis_bytes = [](const lis_type& lis) {
+    auto bytes = lis.capacity() * sizeof(typename lis_type::value_type);
+    for (const auto& list : lis)
+      bytes += list.capacity() * sizeof(set_type);
+    return bytes;
+  };
+  const auto initial =
+      initial_LIS_cache<C>().get(m_dims, [this] { return m_make_initial_LIS(); }, lis_bytes);
+  if (m_LIS.size() < initial->size())
+    m_LIS.resize(initial->size());
+  for (size_t i = 0; i < m_LIS.size(); i++) {
+    if (i < initial->size())
+      m_LIS[i] = (*initial)[i];
+    else
+      m_LIS[i].clear();
+  }
+
+  // Encoder and decoder might have different additional tasks.
+  m_derived().m_additional_initialization();
+}
+
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_make_initial_LIS() const -> lis_type
 {
   std::array<size_t, 3> num_of_parts;  // how many times each dimension could be partitioned?
   num_of_parts[0] = sperr::num_of_partitions(m_dims[0]);
   num_of_parts[1] = sperr::num_of_partitions(m_dims[1]);
   num_of_parts[2] = sperr::num_of_partitions(m_dims[2]);
   size_t num_of_sizes = std::accumulate(num_of_parts.cbegin(), num_of_parts.cend(), 1ul);
-
-  // Initialize LIS
-  if (m_LIS.size() < num_of_sizes)
-    m_LIS.resize(num_of_sizes);
-  std::for_each(m_LIS.begin(), m_LIS.end(), [](auto& list) { list.clear(); });
+  auto lis = lis_type(num_of_sizes);
 
   // Starting from a set representing the whole volume, identify the smaller
   //    subsets and put them in the LIS accordingly.
-  //    Note that it truncates 64-bit ints to 16-bit ints here, but should be OK.
-  Set3D big;
-  big.length_x = static_cast<uint16_t>(m_dims[0]);
-  big.length_y = static_cast<uint16_t>(m_dims[1]);
-  big.length_z = static_cast<uint16_t>(m_dims[2]);
+  assert(m_dims[0] <= max_dim && m_dims[1] <= max_dim && m_dims[2] <= max_dim);
+  auto big = set_type();
+  big.length_x = static_cast<C>(m_dims[0]);
+  big.length_y = static_cast<C>(m_dims[1]);
+  big.length_z = static_cast<C>(m_dims[2]);
 
   auto curr_lev = uint16_t{0};
 
@@ -49,7 +91,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
       auto [subsets, next_lev] = m_partition_S_XYZ(big, curr_lev);
       big = subsets[0];
       for (auto it = std::next(subsets.cbegin()); it != subsets.cend(); ++it)
-        m_LIS[next_lev].emplace_back(*it);
+        lis[next_lev].emplace_back(*it);
       curr_lev = next_lev;
     }
   }
@@ -61,7 +103,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
       auto [subsets, next_lev] = m_partition_S_XYZ(big, curr_lev);
       big = subsets[0];
       for (auto it = std::next(subsets.cbegin()); it != subsets.cend(); ++it)
-        m_LIS[next_lev].emplace_back(*it);
+        lis[next_lev].emplace_back(*it);
       curr_lev = next_lev;
       xf++;
     }
@@ -72,7 +114,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
         auto [subsets, next_lev] = m_partition_S_XY(big, curr_lev);
         big = subsets[0];
         for (auto it = std::next(subsets.cbegin()); it != subsets.cend(); ++it)
-          m_LIS[next_lev].emplace_back(*it);
+          lis[next_lev].emplace_back(*it);
         curr_lev = next_lev;
         xf++;
       }
@@ -81,7 +123,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
       while (xf < num_xforms_z) {
         auto [subsets, next_lev] = m_partition_S_Z(big, curr_lev);
         big = subsets[0];
-        m_LIS[next_lev].emplace_back(subsets[1]);
+        lis[next_lev].emplace_back(subsets[1]);
         curr_lev = next_lev;
         xf++;
       }
@@ -90,41 +132,27 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
 
   // Right now big is the set that's most likely to be significant, so insert
   // it at the front of it's corresponding vector. One-time expense.
-  m_LIS[curr_lev].insert(m_LIS[curr_lev].begin(), big);
+  lis[curr_lev].insert(lis[curr_lev].begin(), big);
+
+  // The same traversing order as in `m_sorting_pass()`.
+  size_t morton_offset = 0;
+  for (size_t tmp = 1; tmp <= lis.size(); tmp++) {
+    for (auto& set : lis[lis.size() - tmp]) {
+      set.morton_idx = morton_offset;
+      morton_offset += set.num_elem();
+    }
+  }
 
-  // Encoder and decoder might have different additional tasks.
-  m_additional_initialization();
+  return lis;
 }
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_sorting_pass()
+template <typename T, typename C, class Derived>
+void sperr::SPECK3D_INT<T, C, Derived>::m_sorting_pass()
 {
   // Since we have a separate representation of LIP, let's process that list first!
   //
-  const auto bits_x64 = m_LIP_mask.size() - m_LIP_mask.size() % 64;
-
-  for (size_t i = 0; i < bits_x64; i += 64) {
-    auto value = m_LIP_mask.rlong(i);
-
-#if __cplusplus >= 202002L
-    while (value) {
-      auto j = std::countr_zero(value);
-      m_process_P_lite(i + j);
-      value &= value - 1;
-    }
-#else
-    if (value != 0) {
-      for (size_t j = 0; j < 64; j++) {
-        if ((value >> j) & uint64_t{1})
-          m_process_P_lite(i + j);
-      }
-    }
-#endif
-  }
-  for (auto i = bits_x64; i < m_LIP_mask.size(); i++) {
-    if (m_LIP_mask.rbit(i))
-      m_process_P_lite(i);
-  }
+  for (auto i : m_LIP_mask.true_bits())
+    m_derived().m_process_P_lite(i);
 
   // Then we process regular sets in LIS.
   //
@@ -132,13 +160,13 @@ void sperr::SPECK3D_INT<T>::m_sorting_pass()
     auto idx1 = m_LIS.size() - tmp;
     for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
       size_t dummy = 0;
-      m_process_S(idx1, idx2, dummy, true);
+      m_derived().m_process_S(idx1, idx2, dummy, true);
     }
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_code_S(size_t idx1, size_t idx2)
+template <typename T, typename C, class Derived>
+void sperr::SPECK3D_INT<T, C, Derived>::m_code_S(size_t idx1, size_t idx2)
 {
   auto set = m_LIS[idx1][idx2];
 
@@ -150,40 +178,50 @@ void sperr::SPECK3D_INT<T>::m_code_S(size_t idx1, size_t idx2)
     const auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
     auto mort = set.morton_idx;
     m_LIP_mask.wtrue(id);
-    m_process_P(id, mort, sig_counter, need_decide);
+    m_derived().m_process_P(id, mort, sig_counter, need_decide);
 
     // Element (1, 0, 0)
     auto id2 = id + 1;
     m_LIP_mask.wtrue(id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
 
     // Element (0, 1, 0)
     id2 = id + m_dims[0];
     m_LIP_mask.wtrue(id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
 
     // Element (1, 1, 0)
     m_LIP_mask.wtrue(++id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
 
     // Element (0, 0, 1)
     id2 = id + m_dims[0] * m_dims[1];
     m_LIP_mask.wtrue(id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
 
     // Element (1, 0, 1)
     m_LIP_mask.wtrue(++id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
 
     // Element (0, 1, 1)
     id2 = id + m_dims[0] * (m_dims[1] + 1);
     m_LIP_mask.wtrue(id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
 
     // Element (1, 1, 1)
     need_decide = sig_counter != 0;
     m_LIP_mask.wtrue(++id2);
-    m_process_P(id2, ++mort, sig_counter, need_decide);
+    m_derived().m_process_P(id2, ++mort, sig_counter, need_decide);
+  }
+  else if (m_pow2_cube) {  // even split case: 8 cubes that are at least 2x2x2 each
+    const auto subsets = m_partition_S_cube(set);
+    const auto next_lev = idx1 + 3;
+    size_t sig_counter = 0;
+    for (size_t i = 0; i < 8; i++) {
+      m_LIS[next_lev].emplace_back(subsets[i]);
+      const auto newidx2 = m_LIS[next_lev].size() - 1;
+      m_derived().m_process_S(next_lev, newidx2, sig_counter, sig_counter != 0 || i != 7);
+    }
   }
   else {  // normal recursion case
           // Get its 8 subsets, and move the empty ones to the end.
@@ -200,35 +238,38 @@ void sperr::SPECK3D_INT<T>::m_code_S(size_t idx1, size_t idx2)
       if (it->num_elem() == 1) {
         auto idx = it->start_z * m_dims[0] * m_dims[1] + it->start_y * m_dims[0] + it->start_x;
         m_LIP_mask.wtrue(idx);
-        m_process_P(idx, it->morton_idx, sig_counter, need_decide);
+        m_derived().m_process_P(idx, it->morton_idx, sig_counter, need_decide);
       }
       else {
         m_LIS[next_lev].emplace_back(*it);
         const auto newidx2 = m_LIS[next_lev].size() - 1;
-        m_process_S(next_lev, newidx2, sig_counter, need_decide);
+        m_derived().m_process_S(next_lev, newidx2, sig_counter, need_decide);
       }
     }
   }
 }
 
-template <typename T>
-auto sperr::SPECK3D_INT<T>::m_partition_S_XYZ(Set3D set, uint16_t lev) const
-    -> std::tuple<std::array<Set3D, 8>, uint16_t>
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_partition_S_XYZ(set_type set, uint16_t lev) const
+    -> std::tuple<std::array<set_type, 8>, uint16_t>
 {
   // Integer promotion rules (https://en.cppreference.com/w/c/language/conversion) say that types
   //    shorter than `int` are implicitly promoted to be `int` to perform calculations, so just
-  //    keep them as `int` here because they'll involve in calculations later.
+  //    keep them as `uint32_t` here, which holds both coordinate types, because they'll involve
+  //    in calculations later.
   //
-  const auto split_x = std::array<int, 2>{set.length_x - set.length_x / 2, set.length_x / 2};
-  const auto split_y = std::array<int, 2>{set.length_y - set.length_y / 2, set.length_y / 2};
-  const auto split_z = std::array<int, 2>{set.length_z - set.length_z / 2, set.length_z / 2};
+  const auto len_x = uint32_t{set.length_x}, len_y = uint32_t{set.length_y};
+  const auto len_z = uint32_t{set.length_z};
+  const auto split_x = std::array<uint32_t, 2>{len_x - len_x / 2, len_x / 2};
+  const auto split_y = std::array<uint32_t, 2>{len_y - len_y / 2, len_y / 2};
+  const auto split_z = std::array<uint32_t, 2>{len_z - len_z / 2, len_z / 2};
 
   const auto tmp = std::array<uint8_t, 2>{0, 1};
   lev += tmp[split_x[1] != 0];
   lev += tmp[split_y[1] != 0];
   lev += tmp[split_z[1] != 0];
 
-  auto subsets = std::tuple<std::array<Set3D, 8>, uint16_t>();
+  auto subsets = std::tuple<std::array<set_type, 8>, uint16_t>();
   std::get<1>(subsets) = lev;
   auto morton_offset = set.morton_idx;
 
@@ -325,21 +366,46 @@ auto sperr::SPECK3D_INT<T>::m_partition_S_XYZ(Set3D set, uint16_t lev) const
   return subsets;
 }
 
-template <typename T>
-auto sperr::SPECK3D_INT<T>::m_partition_S_XY(Set3D set, uint16_t lev) const
-    -> std::tuple<std::array<Set3D, 4>, uint16_t>
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_partition_S_cube(set_type set) const
+    -> std::array<set_type, 8>
+{
+  // Same order of subsets as `m_partition_S_XYZ()`, but each of them is exactly 1/8 of `set`.
+  assert(set.length_x == set.length_y && set.length_x == set.length_z && set.length_x % 2 == 0);
+  const auto half = uint32_t{set.length_x} / 2;
+  const auto sub_elem = size_t{half} * half * half;
+
+  auto subsets = std::array<set_type, 8>();
+  for (uint32_t i = 0; i < 8; i++) {
+    auto& sub = subsets[i];
+    sub.morton_idx = set.morton_idx + i * sub_elem;
+    sub.start_x = static_cast<C>(set.start_x + (i & 1u) * half);
+    sub.start_y = static_cast<C>(set.start_y + ((i >> 1) & 1u) * half);
+    sub.start_z = static_cast<C>(set.start_z + (i >> 2) * half);
+    sub.length_x = static_cast<C>(half);
+    sub.length_y = static_cast<C>(half);
+    sub.length_z = static_cast<C>(half);
+  }
+
+  return subsets;
+}
+
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_partition_S_XY(set_type set, uint16_t lev) const
+    -> std::tuple<std::array<set_type, 4>, uint16_t>
 {
   // This partition scheme is only used during initialization; no need to calculate morton offset.
   // The correct morton offset will be calculated during initialization.
 
-  const auto split_x = std::array<int, 2>{set.length_x - set.length_x / 2, set.length_x / 2};
-  const auto split_y = std::array<int, 2>{set.length_y - set.length_y / 2, set.length_y / 2};
+  const auto len_x = uint32_t{set.length_x}, len_y = uint32_t{set.length_y};
+  const auto split_x = std::array<uint32_t, 2>{len_x - len_x / 2, len_x / 2};
+  const auto split_y = std::array<uint32_t, 2>{len_y - len_y / 2, len_y / 2};
 
   const auto tmp = std::array<uint8_t, 2>{0, 1};
   lev += tmp[split_x[1] != 0];
   lev += tmp[split_y[1] != 0];
 
-  auto subsets = std::tuple<std::array<Set3D, 4>, uint16_t>();
+  auto subsets = std::tuple<std::array<set_type, 4>, uint16_t>();
   std::get<1>(subsets) = lev;
   const auto offsets = std::array<size_t, 3>{1, 2, 4};
 
@@ -388,18 +454,19 @@ auto sperr::SPECK3D_INT<T>::m_partition_S_XY(Set3D set, uint16_t lev) const
   return subsets;
 }
 
-template <typename T>
-auto sperr::SPECK3D_INT<T>::m_partition_S_Z(Set3D set, uint16_t lev) const
-    -> std::tuple<std::array<Set3D, 2>, uint16_t>
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_partition_S_Z(set_type set, uint16_t lev) const
+    -> std::tuple<std::array<set_type, 2>, uint16_t>
 {
   // This partition scheme is only used during initialization; no need to calculate morton offset.
   // The correct morton offset will be calculated during initialization.
 
-  const auto split_z = std::array<int, 2>{set.length_z - set.length_z / 2, set.length_z / 2};
+  const auto len_z = uint32_t{set.length_z};
+  const auto split_z = std::array<uint32_t, 2>{len_z - len_z / 2, len_z / 2};
   if (split_z[1] != 0)
     lev++;
 
-  auto subsets = std::tuple<std::array<Set3D, 2>, uint16_t>();
+  auto subsets = std::tuple<std::array<set_type, 2>, uint16_t>();
   std::get<1>(subsets) = lev;
 
   //
@@ -426,7 +493,43 @@ auto sperr::SPECK3D_INT<T>::m_partition_S_Z(Set3D set, uint16_t lev) const
   return subsets;
 }
 
-template class sperr::SPECK3D_INT<uint64_t>;
-template class sperr::SPECK3D_INT<uint32_t>;
-template class sperr::SPECK3D_INT<uint16_t>;
-template class sperr::SPECK3D_INT<uint8_t>;
+template <typename T, typename C, class Derived>
+void sperr::SPECK3D_INT<T, C, Derived>::m_save_lists()
+{
+  m_ckpt_LIS = m_LIS;  // Copy assignment reuses memory already allocated by `m_ckpt_LIS`.
+}
+
+template <typename T, typename C, class Derived>
+void sperr::SPECK3D_INT<T, C, Derived>::m_restore_lists()
+{
+  m_LIS = m_ckpt_LIS;
+}
+
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_LIS_stats() const -> std::array<size_t, 2>
+{
+  return lis_stats(m_LIS);
+}
+
+template <typename T, typename C, class Derived>
+auto sperr::SPECK3D_INT<T, C, Derived>::m_dims_supported() const -> bool
+{
+  return std::all_of(m_dims.cbegin(), m_dims.cend(), [](auto d) { return d <= max_dim; });
+}
+
+template class sperr::SPECK3D_INT<uint64_t, uint16_t, sperr::SPECK3D_INT_ENC<uint64_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint32_t, uint16_t, sperr::SPECK3D_INT_ENC<uint32_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint16_t, uint16_t, sperr::SPECK3D_INT_ENC<uint16_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint8_t, uint16_t, sperr::SPECK3D_INT_ENC<uint8_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint64_t, uint32_t, sperr::SPECK3D_INT_ENC<uint64_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint32_t, uint32_t, sperr::SPECK3D_INT_ENC<uint32_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint16_t, uint32_t, sperr::SPECK3D_INT_ENC<uint16_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint8_t, uint32_t, sperr::SPECK3D_INT_ENC<uint8_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint64_t, uint16_t, sperr::SPECK3D_INT_DEC<uint64_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint32_t, uint16_t, sperr::SPECK3D_INT_DEC<uint32_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint16_t, uint16_t, sperr::SPECK3D_INT_DEC<uint16_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint8_t, uint16_t, sperr::SPECK3D_INT_DEC<uint8_t, uint16_t>>;
+template class sperr::SPECK3D_INT<uint64_t, uint32_t, sperr::SPECK3D_INT_DEC<uint64_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint32_t, uint32_t, sperr::SPECK3D_INT_DEC<uint32_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint16_t, uint32_t, sperr::SPECK3D_INT_DEC<uint16_t, uint32_t>>;
+template class sperr::SPECK3D_INT<uint8_t, uint32_t, sperr::SPECK3D_INT_DEC<uint8_t, uint32_t>>;
@@ -5,8 +5,8 @@
 #include <cstring>  // std::memcpy()
 #include <numeric>
 
-template <typename T>
-void sperr::SPECK3D_INT_DEC<T>::m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read)
+template <typename T, typename C>
+void sperr::SPECK3D_INT_DEC<T, C>::m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read)
 {
   auto& set = m_LIS[idx1][idx2];
 
@@ -21,8 +21,11 @@ void sperr::SPECK3D_INT_DEC<T>::m_process_S(size_t idx1, size_t idx2, size_t& co
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_DEC<T>::m_process_P(size_t idx, size_t no_use, size_t& counter, bool read)
+template <typename T, typename C>
+void sperr::SPECK3D_INT_DEC<T, C>::m_process_P(size_t idx,
+                                               size_t no_use,
+                                               size_t& counter,
+                                               bool read)
 {
   bool is_sig = true;
   if (read)
@@ -36,8 +39,8 @@ void sperr::SPECK3D_INT_DEC<T>::m_process_P(size_t idx, size_t no_use, size_t& c
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_DEC<T>::m_process_P_lite(size_t idx)
+template <typename T, typename C>
+void sperr::SPECK3D_INT_DEC<T, C>::m_process_P_lite(size_t idx)
 {
   auto is_sig = m_bit_buffer.rbit();
 
@@ -48,7 +51,11 @@ void sperr::SPECK3D_INT_DEC<T>::m_process_P_lite(size_t idx)
   }
 }
 
-template class sperr::SPECK3D_INT_DEC<uint64_t>;
-template class sperr::SPECK3D_INT_DEC<uint32_t>;
-template class sperr::SPECK3D_INT_DEC<uint16_t>;
-template class sperr::SPECK3D_INT_DEC<uint8_t>;
+template class sperr::SPECK3D_INT_DEC<uint64_t, uint16_t>;
+template class sperr::SPECK3D_INT_DEC<uint32_t, uint16_t>;
+template class sperr::SPECK3D_INT_DEC<uint16_t, uint16_t>;
+template class sperr::SPECK3D_INT_DEC<uint8_t, uint16_t>;
+template class sperr::SPECK3D_INT_DEC<uint64_t, uint32_t>;
+template class sperr::SPECK3D_INT_DEC<uint32_t, uint32_t>;
+template class sperr::SPECK3D_INT_DEC<uint16_t, uint32_t>;
+template class sperr::SPECK3D_INT_DEC<uint8_t, uint32_t>;
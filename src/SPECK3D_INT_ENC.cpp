@@ -3,10 +3,17 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>  // std::memcpy()
+#include <limits>
 #include <numeric>
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_deposit_set(Set3D set)
+auto sperr::morton_perm_cache() -> Shape_Cache<std::vector<uint32_t>>&
+{
+  static Shape_Cache<std::vector<uint32_t>> cache;
+  return cache;
+}
+
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_deposit_set(Set3D<C> set)
 {
   switch (set.num_elem()) {
     case 0:
@@ -138,28 +145,69 @@ void sperr::SPECK3D_INT_ENC<T>::m_deposit_set(Set3D set)
     m_deposit_set(sub);
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_additional_initialization()
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_fill_morton_perm(Set3D<C> set,
+                                                      std::vector<uint32_t>& perm) const
+{
+  switch (set.num_elem()) {
+    case 0:
+      return;
+    case 1: {
+      auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
+      perm[set.morton_idx] = static_cast<uint32_t>(id);
+      return;
+    }
+    default: {
+      auto [subsets, lev] = m_partition_S_XYZ(set, 0);
+      for (auto& sub : subsets)
+        m_fill_morton_perm(sub, perm);
+    }
+  }
+}
+
+template <typename T, typename C>
+auto sperr::SPECK3D_INT_ENC<T, C>::m_make_morton_perm() const -> std::vector<uint32_t>
+{
+  auto perm = std::vector<uint32_t>(m_dims[0] * m_dims[1] * m_dims[2]);
+  for (const auto& list : m_LIS) {
+    for (const auto& set : list)
+      m_fill_morton_perm(set, perm);
+  }
+  return perm;
+}
+
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_additional_initialization()
 {
   // For the encoder, this function re-organizes the coefficients in a morton order.
   //
-  m_morton_buf.resize(m_dims[0] * m_dims[1] * m_dims[2]);
-
-  // The same traversing order as in `SPECK3D_INT::m_sorting_pass()`
-  size_t morton_offset = 0;
-  for (size_t tmp = 1; tmp <= m_LIS.size(); tmp++) {
-    auto idx1 = m_LIS.size() - tmp;
-    for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
-      auto& set = m_LIS[idx1][idx2];
-      set.morton_idx = morton_offset;
-      m_deposit_set(set);
-      morton_offset += set.num_elem();
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  m_morton_buf.resize(total_vals);
+
+  // The morton order only depends on `m_dims`, so it's made into a permutation once and then
+  //    shared by encoders of all chunks of the same dimensions. Sets in the initial LIS already
+  //    have their `morton_idx` assigned. Volumes too big for 32-bit indices deposit each set.
+  if (total_vals <= std::numeric_limits<uint32_t>::max()) {
+    const auto perm = morton_perm_cache().get(
+        m_dims, [this] { return m_make_morton_perm(); },
+        [](const auto& p) { return p.capacity() * sizeof(uint32_t); });
+    const auto* idx = perm->data();
+    for (size_t i = 0; i < total_vals; i++)
+      m_morton_buf[i] = sperr::msb_position(m_coeff_buf[idx[i]]);
+  }
+  else {
+    for (const auto& list : m_LIS) {
+      for (const auto& set : list)
+        m_deposit_set(set);
     }
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_process_S(size_t idx1, size_t idx2, size_t& counter, bool output)
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_process_S(size_t idx1,
+                                               size_t idx2,
+                                               size_t& counter,
+                                               bool output)
 {
   auto& set = m_LIS[idx1][idx2];
   auto is_sig = true;
@@ -179,8 +227,11 @@ void sperr::SPECK3D_INT_ENC<T>::m_process_S(size_t idx1, size_t idx2, size_t& co
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_process_P(size_t idx, size_t morton, size_t& counter, bool output)
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_process_P(size_t idx,
+                                               size_t morton,
+                                               size_t& counter,
+                                               bool output)
 {
   bool is_sig = true;
 
@@ -198,8 +249,8 @@ void sperr::SPECK3D_INT_ENC<T>::m_process_P(size_t idx, size_t morton, size_t& c
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_process_P_lite(size_t idx)
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_process_P_lite(size_t idx)
 {
   auto is_sig = (m_coeff_buf[idx] >= m_threshold);
   m_bit_buffer.wbit(is_sig);
@@ -211,14 +262,14 @@ void sperr::SPECK3D_INT_ENC<T>::m_process_P_lite(size_t idx)
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_bitplane_init()
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_bitplane_init()
 {
   m_morton_threshold = sperr::msb_position(m_threshold);
 }
 
-template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_refinement_extra()
+template <typename T, typename C>
+void sperr::SPECK3D_INT_ENC<T, C>::m_refinement_extra()
 {
   for (auto idx : m_LSP_new) {
     assert(m_coeff_buf[idx] >= m_threshold);
@@ -226,7 +277,11 @@ void sperr::SPECK3D_INT_ENC<T>::m_refinement_extra()
   }
 }
 
-template class sperr::SPECK3D_INT_ENC<uint64_t>;
-template class sperr::SPECK3D_INT_ENC<uint32_t>;
-template class sperr::SPECK3D_INT_ENC<uint16_t>;
-template class sperr::SPECK3D_INT_ENC<uint8_t>;
+template class sperr::SPECK3D_INT_ENC<uint64_t, uint16_t>;
+template class sperr::SPECK3D_INT_ENC<uint32_t, uint16_t>;
+template class sperr::SPECK3D_INT_ENC<uint16_t, uint16_t>;
+template class sperr::SPECK3D_INT_ENC<uint8_t, uint16_t>;
+template class sperr::SPECK3D_INT_ENC<uint64_t, uint32_t>;
+template class sperr::SPECK3D_INT_ENC<uint32_t, uint32_t>;
+template class sperr::SPECK3D_INT_ENC<uint16_t, uint32_t>;
+template class sperr::SPECK3D_INT_ENC<uint8_t, uint32_t>;
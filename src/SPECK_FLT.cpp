@@ -13,6 +13,7 @@ void sperr::SPECK_FLT::copy_data(const T* p, size_t len)
 {
   static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
 
+  m_apply_mem_policy();
   m_vals_d.resize(len);
   std::copy(p, p + len, m_vals_d.begin());
 }
@@ -29,7 +30,7 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
   // So let's clean up everything at the very beginning of this routine.
   m_vals_d.clear();
   m_sign_array.resize(0);
-  std::visit([](auto&& vec) { vec.clear(); }, m_vals_ui);
+  std::apply([](auto&... vec) { (vec.clear(), ...); }, m_vals_ui);
   m_q = 0.0;
   m_has_outlier = false;
 
@@ -55,8 +56,8 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
     assert(m_q > 0.0);
   }
 
-  // Bitstream parser 2.1: based on the number of bitplanes, decide on an integer length to use,
-  // and instantiate the proper decoder. It will be the decoder who parses the SPECK bitstream.
+  // Bitstream parser 2.1: based on the number of bitplanes, decide on an integer length to use.
+  //    The decoder of that integer length parses the SPECK bitstream.
   auto pos = m_condi_bitstream.size();
   auto remaining_len = len - pos;
   assert(remaining_len >= SPECK_INT<uint8_t>::header_size);
@@ -71,37 +72,127 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
   else
     m_uint_flag = UINTType::UINT64;
 
-  m_instantiate_int_vec();
+  return m_dispatch_uint(
+      [&](auto zero) { return m_parse_speck_stream<decltype(zero)>(speck_p, remaining_len); });
+}
+
+template <typename T>
+auto sperr::SPECK_FLT::m_parse_speck_stream(const uint8_t* p, size_t len) -> RTNType
+{
   m_instantiate_decoder();
+  auto& decoder = std::get<coder_ptr<T>>(m_decoder);
+  decoder->set_resumable(m_resumable);
 
   // Bitstream parser 2.2: extract and parse SPECK stream.
   //    A situation to be considered here is that the speck bitstream is only partially available
   //    as the result of progressive access. In that case, the available speck stream is simply
   //    shorter than what the header reports.
-  auto speck_suppose_len =
-      std::visit([speck_p](auto&& dec) { return dec->get_stream_full_len(speck_p); }, m_decoder);
-  auto speck_len = std::min(size_t{speck_suppose_len}, remaining_len);
-  std::visit([speck_p, speck_len](auto&& dec) { return dec->use_bitstream(speck_p, speck_len); },
-             m_decoder);
-  pos += speck_len;
-  assert(pos <= len);
+  auto speck_len = std::min(size_t{decoder->get_stream_full_len(p)}, len);
+  decoder->use_bitstream(p, speck_len);
 
   // Bitstream parser 3: extract Outlier Coder stream if there's any.
-  //    Also note the situation where only partial of the outlier coding bitstream is available.
+  return m_parse_outlier_stream(p + speck_len, len - speck_len);
+}
+
+void sperr::SPECK_FLT::enable_rd_table(bool enable)
+{
+  m_rd_enabled = enable;
+  if (!m_rd_enabled)
+    m_rd_table.clear();
+}
+
+auto sperr::SPECK_FLT::view_rd_table() const -> const rd_table_type&
+{
+  return m_rd_table;
+}
+
+auto sperr::SPECK_FLT::view_profile() const -> const Profile&
+{
+  return m_profile;
+}
+
+void sperr::SPECK_FLT::m_profile_reset()
+{
+  m_profile = Profile();
+  m_profile.num_chunks = 1;
+}
+
+void sperr::SPECK_FLT::m_profile_memory()
+{
+  // The integer coefficients and signs are counted by the integer SPECK coder.
+  if constexpr (profiling)
+    m_profile.bytes_allocated += (m_vals_d.capacity() + m_vals_orig.capacity()) * sizeof(double);
+}
+
+template <typename T>
+void sperr::SPECK_FLT::m_msb_histogram(std::array<size_t, 64>& counts,
+                                       std::array<double, 64>& sumsq) const
+{
+  counts.fill(0);
+  sumsq.fill(0.0);
+  for (auto v : std::get<uninit_vec_type<T>>(m_vals_ui)) {
+    if (v == 0)
+      continue;
+    const auto msb = sperr::msb_position(v);
+    counts[msb]++;
+    sumsq[msb] += double(v) * double(v);
+  }
+}
+
+template <typename T>
+void sperr::SPECK_FLT::m_build_rd_table(const std::array<size_t, 64>& counts,
+                                        const std::array<double, 64>& sumsq)
+{
+  // After the bitplane of threshold 2^b is decoded, integers smaller than 2^b are still zero, and
+  //    the rest are known up to an interval of width 2^b (except when b == 0). On top of that,
+  //    every value carries the quantization error of step size `m_q`. Because the CDF 9/7 wavelet
+  //    transform is close to orthogonal, this SSE estimate also applies to the original data.
+  m_rd_table.clear();
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  const auto q2 = m_q * m_q;
+  const auto quant_sse = q2 * double(total_vals) / 12.0;
+  const auto num_bitplanes = size_t(sperr::msb_position(m_max_ui) + 1);
+
+  const auto& encoder = std::get<coder_ptr<T>>(m_encoder);
+  const auto& ends = encoder->view_bitplane_ends();
+  const auto speck_len = encoder->encoded_bitstream_len();
+  const auto header_len = m_condi_bitstream.size() + SPECK_INT<uint8_t>::header_size;
+  const auto packed_bits = (speck_len - SPECK_INT<uint8_t>::header_size) * 8;
+  assert(ends.size() <= num_bitplanes);
+
+  // The first point: no bitplane is decoded at all.
+  auto all_sumsq = std::accumulate(sumsq.cbegin(), sumsq.cend(), 0.0);
+  m_rd_table.push_back({header_len, q2 * all_sumsq + quant_sse});
+
+  for (size_t i = 0; i < ends.size(); i++) {
+    const auto b = num_bitplanes - 1 - i;
+    auto sse = std::accumulate(sumsq.cbegin(), sumsq.cbegin() + b, 0.0);
+    if (b > 0) {
+      auto cnt = std::accumulate(counts.cbegin() + b, counts.cend(), size_t{0});
+      sse += double(cnt) * std::ldexp(1.0, int(b) * 2) / 12.0;
+    }
+    auto bytes = header_len + (std::min(size_t{ends[i]}, packed_bits) + 7) / 8;
+    auto point = RD_Point{bytes, q2 * sse + quant_sse};
+    if (bytes == m_rd_table.back().bytes)
+      m_rd_table.back() = point;
+    else
+      m_rd_table.push_back(point);
+  }
+}
+
+auto sperr::SPECK_FLT::m_parse_outlier_stream(const uint8_t* p, size_t len) -> RTNType
+{
+  // Note the situation where only partial of the outlier coding bitstream is available.
   //    In that case, we simply discard the remaining bitstream.
   m_has_outlier = false;
-  if (pos < len) {
-    const uint8_t* const out_p = ptr + pos;
-    remaining_len = len - pos;
-    if (remaining_len >= SPECK_INT<uint8_t>::header_size) {
-      auto suppose_len = m_out_coder.get_stream_full_len(out_p);
-      assert(suppose_len >= remaining_len);
-      if (remaining_len == suppose_len) {
-        auto rtn = m_out_coder.use_bitstream(out_p, suppose_len);
-        if (rtn != RTNType::Good)
-          return rtn;
-        m_has_outlier = true;
-      }
+  if (len >= SPECK_INT<uint8_t>::header_size) {
+    auto suppose_len = m_out_coder.get_stream_full_len(p);
+    assert(suppose_len >= len);
+    if (len == suppose_len) {
+      auto rtn = m_out_coder.use_bitstream(p, suppose_len);
+      if (rtn != RTNType::Good)
+        return rtn;
+      m_has_outlier = true;
     }
   }
 
@@ -115,7 +206,9 @@ void sperr::SPECK_FLT::append_encoded_bitstream(vec8_type& buf) const
 
   if (!m_conditioner.is_constant(m_condi_bitstream[0])) {
     // Append SPECK_INT bitstream.
-    std::visit([&buf](auto&& enc) { enc->append_encoded_bitstream(buf); }, m_encoder);
+    m_dispatch_uint([&](auto zero) {
+      std::get<coder_ptr<decltype(zero)>>(m_encoder)->append_encoded_bitstream(buf);
+    });
 
     // Append outlier coder bitstream.
     if (m_has_outlier)
@@ -123,6 +216,19 @@ void sperr::SPECK_FLT::append_encoded_bitstream(vec8_type& buf) const
   }
 }
 
+auto sperr::SPECK_FLT::encoded_bitstream_len() const -> size_t
+{
+  auto len = m_condi_bitstream.size();
+  if (!m_conditioner.is_constant(m_condi_bitstream[0])) {
+    m_dispatch_uint([&](auto zero) {
+      len += std::get<coder_ptr<decltype(zero)>>(m_encoder)->encoded_bitstream_len();
+    });
+    if (m_has_outlier)
+      len += m_out_coder.encoded_bitstream_len();
+  }
+  return len;
+}
+
 auto sperr::SPECK_FLT::view_decoded_data() const -> const vecd_type&
 {
   return m_vals_d;
@@ -192,46 +298,18 @@ void sperr::SPECK_FLT::set_dims(dims_type dims)
 
 auto sperr::SPECK_FLT::integer_len() const -> size_t
 {
-  switch (m_uint_flag) {
-    case UINTType::UINT8:
-      assert(m_vals_ui.index() == 0);
-      // Either this is an encoder, or this is a decoder.
-      assert(m_encoder.index() == 0 || m_decoder.index() == 0);
-      return sizeof(uint8_t);
-    case UINTType::UINT16:
-      assert(m_vals_ui.index() == 1);
-      assert(m_encoder.index() == 1 || m_decoder.index() == 1);
-      return sizeof(uint16_t);
-    case UINTType::UINT32:
-      assert(m_vals_ui.index() == 2);
-      assert(m_encoder.index() == 2 || m_decoder.index() == 2);
-      return sizeof(uint32_t);
-    default:
-      assert(m_vals_ui.index() == 3);
-      assert(m_encoder.index() == 3 || m_decoder.index() == 3);
-      return sizeof(uint64_t);
-  }
+  return m_dispatch_uint([](auto zero) { return sizeof(zero); });
 }
 
-void sperr::SPECK_FLT::m_instantiate_int_vec()
+void sperr::SPECK_FLT::set_mem_policy(MemPolicy policy)
 {
-  switch (m_uint_flag) {
-    case UINTType::UINT8:
-      if (m_vals_ui.index() != 0)
-        m_vals_ui = std::vector<uint8_t>();
-      break;
-    case UINTType::UINT16:
-      if (m_vals_ui.index() != 1)
-        m_vals_ui = std::vector<uint16_t>();
-      break;
-    case UINTType::UINT32:
-      if (m_vals_ui.index() != 2)
-        m_vals_ui = std::vector<uint32_t>();
-      break;
-    default:
-      if (m_vals_ui.index() != 3)
-        m_vals_ui = std::vector<uint64_t>();
-  }
+  m_mem_policy = policy;
+}
+
+void sperr::SPECK_FLT::m_apply_mem_policy()
+{
+  if (m_vals_d.get_allocator().policy() != m_mem_policy)
+    m_vals_d = vecd_type(vecd_type::allocator_type(m_mem_policy));
 }
 
 auto sperr::SPECK_FLT::m_estimate_mse_midtread(double q) const -> double
@@ -308,7 +386,7 @@ auto sperr::SPECK_FLT::m_estimate_q(double param, bool high_prec) const -> doubl
   }
 }
 
-auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
+auto sperr::SPECK_FLT::m_decide_integer_len(double max_mag) -> RTNType
 {
   // Make sure that the rounding mode is what we wanted.
   // Here are two methods of querying the current rounding mode; not sure
@@ -317,16 +395,15 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
   assert(FE_TONEAREST == std::fegetround());
   assert(FLT_ROUNDS == 1);
 
-  // Find the biggest floating point value, then get its quantized integer.
-  auto maxd = *std::max_element(m_vals_d.cbegin(), m_vals_d.cend(),
-                                [](auto a, auto b) { return std::abs(a) < std::abs(b); });
+  // Get the quantized integer of the biggest floating point value. It's calculated exactly the
+  //    same way as in `m_midtread_quantize()`, so it's the biggest integer quantization produces.
   std::feclearexcept(FE_INVALID);
   assert(m_q > 0.0);
-  auto maxll = std::llrint(std::abs(maxd) / m_q);
+  assert(max_mag >= 0.0);
+  auto maxll = std::llrint(max_mag * (1.0 / m_q));
   if (std::fetestexcept(FE_INVALID))
     return RTNType::FE_Invalid;
 
-  // Decide integer length, and instantiate `m_vals_ui`.
   if (maxll <= std::numeric_limits<uint8_t>::max())
     m_uint_flag = UINTType::UINT8;
   else if (maxll <= std::numeric_limits<uint16_t>::max())
@@ -336,66 +413,79 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
   else
     m_uint_flag = UINTType::UINT64;
 
-  m_instantiate_int_vec();
+  return RTNType::Good;
+}
 
+template <typename T>
+void sperr::SPECK_FLT::m_midtread_quantize()
+{
   const auto total_vals = m_vals_d.size();
-  std::visit([total_vals](auto&& vec) { vec.resize(total_vals); }, m_vals_ui);
+  auto& vals_ui = std::get<uninit_vec_type<T>>(m_vals_ui);
+  vals_ui.resize(total_vals);
   m_sign_array.resize(total_vals);
 
-  std::visit(
-      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q](auto&& vec) {
-        auto inv = 1.0 / q;
-        auto bits_x64 = vals_d.size() - vals_d.size() % 64;
-
-        // Process 64 values at a time.
-        for (size_t i = 0; i < bits_x64; i += 64) {
-          auto bits64 = uint64_t{0};
-          for (size_t j = 0; j < 64; j++) {
-            auto ll = std::llrint(vals_d[i + j] * inv);
-            bits64 |= uint64_t{ll >= 0} << j;
-            vec[i + j] = std::abs(ll);
-          }
-          signs.wlong(i, bits64);
-        }
-
-        // Process the remaining bits.
-        for (size_t i = bits_x64; i < vals_d.size(); i++) {
-          auto ll = std::llrint(vals_d[i] * inv);
-          signs.wbit(i, (ll >= 0));
-          vec[i] = std::abs(ll);
-        }
-      },
-      m_vals_ui);
+  // Raw pointers, so stores of (possibly 1-byte) integers don't force reloading the vectors.
+  const auto* const vals_d = m_vals_d.data();
+  auto* const vec = vals_ui.data();
+
+  // Also keep track of the biggest quantized integer, so the encoder doesn't need to look for it.
+  const auto inv = 1.0 / m_q;
+  const auto bits_x64 = total_vals - total_vals % 64;
+  auto maxll = 0ll;
+
+  // Process 64 values at a time.
+  for (size_t i = 0; i < bits_x64; i += 64) {
+    auto bits64 = uint64_t{0};
+    for (size_t j = 0; j < 64; j++) {
+      auto ll = std::llrint(vals_d[i + j] * inv);
+      bits64 |= uint64_t{ll >= 0} << j;
+      ll = std::abs(ll);
+      maxll = std::max(maxll, ll);
+      vec[i + j] = ll;
+    }
+    m_sign_array.wlong(i, bits64);
+  }
+
+  // Process the remaining bits.
+  for (size_t i = bits_x64; i < total_vals; i++) {
+    auto ll = std::llrint(vals_d[i] * inv);
+    m_sign_array.wbit(i, (ll >= 0));
+    ll = std::abs(ll);
+    maxll = std::max(maxll, ll);
+    vec[i] = ll;
+  }
 
-  return RTNType::Good;
+  m_max_ui = static_cast<uint64_t>(maxll);
 }
 
+template <typename T>
 void sperr::SPECK_FLT::m_midtread_inv_quantize()
 {
-  assert(m_sign_array.size() == std::visit([](auto&& vec) { return vec.size(); }, m_vals_ui));
+  const auto& vals_ui = std::get<uninit_vec_type<T>>(m_vals_ui);
+  assert(m_sign_array.size() == vals_ui.size());
   assert(m_q > 0.0);
 
   const auto tmpd = std::array<double, 2>{-1.0, 1.0};
-  m_vals_d.resize(m_sign_array.size());
-
-  std::visit(
-      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q, tmpd](auto&& vec) {
-        auto bits_x64 = vals_d.size() - vals_d.size() % 64;
-
-        // Process 64 values at a time.
-        for (size_t i = 0; i < bits_x64; i += 64) {
-          const auto bits64 = signs.rlong(i);
-          for (size_t j = 0; j < 64; j++) {
-            auto bit = (bits64 >> j) & uint64_t{1};
-            vals_d[i + j] = q * static_cast<double>(vec[i + j]) * tmpd[bit];
-          }
-        }
+  const auto q = m_q;
+  const auto total_vals = vals_ui.size();
+  m_apply_mem_policy();
+  m_vals_d.resize(total_vals);
+  const auto* const vec = vals_ui.data();
+  auto* const vals_d = m_vals_d.data();
+  const auto bits_x64 = total_vals - total_vals % 64;
+
+  // Process 64 values at a time.
+  for (size_t i = 0; i < bits_x64; i += 64) {
+    const auto bits64 = m_sign_array.rlong(i);
+    for (size_t j = 0; j < 64; j++) {
+      auto bit = (bits64 >> j) & uint64_t{1};
+      vals_d[i + j] = q * static_cast<double>(vec[i + j]) * tmpd[bit];
+    }
+  }
 
-        // Process the remaining bits.
-        for (size_t i = bits_x64; i < vals_d.size(); i++)
-          vals_d[i] = q * static_cast<double>(vec[i]) * tmpd[signs.rbit(i)];
-      },
-      m_vals_ui);
+  // Process the remaining bits.
+  for (size_t i = bits_x64; i < total_vals; i++)
+    vals_d[i] = q * static_cast<double>(vec[i]) * tmpd[m_sign_array.rbit(i)];
 }
 
 auto sperr::SPECK_FLT::compress() -> RTNType
@@ -408,11 +498,16 @@ auto sperr::SPECK_FLT::compress() -> RTNType
     return RTNType::CompModeUnknown;
 
   m_has_outlier = false;
+  m_rd_table.clear();
+  m_profile_reset();
 
   // Step 1: data goes through the conditioner
   //    Believe it or not, there are constant fields passed in for compression!
   //    Let's detect that case and skip the rest of the compression routine if it occurs.
-  m_condi_bitstream = m_conditioner.condition(m_vals_d, m_dims);
+  {
+    auto timer = Stage_Timer(m_profile, Stage::Condition);
+    m_condi_bitstream = m_conditioner.condition(m_vals_d, m_dims);
+  }
   if (m_conditioner.is_constant(m_condi_bitstream[0]))
     return RTNType::Good;
 
@@ -420,66 +515,140 @@ auto sperr::SPECK_FLT::compress() -> RTNType
   auto param_q = 0.0;  // assist estimating `m_q`.
   switch (m_mode) {
     case CompMode::PWE:
+      if constexpr (profiling)
+        m_profile.bytes_reused += std::min(total_vals, m_vals_orig.capacity()) * sizeof(double);
       m_vals_orig.resize(total_vals);
       std::copy(m_vals_d.cbegin(), m_vals_d.cend(), m_vals_orig.begin());
       break;
     case CompMode::PSNR: {
-      // In PSNR mode, `param_q` is the data range.
-      auto [min, max] = std::minmax_element(m_vals_d.cbegin(), m_vals_d.cend());
-      param_q = *max - *min;
+      // In PSNR mode, `param_q` is the data range, which the conditioner has collected already.
+      auto [min, max] = m_conditioner.get_range();
+      param_q = max - min;
       break;
     }
     default:;  // So the compiler doesn't complain about missing switch cases.
   }
 
   // Step 2: wavelet transform
-  m_cdf.take_data(std::move(m_vals_d), m_dims);
-  m_wavelet_xform();
-  m_vals_d = m_cdf.release_data();
+  {
+    auto timer = Stage_Timer(m_profile, Stage::DWT);
+    m_cdf.take_data(std::move(m_vals_d), m_dims);
+    m_wavelet_xform();
+    m_vals_d = m_cdf.release_data();
+  }
 
   // Step 2.1: Estimate `m_q`, and store it as part of `m_condi_stream`.
-  if (m_mode == CompMode::Rate) {
-    // In fixed-rate mode, `param_q` is the wavelet coefficient of the largest magnitude.
+  //    The wavelet coefficient of the largest magnitude is needed by quantization in all modes,
+  //    and it is also `param_q` in fixed-rate mode. Find it once here.
+  auto max_mag = 0.0;
+  {
+    auto timer = Stage_Timer(m_profile, Stage::QEstimate);
     auto itr = std::max_element(m_vals_d.cbegin(), m_vals_d.cend(),
                                 [](auto a, auto b) { return std::abs(a) < std::abs(b); });
-    param_q = std::abs(*itr);
+    max_mag = std::abs(*itr);
   }
+  if (m_mode == CompMode::Rate)
+    param_q = max_mag;
 
   bool high_prec = false;
 FIXED_RATE_HIGH_PREC_LABEL:
-  m_q = m_estimate_q(param_q, high_prec);
+  {
+    auto timer = Stage_Timer(m_profile, Stage::QEstimate);
+    m_q = m_estimate_q(param_q, high_prec);
+  }
   assert(m_q > 0.0);
   m_conditioner.save_q(m_condi_bitstream, m_q);
 
-  // Step 3: quantize floating-point coefficients to integers.
-  // This step also establishes the integer length used by the encoder/decoder.
-  auto rtn = m_midtread_quantize();
+  // Step 3: decide the integer length to use, and run the integer part of the pipeline with it.
+  auto rtn = m_decide_integer_len(max_mag);
   if (rtn != RTNType::Good)
     return rtn;
+  rtn = m_dispatch_uint([this](auto zero) { return m_encode_ints<decltype(zero)>(); });
+  if (rtn != RTNType::Good)
+    return rtn;
+
+  // In CompMode::Rate mode, we see if there's enough bits produced. If not, we adjust `m_q`
+  //    so quantiztion is done with a higher precision.
+  //    Btw I know that GOTO should be used very sparsely and with great caution. I think this
+  //    is one place where it's making the code most clean and not introducing additional risks.
+  //
+  if (m_mode == CompMode::Rate && high_prec == false) {
+    assert(m_uint_flag == UINTType::UINT32);
+    auto budget = static_cast<size_t>(m_quality * double(total_vals));
+    auto actual = std::get<coder_ptr<uint32_t>>(m_encoder)->encoded_bitstream_len() * size_t{8};
+    if (actual < budget) {
+      high_prec = true;
+      goto FIXED_RATE_HIGH_PREC_LABEL;
+    }
+  }
+
+  m_profile_memory();
+  return RTNType::Good;
+}
+
+template <typename T>
+auto sperr::SPECK_FLT::m_encode_ints() -> RTNType
+{
+  const auto total_vals = m_vals_d.size();
+  auto& vals_ui = std::get<uninit_vec_type<T>>(m_vals_ui);
+
+  // Step 3.1: quantize floating-point coefficients to integers.
+  {
+    auto timer = Stage_Timer(m_profile, Stage::Quantize);
+    m_midtread_quantize<T>();
+  }
+
+  // The biggest integer should fit in `T`, since `m_decide_integer_len()` rounds the same way as
+  //    quantization. If it doesn't, integers have wrapped around; quantize again with a wider type.
+  if constexpr (!std::is_same_v<T, uint64_t>) {
+    if (m_max_ui > std::numeric_limits<T>::max()) {
+      if constexpr (std::is_same_v<T, uint8_t>)
+        m_uint_flag = UINTType::UINT16;
+      else if constexpr (std::is_same_v<T, uint16_t>)
+        m_uint_flag = UINTType::UINT32;
+      else
+        m_uint_flag = UINTType::UINT64;
+      return m_dispatch_uint([this](auto zero) { return m_encode_ints<decltype(zero)>(); });
+    }
+  }
+
+  // Optional: collect a histogram of the integers before they're handed to the encoder.
+  auto msb_counts = std::array<size_t, 64>{};
+  auto msb_sumsq = std::array<double, 64>{};
+  if (m_rd_enabled)
+    m_msb_histogram<T>(msb_counts, msb_sumsq);
 
   // CompMode::PWE only: perform outlier coding: find out all the outliers, and encode them!
+  //    (For profiling, the reconstruction needed to find outliers is part of outlier coding.)
+  auto rtn = RTNType::Good;
   if (m_mode == CompMode::PWE) {
-    m_midtread_inv_quantize();
+    auto timer = Stage_Timer(m_profile, Stage::Outlier);
+    m_midtread_inv_quantize<T>();
     rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
     if (rtn != RTNType::Good)
       return rtn;
     m_inverse_wavelet_xform(false);  // No multi-resolution needed!
     m_vals_d = m_cdf.release_data();
-    auto LOS = std::vector<Outlier>();
-    LOS.reserve(total_vals / 20);  // Reserve space to hold about 5% of total values.
+    // The outlier list comes back from `m_out_coder` after encoding, so its memory is reused
+    //    by the next chunk that this object compresses.
+    m_LOS.clear();
+    if constexpr (profiling)
+      m_profile.bytes_reused += m_LOS.capacity() * sizeof(Outlier);
+    m_LOS.reserve(total_vals / 20);  // Reserve space to hold about 5% of total values.
     for (size_t i = 0; i < total_vals; i++) {
       auto diff = m_vals_orig[i] - m_vals_d[i];
       if (std::abs(diff) > m_quality)
-        LOS.emplace_back(i, diff);
+        m_LOS.emplace_back(i, diff);
     }
-    if (LOS.empty())
+    if (m_LOS.empty())
       m_has_outlier = false;
     else {
       m_has_outlier = true;
       m_out_coder.set_length(total_vals);
       m_out_coder.set_tolerance(m_quality);
-      m_out_coder.use_outlier_list(std::move(LOS));
+      m_out_coder.use_outlier_list(std::move(m_LOS));
       rtn = m_out_coder.encode();
+      m_LOS = m_out_coder.release_outlier_list();
       if (rtn != RTNType::Good)
         return rtn;
     }
@@ -487,55 +656,27 @@ FIXED_RATE_HIGH_PREC_LABEL:
 
   // Step 4: Integer SPECK encoding
   m_instantiate_encoder();
+  auto& encoder = std::get<coder_ptr<T>>(m_encoder);
   if (m_mode == CompMode::Rate) {
     auto budget = static_cast<size_t>(m_quality * double(total_vals));  // total num of bits
-    std::visit([budget](auto&& encoder) { encoder->set_budget(budget); }, m_encoder);
-  }
-  std::visit([&dims = m_dims](auto&& encoder) { encoder->set_dims(dims); }, m_encoder);
-  switch (m_uint_flag) {
-    case UINTType::UINT8:
-      assert(m_vals_ui.index() == 0);
-      assert(m_encoder.index() == 0);
-      rtn = std::get<0>(m_encoder)->use_coeffs(std::move(std::get<0>(m_vals_ui)),
-                                               std::move(m_sign_array));
-      break;
-    case UINTType::UINT16:
-      assert(m_vals_ui.index() == 1);
-      assert(m_encoder.index() == 1);
-      rtn = std::get<1>(m_encoder)->use_coeffs(std::move(std::get<1>(m_vals_ui)),
-                                               std::move(m_sign_array));
-      break;
-    case UINTType::UINT32:
-      assert(m_vals_ui.index() == 2);
-      assert(m_encoder.index() == 2);
-      rtn = std::get<2>(m_encoder)->use_coeffs(std::move(std::get<2>(m_vals_ui)),
-                                               std::move(m_sign_array));
-      break;
-    default:
-      assert(m_vals_ui.index() == 3);
-      assert(m_encoder.index() == 3);
-      rtn = std::get<3>(m_encoder)->use_coeffs(std::move(std::get<3>(m_vals_ui)),
-                                               std::move(m_sign_array));
+    encoder->set_budget(budget);
   }
+  encoder->set_dims(m_dims);
+  rtn = encoder->use_coeffs(std::move(vals_ui), std::move(m_sign_array), T(m_max_ui));
   if (rtn != RTNType::Good)
     return rtn;
+  rtn = encoder->encode();
+  if (rtn != RTNType::Good)
+    return rtn;
+  m_profile.merge(encoder->view_profile());
 
-  std::visit([](auto&& encoder) { encoder->encode(); }, m_encoder);
+  // Take back the integer coefficients and signs from the encoder, so the next compression
+  //    reuses their memory instead of allocating it again.
+  vals_ui = encoder->release_coeffs();
+  m_sign_array = encoder->release_signs();
 
-  // In CompMode::Rate mode, we see if there's enough bits produced. If not, we adjust `m_q`
-  //    so quantiztion is done with a higher precision.
-  //    Btw I know that GOTO should be used very sparsely and with great caution. I think this
-  //    is one place where it's making the code most clean and not introducing additional risks.
-  //
-  if (m_mode == CompMode::Rate && high_prec == false) {
-    assert(m_encoder.index() == 2);
-    auto budget = static_cast<size_t>(m_quality * double(total_vals));
-    auto actual = std::get<2>(m_encoder)->encoded_bitstream_len() * size_t{8};
-    if (actual < budget) {
-      high_prec = true;
-      goto FIXED_RATE_HIGH_PREC_LABEL;
-    }
-  }
+  if (m_rd_enabled)
+    m_build_rd_table<T>(msb_counts, msb_sumsq);
 
   return RTNType::Good;
 }
@@ -544,36 +685,128 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
 {
   m_vals_d.clear();
   // m_hierarchy.clear(); // Intentionally not clearing, reusing already-allocated memory.
-  std::visit([](auto&& vec) { vec.clear(); }, m_vals_ui);
   m_sign_array.resize(0);
+  m_profile_reset();
 
   // `m_condi_bitstream` might be indicating a constant field, so let's see if that's
   // the case, and if it is, we don't need to go through wavelet and speck stuff anymore.
   if (m_conditioner.is_constant(m_condi_bitstream[0])) {
+    auto timer = Stage_Timer(m_profile, Stage::Condition);
     auto rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
     return rtn;
   }
 
+  assert(m_q > 0.0);
+  return m_dispatch_uint(
+      [this, multi_res](auto zero) { return m_decode_ints<decltype(zero)>(multi_res); });
+}
+
+template <typename T>
+auto sperr::SPECK_FLT::m_decode_ints(bool multi_res) -> RTNType
+{
   // Step 1: Integer SPECK decode.
   // Note: the decoder has already parsed the bitstream in function `use_bitstream()`.
-  assert(m_q > 0.0);
-  std::visit([dims = m_dims](auto&& decoder) { decoder->set_dims(dims); }, m_decoder);
-  std::visit([](auto&& decoder) { decoder->decode(); }, m_decoder);
-  std::visit([&vec = m_vals_ui](auto&& dec) { vec = dec->release_coeffs(); }, m_decoder);
-  m_sign_array = std::visit([](auto&& dec) { return dec->release_signs(); }, m_decoder);
+  auto& decoder = std::get<coder_ptr<T>>(m_decoder);
+  decoder->set_dims(m_dims);
+  auto rtn = decoder->decode();
+  if (rtn != RTNType::Good)
+    return rtn;
+  m_profile.merge(decoder->view_profile());
 
-  // Step 2: Inverse quantization
-  m_midtread_inv_quantize();
+  return m_reconstruct<T>(multi_res);
+}
 
-  // Step 3: Inverse wavelet transform
-  auto rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
+void sperr::SPECK_FLT::set_resumable(bool resumable)
+{
+  m_resumable = resumable;
+  m_dispatch_uint([resumable, this](auto zero) {
+    auto& decoder = std::get<coder_ptr<decltype(zero)>>(m_decoder);
+    if (decoder)
+      decoder->set_resumable(resumable);
+  });
+}
+
+auto sperr::SPECK_FLT::refine(const void* p, size_t len, bool multi_res) -> RTNType
+{
+  // Resuming is possible only if the integer SPECK decoder has a checkpoint, and the incoming
+  //    bitstream has the same conditioner stream as the one decoded before.
+  const auto* const ptr = static_cast<const uint8_t*>(p);
+  const auto condi_len = m_condi_bitstream.size();
+  auto can_resume = len >= condi_len + SPECK_INT<uint8_t>::header_size &&
+                    std::equal(ptr, ptr + condi_len, m_condi_bitstream.cbegin()) &&
+                    !m_conditioner.is_constant(m_condi_bitstream[0]);
+  if (!can_resume)
+    return m_start_over(p, len, multi_res);
+
+  return m_dispatch_uint([this, p, len, multi_res](auto zero) {
+    return m_refine_ints<decltype(zero)>(p, len, multi_res);
+  });
+}
+
+template <typename T>
+auto sperr::SPECK_FLT::m_refine_ints(const void* p, size_t len, bool multi_res) -> RTNType
+{
+  auto& decoder = std::get<coder_ptr<T>>(m_decoder);
+  if (decoder == nullptr || !decoder->can_resume())
+    return m_start_over(p, len, multi_res);
+
+  m_vals_d.clear();
+  m_sign_array.resize(0);
+  m_profile_reset();
+
+  // Step 1: resume integer SPECK decoding with more bits.
+  const auto condi_len = m_condi_bitstream.size();
+  const uint8_t* const speck_p = static_cast<const uint8_t*>(p) + condi_len;
+  const auto remaining_len = len - condi_len;
+  auto speck_len = std::min(size_t{decoder->get_stream_full_len(speck_p)}, remaining_len);
+  auto rtn = decoder->decode_more(speck_p, speck_len);
+  if (rtn != RTNType::Good)  // Not the same SPECK bitstream; start over.
+    return m_start_over(p, len, multi_res);
+  m_profile.merge(decoder->view_profile());
+
+  // The outlier coder stream might have become available too.
+  rtn = m_parse_outlier_stream(speck_p + speck_len, remaining_len - speck_len);
   if (rtn != RTNType::Good)
     return rtn;
-  m_inverse_wavelet_xform(multi_res);
-  m_vals_d = m_cdf.release_data();
+
+  return m_reconstruct<T>(multi_res);
+}
+
+auto sperr::SPECK_FLT::m_start_over(const void* p, size_t len, bool multi_res) -> RTNType
+{
+  auto rtn = use_bitstream(p, len);
+  if (rtn != RTNType::Good)
+    return rtn;
+  return decompress(multi_res);
+}
+
+template <typename T>
+auto sperr::SPECK_FLT::m_reconstruct(bool multi_res) -> RTNType
+{
+  auto& decoder = std::get<coder_ptr<T>>(m_decoder);
+  std::get<uninit_vec_type<T>>(m_vals_ui) = decoder->release_coeffs();
+  m_sign_array = decoder->release_signs();
+
+  // Step 2: Inverse quantization
+  {
+    auto timer = Stage_Timer(m_profile, Stage::Quantize);
+    m_midtread_inv_quantize<T>();
+  }
+
+  // Step 3: Inverse wavelet transform
+  auto rtn = RTNType::Good;
+  {
+    auto timer = Stage_Timer(m_profile, Stage::DWT);
+    rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
+    if (rtn != RTNType::Good)
+      return rtn;
+    m_inverse_wavelet_xform(multi_res);
+    m_vals_d = m_cdf.release_data();
+  }
 
   // Side step: outlier correction, if needed
   if (m_has_outlier) {
+    auto timer = Stage_Timer(m_profile, Stage::Outlier);
     m_out_coder.set_length(m_dims[0] * m_dims[1] * m_dims[2]);
     m_out_coder.set_tolerance(m_q / 1.5);  // `m_quality` is not set during decompression.
     rtn = m_out_coder.decode();
@@ -585,6 +818,7 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
   }
 
   // Step 4: Inverse Conditioning
+  auto timer = Stage_Timer(m_profile, Stage::Condition);
   rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
   if (rtn != RTNType::Good)
     return rtn;
@@ -602,5 +836,16 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
     }
   }
 
+  m_profile_memory();
   return RTNType::Good;
 }
+
+// The quantizers are also exercised on their own by the benchmarks.
+template void sperr::SPECK_FLT::m_midtread_quantize<uint8_t>();
+template void sperr::SPECK_FLT::m_midtread_quantize<uint16_t>();
+template void sperr::SPECK_FLT::m_midtread_quantize<uint32_t>();
+template void sperr::SPECK_FLT::m_midtread_quantize<uint64_t>();
+template void sperr::SPECK_FLT::m_midtread_inv_quantize<uint8_t>();
+template void sperr::SPECK_FLT::m_midtread_inv_quantize<uint16_t>();
+template void sperr::SPECK_FLT::m_midtread_inv_quantize<uint32_t>();
+template void sperr::SPECK_FLT::m_midtread_inv_quantize<uint64_t>();
@@ -5,10 +5,6 @@
 #include <cstring>
 #include <numeric>
 
-#if __cplusplus >= 202002L
-#include <bit>
-#endif
-
 //
 // Free-standing helper function
 //
@@ -108,13 +104,18 @@ void sperr::SPECK_INT<T>::use_bitstream(const void* p, size_t len)
 }
 
 template <typename T>
-void sperr::SPECK_INT<T>::encode()
+auto sperr::SPECK_INT<T>::encode() -> RTNType
 {
+  if (!m_dims_supported())
+    return RTNType::Error;
+
   m_initialize_lists();
   const auto coeff_len = m_dims[0] * m_dims[1] * m_dims[2];
   m_bit_buffer.reserve(coeff_len);  // A good starting point
   m_bit_buffer.rewind();
   m_total_bits = 0;
+  m_bitplane_ends.clear();
+  m_profile = Profile();
 
   // Mark every coefficient as insignificant
   m_LSP_mask.resize(coeff_len);
@@ -124,16 +125,22 @@ void sperr::SPECK_INT<T>::encode()
   m_LIP_mask.resize(coeff_len);
   m_LIP_mask.reset();
 
+  // Find the biggest coefficient, unless it's already provided by the caller.
+  if (!m_max_coeff)
+    m_max_coeff = *std::max_element(m_coeff_buf.cbegin(), m_coeff_buf.cend());
+  const auto max_coeff = *m_max_coeff;
+  m_max_coeff.reset();  // It's only good for the current set of coefficients.
+  assert(max_coeff == *std::max_element(m_coeff_buf.cbegin(), m_coeff_buf.cend()));
+
   // Treat it as a special case when all coeffs (m_coeff_buf) are zero.
   //    In such a case, we mark `m_num_bitplanes` as zero.
   //    Of course, `m_total_bits` is also zero.
-  if (std::all_of(m_coeff_buf.cbegin(), m_coeff_buf.cend(), [](auto v) { return v == 0; })) {
+  if (max_coeff == 0) {
     m_num_bitplanes = 0;
-    return;
+    return RTNType::Good;
   }
 
   // Decide the starting threshold.
-  const auto max_coeff = *std::max_element(m_coeff_buf.cbegin(), m_coeff_buf.cend());
   m_num_bitplanes = 1;
   m_threshold = 1;
   // !! Careful loop condition so no integer overflow !!
@@ -145,11 +152,12 @@ void sperr::SPECK_INT<T>::encode()
   // Marching over bitplanes.
   for (uint8_t bitplane = 0; bitplane < m_num_bitplanes; bitplane++) {
     m_bitplane_init();
-    m_sorting_pass();
+    m_sorting_pass_profiled(true);
     if (m_bit_buffer.wtell() >= m_budget)  // Happens only when fixed-rate compression.
       break;
 
-    m_refinement_pass_encode();
+    m_refinement_pass_profiled(true);
+    m_bitplane_ends.push_back(m_bit_buffer.wtell());
     if (m_bit_buffer.wtell() >= m_budget)  // Happens only when fixed-rate compression.
       break;
 
@@ -160,13 +168,21 @@ void sperr::SPECK_INT<T>::encode()
   // Record the total number of bits produced, and flush the stream.
   m_total_bits = m_bit_buffer.wtell();
   m_bit_buffer.flush();
+  m_profile_memory();
+
+  return RTNType::Good;
 }
 
 template <typename T>
-void sperr::SPECK_INT<T>::decode()
+auto sperr::SPECK_INT<T>::decode() -> RTNType
 {
+  m_has_checkpoint = false;
+  if (!m_dims_supported())
+    return RTNType::Error;
+
   m_initialize_lists();
   m_bit_buffer.rewind();
+  m_profile = Profile();
 
   // initialize coefficients to be zero, and sign array to be all positive
   const auto coeff_len = m_dims[0] * m_dims[1] * m_dims[2];
@@ -186,7 +202,7 @@ void sperr::SPECK_INT<T>::decode()
   // This case is indicated by both `m_num_bitplanes` and `m_total_bits` equal zero.
   if (m_num_bitplanes == 0) {
     assert(m_total_bits == 0);
-    return;
+    return RTNType::Good;
   }
 
   // Restore the biggest `m_threshold`.
@@ -194,19 +210,78 @@ void sperr::SPECK_INT<T>::decode()
   for (uint8_t i = 1; i < m_num_bitplanes; i++)
     m_threshold *= uint_type{2};
 
+  m_decode_bitplanes(0);
+
+  return RTNType::Good;
+}
+
+template <typename T>
+auto sperr::SPECK_INT<T>::decode_more(const void* p, size_t len) -> RTNType
+{
+  if (!m_has_checkpoint)
+    return RTNType::Error;
+
+  // The header needs to stay the same; only more bits become available.
+  const auto total_bits = m_total_bits;
+  const auto num_bitplanes = m_num_bitplanes;
+  const auto avail_bits = m_avail_bits;
+  use_bitstream(p, len);
+  if (m_total_bits != total_bits || m_num_bitplanes != num_bitplanes || m_avail_bits < avail_bits) {
+    m_has_checkpoint = false;
+    return RTNType::Error;
+  }
+
+  m_restore_checkpoint();
+  m_decode_bitplanes(m_ckpt_bitplane);
+
+  return RTNType::Good;
+}
+
+template <typename T>
+auto sperr::SPECK_INT<T>::can_resume() const -> bool
+{
+  return m_has_checkpoint;
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::set_resumable(bool resumable)
+{
+  m_resumable = resumable;
+  if (!m_resumable) {
+    m_has_checkpoint = false;
+    m_ckpt_coeff_buf = vecui_type();
+    m_ckpt_LSP_mask = Bitmask();
+    m_ckpt_LIP_mask = Bitmask();
+    m_ckpt_sign_array = Bitmask();
+  }
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::m_decode_bitplanes(uint8_t first_bitplane)
+{
+  // Only a partial bitstream might run out of bits, so only then a checkpoint is needed.
+  //    Keeping a checkpoint costs a copy of the decoder's state at every bitplane, so it's only
+  //    kept when the caller asks for a resumable decoder.
+  const bool partial = m_resumable && (m_avail_bits < m_total_bits);
+  m_has_checkpoint = false;
+
   // Marching over bitplanes.
-  for (uint8_t bitplane = 0; bitplane < m_num_bitplanes; bitplane++) {
-    m_sorting_pass();
+  for (uint8_t bitplane = first_bitplane; bitplane < m_num_bitplanes; bitplane++) {
+    if (partial)
+      m_save_checkpoint(bitplane);
+
+    m_sorting_pass_profiled(false);
     if (m_bit_buffer.rtell() >= m_avail_bits)  // Happens when a partial bitstream is available,
       break;                                   // because of progressive decoding or fixed-rate.
 
-    m_refinement_pass_decode();
+    m_refinement_pass_profiled(false);
     if (m_bit_buffer.rtell() >= m_avail_bits)  // Happens when a partial bitstream is available,
       break;                                   // because of progressive decoding or fixed-rate.
 
     m_threshold /= uint_type{2};
     m_clean_LIS();
   }
+  m_has_checkpoint = partial;
 
   // The majority of newly identified significant points are initialized by the refinement pass.
   //    However, if the loop breaks after executing the sorting pass, then it leaves newly
@@ -225,6 +300,36 @@ void sperr::SPECK_INT<T>::decode()
     assert(m_bit_buffer.rtell() >= m_avail_bits);
     assert(m_bit_buffer.rtell() <= m_total_bits);
   }
+  m_profile_memory();
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::m_save_checkpoint(uint8_t bitplane)
+{
+  // At the beginning of a bitplane, all newly significant points have been processed.
+  assert(m_LSP_new.empty());
+
+  m_ckpt_bitplane = bitplane;
+  m_ckpt_threshold = m_threshold;
+  m_ckpt_bit_pos = m_bit_buffer.rtell();
+  m_ckpt_coeff_buf = m_coeff_buf;  // Copy assignments reuse the already-allocated memory.
+  m_ckpt_LSP_mask = m_LSP_mask;
+  m_ckpt_LIP_mask = m_LIP_mask;
+  m_ckpt_sign_array = m_sign_array;
+  m_save_lists();
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::m_restore_checkpoint()
+{
+  m_threshold = m_ckpt_threshold;
+  m_bit_buffer.rseek(m_ckpt_bit_pos);
+  m_coeff_buf = m_ckpt_coeff_buf;
+  m_LSP_mask = m_ckpt_LSP_mask;
+  m_LIP_mask = m_ckpt_LIP_mask;
+  m_sign_array = m_ckpt_sign_array;
+  m_LSP_new.clear();
+  m_restore_lists();
 }
 
 template <typename T>
@@ -234,9 +339,20 @@ auto sperr::SPECK_INT<T>::use_coeffs(vecui_type coeffs, Bitmask signs) -> RTNTyp
     return RTNType::Error;
   m_coeff_buf = std::move(coeffs);
   m_sign_array = std::move(signs);
+  m_max_coeff.reset();
   return RTNType::Good;
 }
 
+template <typename T>
+auto sperr::SPECK_INT<T>::use_coeffs(vecui_type coeffs, Bitmask signs, uint_type max_coeff)
+    -> RTNType
+{
+  auto rtn = use_coeffs(std::move(coeffs), std::move(signs));
+  if (rtn == RTNType::Good)
+    m_max_coeff = max_coeff;
+  return rtn;
+}
+
 template <typename T>
 auto sperr::SPECK_INT<T>::release_coeffs() -> vecui_type&&
 {
@@ -281,6 +397,64 @@ auto sperr::SPECK_INT<T>::encoded_bitstream_len() const -> size_t
   return (header_size + bit_in_byte);
 }
 
+template <typename T>
+auto sperr::SPECK_INT<T>::view_bitplane_ends() const -> const std::vector<uint64_t>&
+{
+  return m_bitplane_ends;
+}
+
+template <typename T>
+auto sperr::SPECK_INT<T>::view_profile() const -> const Profile&
+{
+  return m_profile;
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::m_sorting_pass_profiled(bool encoding)
+{
+  auto timer = Stage_Timer(m_profile, Stage::Sorting);
+  [[maybe_unused]] const auto start = (encoding ? m_bit_buffer.wtell() : m_bit_buffer.rtell());
+  if constexpr (profiling)
+    m_profile.lis_sizes.push_back(m_LIS_stats()[0]);
+
+  m_sorting_pass();
+
+  if constexpr (profiling) {
+    const auto end = (encoding ? m_bit_buffer.wtell() : m_bit_buffer.rtell());
+    m_profile.sorting_bits.push_back(end - start);
+    m_profile.significant.push_back(m_LSP_new.size());
+  }
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::m_refinement_pass_profiled(bool encoding)
+{
+  auto timer = Stage_Timer(m_profile, Stage::Refinement);
+  [[maybe_unused]] const auto start = (encoding ? m_bit_buffer.wtell() : m_bit_buffer.rtell());
+
+  if (encoding)
+    m_refinement_pass_encode();
+  else
+    m_refinement_pass_decode();
+
+  if constexpr (profiling) {
+    const auto end = (encoding ? m_bit_buffer.wtell() : m_bit_buffer.rtell());
+    m_profile.refinement_bits.push_back(end - start);
+  }
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::m_profile_memory()
+{
+  if constexpr (profiling) {
+    const auto masks = m_LSP_mask.view_buffer().capacity() + m_LIP_mask.view_buffer().capacity() +
+                       m_sign_array.view_buffer().capacity();
+    m_profile.bytes_allocated = m_coeff_buf.capacity() * sizeof(uint_type) +
+                                m_LSP_new.capacity() * sizeof(uint64_t) + masks * sizeof(uint64_t) +
+                                m_bit_buffer.capacity() / 8 + m_LIS_stats()[1];
+  }
+}
+
 template <typename T>
 void sperr::SPECK_INT<T>::append_encoded_bitstream(vec8_type& buffer) const
 {
@@ -313,37 +487,10 @@ void sperr::SPECK_INT<T>::m_refinement_pass_encode()
   // First, process significant pixels previously found.
   //
   const auto tmp1 = std::array<uint_type, 2>{uint_type{0}, m_threshold};
-  const auto bits_x64 = m_LSP_mask.size() - m_LSP_mask.size() % 64;
-
-  for (size_t i = 0; i < bits_x64; i += 64) {  // Evaluate 64 bits at a time.
-    auto value = m_LSP_mask.rlong(i);
-
-#if __cplusplus >= 202002L
-    while (value) {
-      auto j = std::countr_zero(value);
-      const bool o1 = m_coeff_buf[i + j] >= m_threshold;
-      m_coeff_buf[i + j] -= tmp1[o1];
-      m_bit_buffer.wbit(o1);
-      value &= value - 1;
-    }
-#else
-    if (value != 0) {
-      for (size_t j = 0; j < 64; j++) {
-        if ((value >> j) & uint64_t{1}) {
-          const bool o1 = m_coeff_buf[i + j] >= m_threshold;
-          m_coeff_buf[i + j] -= tmp1[o1];
-          m_bit_buffer.wbit(o1);
-        }
-      }
-    }
-#endif
-  }
-  for (auto i = bits_x64; i < m_LSP_mask.size(); i++) {  // Evaluate the remaining bits.
-    if (m_LSP_mask.rbit(i)) {
-      const bool o1 = m_coeff_buf[i] >= m_threshold;
-      m_coeff_buf[i] -= tmp1[o1];
-      m_bit_buffer.wbit(o1);
-    }
+  for (auto i : m_LSP_mask.true_bits()) {
+    const bool o1 = m_coeff_buf[i] >= m_threshold;
+    m_coeff_buf[i] -= tmp1[o1];
+    m_bit_buffer.wbit(o1);
   }
 
   // Second, deal with newly found significant pixels in `m_LSP_mask`.
@@ -364,88 +511,31 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
   //    Here's a documentation of their purposes.
   // 1) The decoding scheme (reconstructing values at the middle of an interval) requires
   //    different treatment when `m_threshold` is 1 or not.
-  // 2) We make use of the internal representation of `m_LSP_mask` and evaluate 64 bits at time.
-  //    This requires evaluating any remaining bits not divisible by 64.
+  // 2) `m_LSP_mask.true_bits()` visits significant points in order, and it skips long runs of
+  //    insignificant points quickly.
   // 3) During progressive or fixed-rate decoding, we need to evaluate if the bitstream is
   //    exhausted after every read. We test it no matter what decoding mode we're in though.
   // 4) goto is used again. Here's it's used to jump out of a nested loop, which is an endorsed
   //    usage of it: https://isocpp.github.io/CppCoreGuidelines/CppCoreGuidelines#Res-goto
   //
   auto read_pos = m_bit_buffer.rtell();  // Avoid repeated calls to rtell().
-  const auto bits_x64 = m_LSP_mask.size() - m_LSP_mask.size() % 64;  // <-- Point 2
-  if (m_threshold >= uint_type{2}) {                                 // <-- Point 1
+  if (m_threshold >= uint_type{2}) {  // <-- Point 1
     const auto half_t = m_threshold / uint_type{2};
-    for (size_t i = 0; i < bits_x64; i += 64) {  // <-- Point 2
-      auto value = m_LSP_mask.rlong(i);
-
-#if __cplusplus >= 202002L
-      while (value) {
-        auto j = std::countr_zero(value);
-        if (m_bit_buffer.rbit())
-          m_coeff_buf[i + j] += half_t;
-        else
-          m_coeff_buf[i + j] -= half_t;
-        if (++read_pos == m_avail_bits)              // <-- Point 3
-          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
-        value &= value - 1;
-      }
-#else
-      if (value != 0) {
-        for (size_t j = 0; j < 64; j++) {
-          if ((value >> j) & uint64_t{1}) {
-            if (m_bit_buffer.rbit())
-              m_coeff_buf[i + j] += half_t;
-            else
-              m_coeff_buf[i + j] -= half_t;
-            if (++read_pos == m_avail_bits)              // <-- Point 3
-              goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
-          }
-        }
-      }
-#endif
-    }
-    for (auto i = bits_x64; i < m_LSP_mask.size(); i++) {  // <-- Point 2
-      if (m_LSP_mask.rbit(i)) {
-        if (m_bit_buffer.rbit())
-          m_coeff_buf[i] += half_t;
-        else
-          m_coeff_buf[i] -= half_t;
-        if (++read_pos == m_avail_bits)              // <-- Point 3
-          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
-      }
+    for (auto i : m_LSP_mask.true_bits()) {  // <-- Point 2
+      if (m_bit_buffer.rbit())
+        m_coeff_buf[i] += half_t;
+      else
+        m_coeff_buf[i] -= half_t;
+      if (++read_pos == m_avail_bits)              // <-- Point 3
+        goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
     }
   }  // Finish the case where `m_threshold >= 2`.
   else {  // Start the case where `m_threshold == 1`.
-    for (size_t i = 0; i < bits_x64; i += 64) {
-      auto value = m_LSP_mask.rlong(i);
-
-#if __cplusplus >= 202002L
-      while (value) {
-        auto j = std::countr_zero(value);
-        if (m_bit_buffer.rbit())
-          ++(m_coeff_buf[i + j]);
-        if (++read_pos == m_avail_bits)
-          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
-        value &= value - 1;
-      }
-#else
-      for (size_t j = 0; j < 64; j++) {
-        if ((value >> j) & uint64_t{1}) {
-          if (m_bit_buffer.rbit())
-            ++(m_coeff_buf[i + j]);
-          if (++read_pos == m_avail_bits)
-            goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
-        }
-      }
-#endif
-    }
-    for (auto i = bits_x64; i < m_LSP_mask.size(); i++) {
-      if (m_LSP_mask.rbit(i)) {
-        if (m_bit_buffer.rbit())
-          ++(m_coeff_buf[i]);
-        if (++read_pos == m_avail_bits)
-          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
-      }
+    for (auto i : m_LSP_mask.true_bits()) {
+      if (m_bit_buffer.rbit())
+        ++(m_coeff_buf[i]);
+      if (++read_pos == m_avail_bits)
+        goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
     }
   }
   assert(m_bit_buffer.rtell() <= m_avail_bits);
@@ -0,0 +1,197 @@
+#include "SPERR1D_OMP_C.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>  // std::accumulate()
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR1D_OMP_C::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+void sperr::SPERR1D_OMP_C::set_length_and_segment(size_t len, size_t segment_len)
+{
+  m_len = len;
+
+  // The segment length has to be between 1 and `len`, and fit in 32 bits.
+  segment_len = std::min(segment_len, size_t{std::numeric_limits<uint32_t>::max()});
+  m_segment_len = std::min(std::max(size_t{1}, segment_len), std::max(size_t{1}, len));
+}
+
+void sperr::SPERR1D_OMP_C::set_psnr(double psnr)
+{
+  assert(psnr > 0.0);
+  m_mode = CompMode::PSNR;
+  m_quality = psnr;
+}
+
+void sperr::SPERR1D_OMP_C::set_tolerance(double pwe)
+{
+  assert(pwe > 0.0);
+  m_mode = CompMode::PWE;
+  m_quality = pwe;
+}
+
+void sperr::SPERR1D_OMP_C::set_bitrate(double bpp)
+{
+  assert(bpp > 0.0);
+  m_mode = CompMode::Rate;
+  m_quality = bpp;
+}
+
+template <typename T>
+auto sperr::SPERR1D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
+{
+  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
+  m_orig_is_float = std::is_same<T, float>::value;
+
+  if (m_mode == sperr::CompMode::Unknown)
+    return RTNType::CompModeUnknown;
+  if (m_len == 0)
+    return RTNType::Error;
+  if (buf_len != m_len)
+    return RTNType::WrongLength;
+
+  const auto num_segs = (m_len + m_segment_len - 1) / m_segment_len;
+  auto seg_rtn = std::vector<RTNType>(num_segs, RTNType::Good);
+  m_encoded_streams.resize(num_segs);
+
+#ifdef USE_OMP
+  m_compressors.resize(m_num_threads);
+  for (auto& p : m_compressors) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK1D_FLT>();
+  }
+#else
+  if (m_compressor == nullptr)
+    m_compressor = std::make_unique<SPECK1D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_segs; i++) {
+#ifdef USE_OMP
+    auto& compressor = m_compressors[omp_get_thread_num()];
+#else
+    auto& compressor = m_compressor;
+#endif
+
+    const auto seg_start = i * m_segment_len;
+    const auto seg_len = std::min(m_segment_len, m_len - seg_start);
+    compressor->copy_data(buf + seg_start, seg_len);
+    compressor->set_dims({seg_len, 1, 1});
+    switch (m_mode) {
+      case CompMode::PSNR:
+        compressor->set_psnr(m_quality);
+        break;
+      case CompMode::PWE:
+        compressor->set_tolerance(m_quality);
+        break;
+      case CompMode::Rate:
+        compressor->set_bitrate(m_quality);
+        break;
+      default:;  // So the compiler doesn't complain about missing cases.
+    }
+    seg_rtn[i] = compressor->compress();
+
+    // Save bitstream for each segment in `m_encoded_stream`.
+    m_encoded_streams[i].clear();
+    compressor->append_encoded_bitstream(m_encoded_streams[i]);
+  }
+
+  auto fail = std::find_if_not(seg_rtn.begin(), seg_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != seg_rtn.end())
+    return (*fail);
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR1D_OMP_C::compress(const float*, size_t) -> RTNType;
+template auto sperr::SPERR1D_OMP_C::compress(const double*, size_t) -> RTNType;
+
+auto sperr::SPERR1D_OMP_C::get_encoded_bitstream() const -> vec8_type
+{
+  auto header = m_generate_header();
+  if (header.empty())
+    return header;
+  auto header_size = header.size();
+  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
+                                     [](size_t a, const auto& b) { return a + b.size(); });
+  header.resize(header_size + stream_size);
+
+  auto itr = header.begin() + header_size;
+  for (const auto& s : m_encoded_streams) {
+    std::copy(s.cbegin(), s.cend(), itr);
+    itr += s.size();
+  }
+
+  return header;
+}
+
+auto sperr::SPERR1D_OMP_C::m_generate_header() const -> sperr::vec8_type
+{
+  auto header = sperr::vec8_type();
+
+  // The header would contain the following information
+  //  -- a version number                     (1 byte)
+  //  -- 8 booleans                           (1 byte)
+  //  -- array length                         (8 bytes)
+  //  -- segment length                       (4 bytes)
+  //  -- length of bitstream for each segment (4 x num_segments)
+  //
+  const auto num_segs = m_encoded_streams.size();
+  if (num_segs == 0 || num_segs != (m_len + m_segment_len - 1) / m_segment_len)
+    return header;
+  const auto header_size = m_header_magic + num_segs * 4;
+  header.resize(header_size);
+
+  // Version number
+  header[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  size_t pos = 1;
+
+  // 8 booleans:
+  // bool[0]  : if this bitstream is a portion of another complete bitstream (progressive access).
+  // bool[1]  : if this bitstream is for 3D (true) or 2D (false) data.
+  // bool[2]  : if the original data is float (true) or double (false).
+  // bool[3]  : if there are multiple 2D slices; see SPERR2D_OMP_C.
+  // bool[4]  : if this bitstream is for 1D data.
+  // bool[5-7]: unused
+  //
+  const auto b8 = std::array<bool, 8>{false,  // not a portion
+                                      false,  // not 3D
+                                      m_orig_is_float,
+                                      false,   // not 2D slices
+                                      true,    // 1D
+                                      false,   // unused
+                                      false,   // unused
+                                      false};  // unused
+  header[pos++] = sperr::pack_8_booleans(b8);
+
+  // Array length and segment length
+  const auto len = uint64_t{m_len};
+  std::memcpy(&header[pos], &len, sizeof(len));
+  pos += sizeof(len);
+  const auto seg_len = static_cast<uint32_t>(m_segment_len);
+  std::memcpy(&header[pos], &seg_len, sizeof(seg_len));
+  pos += sizeof(seg_len);
+
+  // Length of bitstream for each segment.
+  for (const auto& stream : m_encoded_streams) {
+    assert(stream.size() <= uint64_t{std::numeric_limits<uint32_t>::max()});
+    uint32_t slen = stream.size();
+    std::memcpy(&header[pos], &slen, sizeof(slen));
+    pos += sizeof(slen);
+  }
+  assert(pos == header_size);
+
+  return header;
+}
@@ -0,0 +1,160 @@
+#include "SPERR1D_OMP_D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR1D_OMP_D::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+auto sperr::SPERR1D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTNType
+{
+  // This method gathers information from the header.
+  //    It does NOT, however, read the actual bitstream. The actual bitstream
+  //    will be provided when the decompress() method is called.
+  //    The header definition is in SPERR1D_OMP_C.cpp::m_generate_header().
+  //
+  m_bitstream_ptr = nullptr;
+  m_offsets.clear();
+  if (total_len < m_header_magic)
+    return RTNType::WrongLength;
+
+  const auto* const u8p = static_cast<const uint8_t*>(p);
+  if (u8p[0] != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  const auto b8 = sperr::unpack_8_booleans(u8p[1]);
+  if (b8[1] || !b8[4])  // Needs to be 1D.
+    return RTNType::SliceVolumeMismatch;
+
+  auto len = uint64_t{0};
+  auto seg_len = uint32_t{0};
+  std::memcpy(&len, u8p + 2, sizeof(len));
+  std::memcpy(&seg_len, u8p + 10, sizeof(seg_len));
+  if (len == 0 || seg_len == 0)
+    return RTNType::Error;
+  m_len = len;
+  m_segment_len = seg_len;
+
+  const auto num_segs = (m_len + m_segment_len - 1) / m_segment_len;
+  const auto header_size = m_header_magic + num_segs * 4;
+  if (total_len < header_size)
+    return RTNType::WrongLength;
+
+  // Figure out the offset and length of each segment.
+  m_offsets.resize(num_segs * 2);
+  size_t offset = header_size;
+  for (size_t i = 0; i < num_segs; i++) {
+    uint32_t slen = 0;
+    std::memcpy(&slen, u8p + m_header_magic + i * 4, sizeof(slen));
+    m_offsets[i * 2] = offset;
+    m_offsets[i * 2 + 1] = slen;
+    offset += slen;
+  }
+  if (offset != total_len)
+    return RTNType::WrongLength;
+
+  // Finally, we keep a copy of the bitstream pointer
+  m_bitstream_ptr = u8p;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR1D_OMP_D::decompress(const void* p) -> RTNType
+{
+  return decompress_range(p, 0, m_len);
+}
+
+auto sperr::SPERR1D_OMP_D::decompress_range(const void* p, size_t start, size_t len) -> RTNType
+{
+  if (p == nullptr || m_bitstream_ptr == nullptr)
+    return RTNType::Error;
+  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+    return RTNType::Error;
+  if (len == 0 || start >= m_len || len > m_len - start)
+    return RTNType::Error;
+
+  // Only decode segments that overlap with the requested range.
+  const auto first_seg = start / m_segment_len;
+  const auto last_seg = (start + len - 1) / m_segment_len;
+  const auto num_segs = last_seg - first_seg + 1;
+  m_decoded_buf.resize(len);
+  auto seg_rtn = std::vector<RTNType>(num_segs * 2, RTNType::Good);
+
+#ifdef USE_OMP
+  m_decompressors.resize(m_num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK1D_FLT>();
+  });
+#else
+  if (m_decompressor == nullptr)
+    m_decompressor = std::make_unique<SPECK1D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_segs; i++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    const auto seg = first_seg + i;
+    const auto seg_start = seg * m_segment_len;
+    const auto seg_len = std::min(m_segment_len, m_len - seg_start);
+    decompressor->set_dims({seg_len, 1, 1});
+    seg_rtn[i * 2] =
+        decompressor->use_bitstream(m_bitstream_ptr + m_offsets[seg * 2], m_offsets[seg * 2 + 1]);
+    seg_rtn[i * 2 + 1] = decompressor->decompress();
+    const auto& vals = decompressor->view_decoded_data();
+    if (vals.size() != seg_len) {
+      if (seg_rtn[i * 2 + 1] == RTNType::Good)
+        seg_rtn[i * 2 + 1] = RTNType::Error;
+      continue;
+    }
+
+    // Copy the overlapping part of this segment to the output.
+    const auto copy_beg = std::max(start, seg_start);
+    const auto copy_end = std::min(start + len, seg_start + seg_len);
+    std::copy(vals.cbegin() + (copy_beg - seg_start), vals.cbegin() + (copy_end - seg_start),
+              m_decoded_buf.begin() + (copy_beg - start));
+  }
+
+  auto fail = std::find_if_not(seg_rtn.begin(), seg_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != seg_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+
+auto sperr::SPERR1D_OMP_D::view_decoded_data() const -> const vecd_type&
+{
+  return m_decoded_buf;
+}
+
+auto sperr::SPERR1D_OMP_D::release_decoded_data() -> vecd_type&&
+{
+  return std::move(m_decoded_buf);
+}
+
+auto sperr::SPERR1D_OMP_D::get_length() const -> size_t
+{
+  return m_len;
+}
+
+auto sperr::SPERR1D_OMP_D::get_segment_len() const -> size_t
+{
+  return m_segment_len;
+}
@@ -0,0 +1,194 @@
+#include "SPERR2D_OMP_C.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>  // std::accumulate()
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR2D_OMP_C::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+void sperr::SPERR2D_OMP_C::set_dims(dims_type dims)
+{
+  m_dims = dims;
+}
+
+void sperr::SPERR2D_OMP_C::set_psnr(double psnr)
+{
+  assert(psnr > 0.0);
+  m_mode = CompMode::PSNR;
+  m_quality = psnr;
+}
+
+void sperr::SPERR2D_OMP_C::set_tolerance(double pwe)
+{
+  assert(pwe > 0.0);
+  m_mode = CompMode::PWE;
+  m_quality = pwe;
+}
+
+void sperr::SPERR2D_OMP_C::set_bitrate(double bpp)
+{
+  assert(bpp > 0.0);
+  m_mode = CompMode::Rate;
+  m_quality = bpp;
+}
+
+template <typename T>
+auto sperr::SPERR2D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
+{
+  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
+  m_orig_is_float = std::is_same<T, float>::value;
+
+  if (m_mode == sperr::CompMode::Unknown)
+    return RTNType::CompModeUnknown;
+  if (m_dims[0] == 0 || m_dims[1] == 0 || m_dims[2] == 0)
+    return RTNType::Error;
+  if (buf_len != m_dims[0] * m_dims[1] * m_dims[2])
+    return RTNType::WrongLength;
+
+  const auto slice_len = m_dims[0] * m_dims[1];
+  const auto num_slices = m_dims[2];
+  auto slice_rtn = std::vector<RTNType>(num_slices, RTNType::Good);
+  m_encoded_streams.resize(num_slices);
+
+#ifdef USE_OMP
+  m_compressors.resize(m_num_threads);
+  for (auto& p : m_compressors) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK2D_FLT>();
+  }
+#else
+  if (m_compressor == nullptr)
+    m_compressor = std::make_unique<SPECK2D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_slices; i++) {
+#ifdef USE_OMP
+    auto& compressor = m_compressors[omp_get_thread_num()];
+#else
+    auto& compressor = m_compressor;
+#endif
+
+    // Slices are contiguous in the input buffer, so no gathering is needed.
+    compressor->copy_data(buf + i * slice_len, slice_len);
+    compressor->set_dims({m_dims[0], m_dims[1], 1});
+    switch (m_mode) {
+      case CompMode::PSNR:
+        compressor->set_psnr(m_quality);
+        break;
+      case CompMode::PWE:
+        compressor->set_tolerance(m_quality);
+        break;
+      case CompMode::Rate:
+        compressor->set_bitrate(m_quality);
+        break;
+      default:;  // So the compiler doesn't complain about missing cases.
+    }
+    slice_rtn[i] = compressor->compress();
+
+    // Save bitstream for each slice in `m_encoded_stream`.
+    m_encoded_streams[i].clear();
+    compressor->append_encoded_bitstream(m_encoded_streams[i]);
+  }
+
+  auto fail = std::find_if_not(slice_rtn.begin(), slice_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != slice_rtn.end())
+    return (*fail);
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR2D_OMP_C::compress(const float*, size_t) -> RTNType;
+template auto sperr::SPERR2D_OMP_C::compress(const double*, size_t) -> RTNType;
+
+auto sperr::SPERR2D_OMP_C::get_encoded_bitstream() const -> vec8_type
+{
+  auto header = m_generate_header();
+  if (header.empty())
+    return header;
+  auto header_size = header.size();
+  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
+                                     [](size_t a, const auto& b) { return a + b.size(); });
+  header.resize(header_size + stream_size);
+
+  auto itr = header.begin() + header_size;
+  for (const auto& s : m_encoded_streams) {
+    std::copy(s.cbegin(), s.cend(), itr);
+    itr += s.size();
+  }
+
+  return header;
+}
+
+auto sperr::SPERR2D_OMP_C::m_generate_header() const -> sperr::vec8_type
+{
+  auto header = sperr::vec8_type();
+
+  // The header would contain the following information
+  //  -- a version number                     (1 byte)
+  //  -- 8 booleans                           (1 byte)
+  //  -- slice dimensions                     (4 x 2 = 8 bytes)
+  //  -- number of slices                     (4 bytes)
+  //  -- length of bitstream for each slice   (4 x num_slices)
+  //
+  // Note that the first 10 bytes are laid out the same as the header of a single 2D slice
+  //    produced by the C API `sperr_comp_2d()`.
+  //
+  const auto num_slices = m_dims[2];
+  if (num_slices == 0 || num_slices != m_encoded_streams.size())
+    return header;
+  const auto header_size = m_header_magic + num_slices * 4;
+  header.resize(header_size);
+
+  // Version number
+  header[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  size_t pos = 1;
+
+  // 8 booleans:
+  // bool[0]  : if this bitstream is a portion of another complete bitstream (progressive access).
+  // bool[1]  : if this bitstream is for 3D (true) or 2D (false) data.
+  // bool[2]  : if the original data is float (true) or double (false).
+  // bool[3]  : if there are multiple slices (true) or a single slice (false).
+  // bool[4]  : if this bitstream is for 1D data; see SPERR1D_OMP_C.
+  // bool[5-7]: unused
+  //
+  const auto b8 = std::array<bool, 8>{false,  // not a portion
+                                      false,  // 2D
+                                      m_orig_is_float,
+                                      true,    // multiple slices
+                                      false,   // unused
+                                      false,   // unused
+                                      false,   // unused
+                                      false};  // unused
+  header[pos++] = sperr::pack_8_booleans(b8);
+
+  // Slice dimensions and number of slices
+  const auto vdim = std::array{static_cast<uint32_t>(m_dims[0]), static_cast<uint32_t>(m_dims[1]),
+                               static_cast<uint32_t>(m_dims[2])};
+  std::memcpy(&header[pos], vdim.data(), sizeof(vdim));
+  pos += sizeof(vdim);
+
+  // Length of bitstream for each slice.
+  for (const auto& stream : m_encoded_streams) {
+    assert(stream.size() <= uint64_t{std::numeric_limits<uint32_t>::max()});
+    uint32_t len = stream.size();
+    std::memcpy(&header[pos], &len, sizeof(len));
+    pos += sizeof(len);
+  }
+  assert(pos == header_size);
+
+  return header;
+}
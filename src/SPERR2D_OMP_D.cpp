@@ -0,0 +1,181 @@
+#include "SPERR2D_OMP_D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR2D_OMP_D::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+auto sperr::SPERR2D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTNType
+{
+  // This method gathers information from the header.
+  //    It does NOT, however, read the actual bitstream. The actual bitstream
+  //    will be provided when the decompress() method is called.
+  //    The header definition is in SPERR2D_OMP_C.cpp::m_generate_header().
+  //
+  m_bitstream_ptr = nullptr;
+  m_offsets.clear();
+  if (total_len < m_header_magic)
+    return RTNType::WrongLength;
+
+  const auto* const u8p = static_cast<const uint8_t*>(p);
+  if (u8p[0] != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  const auto b8 = sperr::unpack_8_booleans(u8p[1]);
+  if (b8[1] || !b8[3])  // Needs to be 2D and multiple slices.
+    return RTNType::SliceVolumeMismatch;
+
+  auto vdim = std::array<uint32_t, 3>();
+  std::memcpy(vdim.data(), u8p + 2, sizeof(vdim));
+  m_dims = {vdim[0], vdim[1], vdim[2]};
+  const auto num_slices = m_dims[2];
+  const auto header_size = m_header_magic + num_slices * 4;
+  if (total_len < header_size)
+    return RTNType::WrongLength;
+
+  // Figure out the offset and length of each slice.
+  m_offsets.resize(num_slices * 2);
+  size_t offset = header_size;
+  for (size_t i = 0; i < num_slices; i++) {
+    uint32_t len = 0;
+    std::memcpy(&len, u8p + m_header_magic + i * 4, sizeof(len));
+    m_offsets[i * 2] = offset;
+    m_offsets[i * 2 + 1] = len;
+    offset += len;
+  }
+  if (offset != total_len)
+    return RTNType::WrongLength;
+
+  // Finally, we keep a copy of the bitstream pointer
+  m_bitstream_ptr = u8p;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR2D_OMP_D::decompress(const void* p) -> RTNType
+{
+  if (p == nullptr || m_bitstream_ptr == nullptr)
+    return RTNType::Error;
+  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+    return RTNType::Error;
+
+  const auto slice_len = m_dims[0] * m_dims[1];
+  const auto num_slices = m_dims[2];
+  m_vol_buf.resize(slice_len * num_slices);
+  auto slice_rtn = std::vector<RTNType>(num_slices * 2, RTNType::Good);
+
+#ifdef USE_OMP
+  m_decompressors.resize(m_num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK2D_FLT>();
+  });
+#else
+  if (m_decompressor == nullptr)
+    m_decompressor = std::make_unique<SPECK2D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_slices; i++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    decompressor->set_dims({m_dims[0], m_dims[1], 1});
+    slice_rtn[i * 2] =
+        decompressor->use_bitstream(m_bitstream_ptr + m_offsets[i * 2], m_offsets[i * 2 + 1]);
+    slice_rtn[i * 2 + 1] = decompressor->decompress();
+    const auto& slice = decompressor->view_decoded_data();
+    if (slice.size() == slice_len)
+      std::copy(slice.cbegin(), slice.cend(), m_vol_buf.begin() + i * slice_len);
+    else if (slice_rtn[i * 2 + 1] == RTNType::Good)
+      slice_rtn[i * 2 + 1] = RTNType::Error;
+  }
+
+  auto fail = std::find_if_not(slice_rtn.begin(), slice_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != slice_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+
+auto sperr::SPERR2D_OMP_D::decompress_slice(const void* p, size_t idx) -> RTNType
+{
+  if (p == nullptr || m_bitstream_ptr == nullptr)
+    return RTNType::Error;
+  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+    return RTNType::Error;
+  if (idx >= m_dims[2])
+    return RTNType::Error;
+
+  // Only one slice to work on, so any existing decompressor would do.
+#ifdef USE_OMP
+  if (m_decompressors.empty())
+    m_decompressors.resize(1);
+  auto& decompressor = m_decompressors[0];
+#else
+  auto& decompressor = m_decompressor;
+#endif
+  if (decompressor == nullptr)
+    decompressor = std::make_unique<SPECK2D_FLT>();
+
+  decompressor->set_dims({m_dims[0], m_dims[1], 1});
+  auto rtn =
+      decompressor->use_bitstream(m_bitstream_ptr + m_offsets[idx * 2], m_offsets[idx * 2 + 1]);
+  if (rtn != RTNType::Good)
+    return rtn;
+  rtn = decompressor->decompress();
+  if (rtn != RTNType::Good)
+    return rtn;
+  m_slice_buf = decompressor->release_decoded_data();
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR2D_OMP_D::view_decoded_data() const -> const vecd_type&
+{
+  return m_vol_buf;
+}
+
+auto sperr::SPERR2D_OMP_D::release_decoded_data() -> vecd_type&&
+{
+  return std::move(m_vol_buf);
+}
+
+auto sperr::SPERR2D_OMP_D::view_decoded_slice() const -> const vecd_type&
+{
+  return m_slice_buf;
+}
+
+auto sperr::SPERR2D_OMP_D::release_decoded_slice() -> vecd_type&&
+{
+  return std::move(m_slice_buf);
+}
+
+auto sperr::SPERR2D_OMP_D::get_dims() const -> dims_type
+{
+  return m_dims;
+}
+
+auto sperr::SPERR2D_OMP_D::get_slice_range(size_t idx) const -> std::array<size_t, 2>
+{
+  if (idx * 2 + 1 >= m_offsets.size())
+    return {0, 0};
+  else
+    return {m_offsets[idx * 2], m_offsets[idx * 2 + 1]};
+}
@@ -0,0 +1,465 @@
+#include "SPERR3D_Container.h"
+#include "SPERR3D_OMP_D.h"
+#include "SPERR3D_Stream_Tools.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char container_magic[8] = {'S', 'P', 'E', 'R', 'R', 'C', 'T', 'N'};
+constexpr size_t file_header_len = 16;
+constexpr size_t trailer_len = 24;
+constexpr size_t min_entry_len = 2 + 24;  // An index entry with an empty name.
+
+auto entry_less(const sperr::SPERR3D_Container_Entry& a, const sperr::SPERR3D_Container_Entry& b)
+    -> bool
+{
+  return std::tie(a.name, a.timestep) < std::tie(b.name, b.timestep);
+}
+
+// Serialize the index followed by the trailer; see the format in SPERR3D_Container.h.
+auto pack_index(const std::vector<sperr::SPERR3D_Container_Entry>& entries, size_t index_offset)
+    -> sperr::vec8_type
+{
+  auto buf = sperr::vec8_type();
+  auto put = [&buf](const void* p, size_t n) {
+    const auto* u8p = static_cast<const uint8_t*>(p);
+    buf.insert(buf.end(), u8p, u8p + n);
+  };
+  for (const auto& e : entries) {
+    const auto name_len = static_cast<uint16_t>(e.name.size());
+    const uint64_t u64[3] = {e.timestep, e.offset, e.len};
+    put(&name_len, sizeof(name_len));
+    put(e.name.data(), name_len);
+    put(u64, sizeof(u64));
+  }
+  const uint64_t trailer[2] = {index_offset, entries.size()};
+  put(trailer, sizeof(trailer));
+  put(container_magic, sizeof(container_magic));
+
+  return buf;
+}
+
+// Parse the trailer, and return the offset and length of the index, as well as the number of
+//    entries. Returns all zeros if it's not a valid trailer.
+auto parse_trailer(const uint8_t* trailer, size_t file_len) -> std::array<size_t, 3>
+{
+  auto rtn = std::array<size_t, 3>{0, 0, 0};
+  if (std::memcmp(trailer + 16, container_magic, sizeof(container_magic)) != 0)
+    return rtn;
+  uint64_t u64[2] = {0, 0};
+  std::memcpy(u64, trailer, sizeof(u64));
+  if (u64[0] < file_header_len || u64[0] > file_len - trailer_len)
+    return rtn;
+  const auto index_len = file_len - trailer_len - u64[0];
+  if (u64[1] > index_len / min_entry_len)  // The index can't hold that many entries.
+    return rtn;
+  rtn = {u64[0], index_len, u64[1]};
+  return rtn;
+}
+
+// Parse an index. Returns false if the index is corrupt.
+auto parse_index(const uint8_t* index,
+                 size_t index_len,
+                 size_t num_entries,
+                 std::vector<sperr::SPERR3D_Container_Entry>& entries) -> bool
+{
+  entries.clear();
+  if (num_entries > index_len / min_entry_len)
+    return false;
+  entries.reserve(num_entries);
+  size_t pos = 0;
+  for (size_t i = 0; i < num_entries; i++) {
+    uint16_t name_len = 0;
+    if (pos + sizeof(name_len) > index_len)
+      return false;
+    std::memcpy(&name_len, index + pos, sizeof(name_len));
+    pos += sizeof(name_len);
+    uint64_t u64[3] = {0, 0, 0};
+    if (pos + name_len + sizeof(u64) > index_len)
+      return false;
+    auto& e = entries.emplace_back();
+    e.name.assign(reinterpret_cast<const char*>(index + pos), name_len);
+    pos += name_len;
+    std::memcpy(u64, index + pos, sizeof(u64));
+    pos += sizeof(u64);
+    e.timestep = u64[0];
+    e.offset = u64[1];
+    e.len = u64[2];
+  }
+  return std::is_sorted(entries.cbegin(), entries.cend(), entry_less);
+}
+
+}  // anonymous namespace
+
+//
+// Class SPERR3D_Container_Writer
+//
+sperr::SPERR3D_Container_Writer::~SPERR3D_Container_Writer()
+{
+  close();
+}
+
+auto sperr::SPERR3D_Container_Writer::open(const std::string& filename, bool append) -> RTNType
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_file != nullptr)
+    return RTNType::Error;
+  m_entries.clear();
+
+  // Start a new container.
+  if (!append) {
+    m_file = std::fopen(filename.data(), "w+b");
+    if (m_file == nullptr)
+      return RTNType::IOError;
+    auto header = std::array<uint8_t, file_header_len>();
+    header.fill(0);
+    std::memcpy(header.data(), container_magic, sizeof(container_magic));
+    header[sizeof(container_magic)] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+    if (std::fwrite(header.data(), 1, header.size(), m_file) != header.size() ||
+        std::fflush(m_file) != 0) {
+      std::fclose(m_file);
+      m_file = nullptr;
+      return RTNType::IOError;
+    }
+    m_file_len = header.size();
+    return RTNType::Good;
+  }
+
+  // Keep adding to an existing container: load its index, and write after everything.
+  m_file = std::fopen(filename.data(), "r+b");
+  if (m_file == nullptr)
+    return RTNType::IOError;
+  auto fail = [this](RTNType rtn) {
+    std::fclose(m_file);
+    m_file = nullptr;
+    return rtn;
+  };
+  if (std::fseek(m_file, 0, SEEK_END) != 0)
+    return fail(RTNType::IOError);
+  const long pos = std::ftell(m_file);
+  if (pos == -1)
+    return fail(RTNType::IOError);
+  const auto file_len = static_cast<size_t>(pos);
+  if (file_len < file_header_len + trailer_len)
+    return fail(RTNType::WrongLength);
+  auto buf = vec8_type(trailer_len);
+  std::fseek(m_file, long(file_len - trailer_len), SEEK_SET);
+  if (std::fread(buf.data(), 1, trailer_len, m_file) != trailer_len)
+    return fail(RTNType::IOError);
+  const auto [index_offset, index_len, num_entries] = parse_trailer(buf.data(), file_len);
+  if (index_offset == 0)
+    return fail(RTNType::Error);
+  buf.resize(index_len);
+  std::fseek(m_file, long(index_offset), SEEK_SET);
+  if (std::fread(buf.data(), 1, index_len, m_file) != index_len)
+    return fail(RTNType::IOError);
+  if (!parse_index(buf.data(), index_len, num_entries, m_entries))
+    return fail(RTNType::Error);
+  m_file_len = file_len;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR3D_Container_Writer::append(const std::string& name,
+                                             size_t timestep,
+                                             const void* stream,
+                                             size_t len) -> RTNType
+{
+  if (name.size() > std::numeric_limits<uint16_t>::max())
+    return RTNType::Error;
+
+  // Reserve a place in the file for this bitstream, and record it in the index, so the same
+  //    (name, time step) pair can't be added concurrently. The entry is removed again if the
+  //    bitstream can't be written, so the index never points to bytes that aren't written.
+  auto entry = SPERR3D_Container_Entry{name, timestep, 0, len};
+  auto offset = size_t{0};
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file == nullptr)
+      return RTNType::Error;
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry, entry_less);
+    if (it != m_entries.end() && it->name == name && it->timestep == timestep)
+      return RTNType::Error;
+    offset = m_file_len;
+    entry.offset = offset;
+    m_file_len += len;
+
+#ifndef __unix__
+    // Without positional writes, the bitstream is written while holding the lock.
+    std::fseek(m_file, long(offset), SEEK_SET);
+    if (std::fwrite(stream, 1, len, m_file) != len)
+      return RTNType::IOError;
+#endif
+    m_entries.insert(it, std::move(entry));
+  }
+
+#ifdef __unix__
+  // Positional writes to different places of the file can happen concurrently.
+  const int fd = ::fileno(m_file);
+  const auto* u8p = static_cast<const uint8_t*>(stream);
+  while (len > 0) {
+    const auto n = ::pwrite(fd, u8p, len, off_t(offset));
+    if (n <= 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      const auto key = SPERR3D_Container_Entry{name, timestep, 0, 0};
+      auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, entry_less);
+      assert(it != m_entries.end() && it->name == name && it->timestep == timestep);
+      m_entries.erase(it);
+      return RTNType::IOError;
+    }
+    u8p += n;
+    offset += n;
+    len -= n;
+  }
+#endif
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR3D_Container_Writer::append(const std::string& name,
+                                             size_t timestep,
+                                             const SPERR3D_OMP_C& encoder) -> RTNType
+{
+  auto stream = vec8_type(encoder.get_encoded_bitstream_len());
+  if (stream.empty())
+    return RTNType::Error;
+  auto rtn = encoder.write_encoded_bitstream(stream.data(), stream.size());
+  if (rtn != RTNType::Good)
+    return rtn;
+
+  return append(name, timestep, stream.data(), stream.size());
+}
+
+auto sperr::SPERR3D_Container_Writer::close() -> RTNType
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_file == nullptr)
+    return RTNType::Good;
+
+  auto index = pack_index(m_entries, m_file_len);
+  auto rtn = RTNType::Good;
+  if (std::fseek(m_file, long(m_file_len), SEEK_SET) != 0 ||
+      std::fwrite(index.data(), 1, index.size(), m_file) != index.size())
+    rtn = RTNType::IOError;
+  if (std::fclose(m_file) != 0)
+    rtn = RTNType::IOError;
+  m_file = nullptr;
+  m_entries.clear();
+
+  return rtn;
+}
+
+//
+// Class SPERR3D_Container_Reader
+//
+sperr::SPERR3D_Container_Reader::~SPERR3D_Container_Reader()
+{
+  m_unmap();
+}
+
+void sperr::SPERR3D_Container_Reader::m_unmap()
+{
+#ifdef __unix__
+  if (m_map != nullptr)
+    ::munmap(const_cast<uint8_t*>(m_map), m_file_len);
+#endif
+  m_map = nullptr;
+}
+
+auto sperr::SPERR3D_Container_Reader::open(const std::string& filename) -> RTNType
+{
+  m_unmap();
+  m_entries.clear();
+  m_filename = filename;
+  m_file_len = 0;
+
+#ifdef __unix__
+  const int fd = ::open(filename.data(), O_RDONLY);
+  if (fd < 0)
+    return RTNType::IOError;
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return RTNType::IOError;
+  }
+  m_file_len = st.st_size;
+  if (m_file_len >= file_header_len + trailer_len) {
+    auto* p = ::mmap(nullptr, m_file_len, PROT_READ, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED)
+      m_map = static_cast<const uint8_t*>(p);
+  }
+  ::close(fd);
+#else
+  if (auto* f = std::fopen(filename.data(), "rb")) {
+    std::fseek(f, 0, SEEK_END);
+    m_file_len = std::ftell(f);
+    std::fclose(f);
+  }
+  else
+    return RTNType::IOError;
+#endif
+
+  if (m_file_len < file_header_len + trailer_len)
+    return RTNType::WrongLength;
+
+  // Verify the file header, and then parse the index.
+  auto buf = vec8_type();
+  const auto* p = m_fetch(0, file_header_len, buf);
+  if (p == nullptr)
+    return RTNType::IOError;
+  if (std::memcmp(p, container_magic, sizeof(container_magic)) != 0)
+    return RTNType::Error;
+  if (p[sizeof(container_magic)] != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  p = m_fetch(m_file_len - trailer_len, trailer_len, buf);
+  if (p == nullptr)
+    return RTNType::IOError;
+  const auto [index_offset, index_len, num_entries] = parse_trailer(p, m_file_len);
+  if (index_offset == 0)
+    return RTNType::Error;
+  p = m_fetch(index_offset, index_len, buf);
+  if (p == nullptr)
+    return RTNType::IOError;
+  if (!parse_index(p, index_len, num_entries, m_entries))
+    return RTNType::Error;
+  for (const auto& e : m_entries) {
+    if (e.offset + e.len > index_offset)
+      return RTNType::WrongLength;
+  }
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR3D_Container_Reader::m_fetch(size_t offset, size_t len, vec8_type& buf) const
+    -> const uint8_t*
+{
+  if (offset + len > m_file_len)
+    return nullptr;
+  if (m_map != nullptr)
+    return m_map + offset;
+
+  buf.clear();
+  const auto section = std::vector<size_t>{offset, len};
+  if (sperr::read_sections(m_filename, section, buf) != RTNType::Good)
+    return nullptr;
+  return buf.data();
+}
+
+auto sperr::SPERR3D_Container_Reader::view_entries() const
+    -> const std::vector<SPERR3D_Container_Entry>&
+{
+  return m_entries;
+}
+
+auto sperr::SPERR3D_Container_Reader::find(const std::string& name, size_t timestep) const
+    -> const SPERR3D_Container_Entry*
+{
+  const auto key = SPERR3D_Container_Entry{name, timestep, 0, 0};
+  auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), key, entry_less);
+  if (it == m_entries.cend() || it->name != name || it->timestep != timestep)
+    return nullptr;
+  return &(*it);
+}
+
+auto sperr::SPERR3D_Container_Reader::get_stream(const std::string& name,
+                                                 size_t timestep,
+                                                 unsigned pct) const -> vec8_type
+{
+  const auto* entry = find(name, timestep);
+  if (entry == nullptr)
+    return vec8_type();
+  auto buf = vec8_type();
+  const auto* p = m_fetch(entry->offset, entry->len, buf);
+  if (p == nullptr)
+    return vec8_type();
+
+  if (pct == 0 || pct >= 100)
+    return vec8_type(p, p + entry->len);
+  else
+    return SPERR3D_Stream_Tools().progressive_truncate(p, entry->len, pct);
+}
+
+auto sperr::SPERR3D_Container_Reader::get_region(const std::string& name,
+                                                 size_t timestep,
+                                                 std::array<size_t, 6> region,
+                                                 unsigned pct) const -> vec8_type
+{
+  const auto* entry = find(name, timestep);
+  if (entry == nullptr)
+    return vec8_type();
+
+  // Parse the header of this bitstream, and its chunk index if it's in a footer.
+  auto tools = SPERR3D_Stream_Tools();
+  auto buf = vec8_type();
+  const auto* p = m_fetch(entry->offset, std::min(entry->len, size_t{20}), buf);
+  if (p == nullptr || entry->len < 20)
+    return vec8_type();
+  auto arr20 = std::array<uint8_t, 20>();
+  std::copy(p, p + 20, arr20.begin());
+  p = m_fetch(entry->offset, tools.get_header_len(arr20), buf);
+  if (p == nullptr)
+    return vec8_type();
+  auto header = tools.get_stream_header(p);
+  if (header.footer_index) {
+    p = m_fetch(entry->offset + header.index_offset, header.index_len, buf);
+    if (p == nullptr)
+      return vec8_type();
+    tools.read_chunk_index(header, p);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    if (region[i * 2 + 1] == 0 || region[i * 2] + region[i * 2 + 1] > header.vol_dims[i])
+      return vec8_type();
+  }
+
+  // With a memory-mapped file, pages that are not touched are not read anyway, so fetch
+  //    everything in one range. Otherwise, merge ranges that are close to each other.
+  const auto max_gap = (m_map ? std::numeric_limits<size_t>::max() : size_t{65536});
+  auto plan = tools.plan_ranges(header, region, pct, max_gap);
+  if (m_map) {
+    if (plan.ranges.empty())
+      return tools.assemble_ranges(plan, nullptr, 0);
+    assert(plan.ranges.size() == 2);
+    p = m_fetch(entry->offset + plan.ranges[0], plan.ranges[1], buf);
+    return p ? tools.assemble_ranges(plan, p, plan.ranges[1]) : vec8_type();
+  }
+  else {
+    auto ranges = plan.ranges;
+    for (size_t i = 0; i < ranges.size(); i += 2)
+      ranges[i] += entry->offset;
+    buf.clear();
+    if (sperr::read_sections(m_filename, ranges, buf) != RTNType::Good)
+      return vec8_type();
+    return tools.assemble_ranges(plan, buf.data(), buf.size());
+  }
+}
+
+auto sperr::SPERR3D_Container_Reader::decompress_region(const std::string& name,
+                                                        size_t timestep,
+                                                        std::array<size_t, 6> region,
+                                                        vecd_type& dst,
+                                                        size_t num_threads) const -> RTNType
+{
+  const auto stream = get_region(name, timestep, region);
+  if (stream.empty())
+    return RTNType::Error;
+
+  // Only chunks that intersect with the region are decoded, and straight into `dst`.
+  auto decoder = SPERR3D_OMP_D();
+  decoder.set_num_threads(num_threads);
+  auto rtn = decoder.use_bitstream(stream.data(), stream.size());
+  if (rtn != RTNType::Good)
+    return rtn;
+  return decoder.decompress_region(stream.data(), region, dst);
+}
@@ -1,4 +1,5 @@
 #include "SPERR3D_OMP_C.h"
+#include "SPERR3D_Stream_Tools.h"
 
 #include <algorithm>  // std::all_of()
 #include <cassert>
@@ -49,6 +50,11 @@ void sperr::SPERR3D_OMP_C::set_bitrate(double bpp)
   m_quality = bpp;
 }
 
+void sperr::SPERR3D_OMP_C::enable_rd_table(bool enable)
+{
+  m_rd_enabled = enable;
+}
+
 #ifdef EXPERIMENTING
 void sperr::SPERR3D_OMP_C::set_direct_q(double q)
 {
@@ -60,6 +66,45 @@ void sperr::SPERR3D_OMP_C::set_direct_q(double q)
 
 template <typename T>
 auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
+{
+  // First, calculate dimensions of individual chunk indices.
+  const auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
+  const auto num_chunks = chunk_idx.size();
+
+  auto rtn = m_prepare_chunks(buf, buf_len, num_chunks);
+  if (rtn != RTNType::Good)
+    return rtn;
+
+  auto chunk_rtn = std::vector<RTNType>(num_chunks, RTNType::Good);
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_chunks; i++) {
+    // Gather data for this chunk, and compress!
+    auto& chunk = m_thread_buf();
+    {
+      auto timer = Stage_Timer(m_chunk_profiles[i], Stage::Gather);
+      m_gather_chunk<T>(buf, m_dims, chunk_idx[i], chunk, m_chunk_profiles[i]);
+    }
+    assert(!chunk.empty());
+    chunk_rtn[i] = m_encode_chunk(m_thread_compressor(), i, chunk_idx[i], chunk);
+  }
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return (*fail);
+
+  assert(std::none_of(m_encoded_streams.cbegin(), m_encoded_streams.cend(),
+                      [](auto& s) { return s.empty(); }));
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR3D_OMP_C::compress(const float*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const double*, size_t) -> RTNType;
+
+template <typename T>
+auto sperr::SPERR3D_OMP_C::m_prepare_chunks(const T* buf, size_t buf_len, size_t num_chunks)
+    -> RTNType
 {
   static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
   if constexpr (std::is_same<T, float>::value)
@@ -72,13 +117,18 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
   if (buf_len != m_dims[0] * m_dims[1] * m_dims[2])
     return RTNType::WrongLength;
 
-  // First, calculate dimensions of individual chunk indices.
-  const auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
-  const auto num_chunks = chunk_idx.size();
-
-  // Let's prepare some data structures for compression!
-  auto chunk_rtn = std::vector<RTNType>(num_chunks, RTNType::Good);
   m_encoded_streams.resize(num_chunks);
+  m_chunk_profiles.assign(num_chunks, {});
+
+  // The rate-distortion tables need the data range of the entire volume, so that a target PSNR
+  //    can be translated to a target SSE.
+  if (m_rd_enabled) {
+    auto [min, max] = std::minmax_element(buf, buf + buf_len);
+    m_data_range = double(*max) - double(*min);
+    m_rd_tables.assign(num_chunks, {});
+  }
+  else
+    m_rd_tables.clear();
 
 #ifdef USE_OMP
   m_compressors.resize(m_num_threads);
@@ -86,106 +136,309 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
     if (p == nullptr)
       p = std::make_unique<SPECK3D_FLT>();
   }
+  m_thread_bufs.resize(m_num_threads);
 #else
   if (m_compressor == nullptr)
     m_compressor = std::make_unique<SPECK3D_FLT>();
+  m_thread_bufs.resize(1);
 #endif
 
-#pragma omp parallel for num_threads(m_num_threads)
-  for (size_t i = 0; i < num_chunks; i++) {
+  return RTNType::Good;
+}
+template auto sperr::SPERR3D_OMP_C::m_prepare_chunks(const float*, size_t, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::m_prepare_chunks(const double*, size_t, size_t) -> RTNType;
+
+auto sperr::SPERR3D_OMP_C::m_thread_compressor() -> SPECK3D_FLT&
+{
 #ifdef USE_OMP
-    auto& compressor = m_compressors[omp_get_thread_num()];
+  return *m_compressors[omp_get_thread_num()];
 #else
-    auto& compressor = m_compressor;
+  return *m_compressor;
 #endif
+}
 
-    // Gather data for this chunk, Setup compressor parameters, and compress!
-    auto chunk = m_gather_chunk<T>(buf, m_dims, chunk_idx[i]);
-    assert(!chunk.empty());
-    compressor->take_data(std::move(chunk));
-    compressor->set_dims({chunk_idx[i][1], chunk_idx[i][3], chunk_idx[i][5]});
-    switch (m_mode) {
-      case CompMode::PSNR:
-        compressor->set_psnr(m_quality);
-        break;
-      case CompMode::PWE:
-        compressor->set_tolerance(m_quality);
-        break;
-      case CompMode::Rate:
-        compressor->set_bitrate(m_quality);
-        break;
+auto sperr::SPERR3D_OMP_C::m_thread_buf() -> vecd_type&
+{
+#ifdef USE_OMP
+  return m_thread_bufs[omp_get_thread_num()];
+#else
+  return m_thread_bufs[0];
+#endif
+}
+
+auto sperr::SPERR3D_OMP_C::m_encode_chunk(SPECK3D_FLT& compressor,
+                                          size_t idx,
+                                          std::array<size_t, 6> chunk,
+                                          vecd_type& buf) -> RTNType
+{
+  // Setup compressor parameters, and compress!
+  compressor.take_data(std::move(buf));
+  compressor.set_dims({chunk[1], chunk[3], chunk[5]});
+  compressor.enable_rd_table(m_rd_enabled);
+  switch (m_mode) {
+    case CompMode::PSNR:
+      compressor.set_psnr(m_quality);
+      break;
+    case CompMode::PWE:
+      compressor.set_tolerance(m_quality);
+      break;
+    case CompMode::Rate:
+      compressor.set_bitrate(m_quality);
+      break;
 #ifdef EXPERIMENTING
-      case CompMode::DirectQ:
-        compressor->set_direct_q(m_quality);
-        break;
+    case CompMode::DirectQ:
+      compressor.set_direct_q(m_quality);
+      break;
 #endif
-      default:;  // So the compiler doesn't complain about missing cases.
-    }
-    chunk_rtn[i] = compressor->compress();
+    default:;  // So the compiler doesn't complain about missing cases.
+  }
+  auto rtn = compressor.compress();
+  buf = compressor.release_decoded_data();
+  m_chunk_profiles[idx].merge(compressor.view_profile());
+
+  // Save bitstream for each chunk in `m_encoded_stream`.
+  m_encoded_streams[idx].clear();
+  m_encoded_streams[idx].reserve(compressor.encoded_bitstream_len());
+  compressor.append_encoded_bitstream(m_encoded_streams[idx]);
+
+  // Keeping the complete chunk bitstream (e.g., with outliers) is the last rate-distortion point.
+  if (m_rd_enabled) {
+    auto& table = m_rd_tables[idx];
+    table = compressor.view_rd_table();
+    if (!table.empty() && table.back().bytes < m_encoded_streams[idx].size())
+      table.push_back({m_encoded_streams[idx].size(), table.back().sse});
+  }
+
+  return rtn;
+}
+
+auto sperr::SPERR3D_OMP_C::view_chunk_profiles() const -> const std::vector<Profile>&
+{
+  return m_chunk_profiles;
+}
+
+auto sperr::SPERR3D_OMP_C::get_encoded_bitstream() const -> vec8_type
+{
+  auto stream = vec8_type(get_encoded_bitstream_len());
+  if (write_encoded_bitstream(stream.data(), stream.size()) != RTNType::Good)
+    stream.clear();
+
+  return stream;
+}
+
+auto sperr::SPERR3D_OMP_C::get_encoded_bitstream_len() const -> size_t
+{
+  const auto num_chunks = m_encoded_streams.size();
+  if (num_chunks == 0)
+    return 0;
 
-    // Save bitstream for each chunk in `m_encoded_stream`.
-    m_encoded_streams[i].clear();
-    m_encoded_streams[i].reserve(128);
-    compressor->append_encoded_bitstream(m_encoded_streams[i]);
+  const auto lens = m_stream_lens();
+  auto stream_size = std::accumulate(lens.cbegin(), lens.cend(), 0lu);
+  auto total_len = m_header_len(lens) + stream_size + m_rd_section_len();
+  if (m_use_large_header(lens) && m_footer_index)
+    total_len += (num_chunks + 1) * sizeof(uint64_t);
+
+  return total_len;
+}
+
+auto sperr::SPERR3D_OMP_C::write_encoded_bitstream(void* dst, size_t dst_len) const -> RTNType
+{
+  const auto lens = m_stream_lens();
+  auto header = m_generate_header(lens);
+  if (header.empty())
+    return RTNType::Error;
+  if (dst_len < get_encoded_bitstream_len())
+    return RTNType::WrongLength;
+
+  auto* ptr = static_cast<uint8_t*>(dst);
+  std::copy(header.cbegin(), header.cend(), ptr);
+  ptr += header.size();
+  for (const auto& s : m_encoded_streams) {
+    std::copy(s.cbegin(), s.cend(), ptr);
+    ptr += s.size();
   }
 
-  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
-                               [](auto r) { return r == RTNType::Good; });
-  if (fail != chunk_rtn.end())
-    return (*fail);
+  // The rate-distortion section, if there is one, follows all chunk bitstreams.
+  m_write_rd_section(ptr);
+  ptr += m_rd_section_len();
 
-  assert(std::none_of(m_encoded_streams.cbegin(), m_encoded_streams.cend(),
-                      [](auto& s) { return s.empty(); }));
+  // The chunk index, if it's a footer, goes to the very end.
+  if (m_use_large_header(lens) && m_footer_index) {
+    const auto index = m_chunk_index(lens);
+    std::memcpy(ptr, index.data(), index.size() * sizeof(uint64_t));
+  }
 
   return RTNType::Good;
 }
-template auto sperr::SPERR3D_OMP_C::compress(const float*, size_t) -> RTNType;
-template auto sperr::SPERR3D_OMP_C::compress(const double*, size_t) -> RTNType;
 
-auto sperr::SPERR3D_OMP_C::get_encoded_bitstream() const -> vec8_type
+void sperr::SPERR3D_OMP_C::set_large_header(bool large, bool footer_index)
 {
-  auto header = m_generate_header();
-  assert(!header.empty());
-  auto header_size = header.size();
-  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
-                                     [](size_t a, const auto& b) { return a + b.size(); });
-  header.resize(header_size + stream_size);
-
-  auto itr = header.begin() + header_size;
-  for (const auto& s : m_encoded_streams) {
-    std::copy(s.cbegin(), s.cend(), itr);
-    itr += s.size();
+  m_large_header = large;
+  m_footer_index = footer_index;
+}
+
+void sperr::SPERR3D_OMP_C::set_mem_policy(MemPolicy policy)
+{
+  m_mem_policy = policy;
+}
+
+auto sperr::SPERR3D_OMP_C::m_use_large_header(const std::vector<size_t>& lens) const -> bool
+{
+  if (m_large_header)
+    return true;
+
+  const auto u32max = uint64_t{std::numeric_limits<uint32_t>::max()};
+  const auto u16max = uint64_t{std::numeric_limits<uint16_t>::max()};
+  if (std::any_of(m_dims.cbegin(), m_dims.cend(), [u32max](auto d) { return d > u32max; }))
+    return true;
+  if (lens.size() > 1 && std::any_of(m_chunk_dims.cbegin(), m_chunk_dims.cend(),
+                                     [u16max](auto d) { return d > u16max; }))
+    return true;
+  return std::any_of(lens.cbegin(), lens.cend(), [u32max](auto len) { return len > u32max; });
+}
+
+auto sperr::SPERR3D_OMP_C::max_encoded_bitstream_len(const std::vector<size_t>& max_chunk_lens) const
+    -> size_t
+{
+  const auto num_chunks = max_chunk_lens.size();
+  if (num_chunks == 0 || num_chunks != sperr::chunk_volume(m_dims, m_chunk_dims).size())
+    return 0;
+
+  // Longer chunk bitstreams never make the header, or the chunk index, shorter.
+  const auto& lens = max_chunk_lens;
+  auto total_len = std::accumulate(lens.cbegin(), lens.cend(), m_header_len(lens, m_rd_enabled));
+  if (m_use_large_header(lens) && m_footer_index)
+    total_len += (num_chunks + 1) * sizeof(uint64_t);
+
+  // A rate-distortion table has at most a point before any bitplane, a point at the end of each
+  //    of the (up to 64) bitplanes, and a point for the complete chunk bitstream.
+  if (m_rd_enabled) {
+    const auto max_points = size_t{64} + 2;
+    total_len += sizeof(m_data_range) + num_chunks;
+    total_len += num_chunks * max_points * (sizeof(uint32_t) + sizeof(float));
   }
 
-  return header;
+  return total_len;
+}
+
+auto sperr::SPERR3D_OMP_C::m_header_len(const std::vector<size_t>& lens) const -> size_t
+{
+  return m_header_len(lens, !m_rd_tables.empty());
 }
 
-auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
+auto sperr::SPERR3D_OMP_C::m_header_len(const std::vector<size_t>& lens, bool has_rd) const
+    -> size_t
+{
+  const auto num_chunks = lens.size();
+  auto header_len = size_t{0};
+  if (m_use_large_header(lens)) {
+    header_len = m_header_magic_large;
+    if (!m_footer_index)
+      header_len += (num_chunks + 1) * sizeof(uint64_t);
+  }
+  else if (num_chunks > 1)
+    header_len = m_header_magic_nchunks + num_chunks * 4;
+  else
+    header_len = m_header_magic_1chunk + num_chunks * 4;
+  if (has_rd)
+    header_len += 4;
+
+  return header_len;
+}
+
+auto sperr::SPERR3D_OMP_C::m_chunk_index(const std::vector<size_t>& lens) const
+    -> std::vector<uint64_t>
+{
+  auto index = std::vector<uint64_t>(lens.size() + 1);
+  index[0] = m_header_len(lens);
+  for (size_t i = 0; i < lens.size(); i++)
+    index[i + 1] = index[i] + lens[i];
+
+  return index;
+}
+
+auto sperr::SPERR3D_OMP_C::m_stream_lens() const -> std::vector<size_t>
+{
+  auto lens = std::vector<size_t>(m_encoded_streams.size());
+  std::transform(m_encoded_streams.cbegin(), m_encoded_streams.cend(), lens.begin(),
+                 [](const auto& s) { return s.size(); });
+  return lens;
+}
+
+auto sperr::SPERR3D_OMP_C::m_rd_section_len() const -> size_t
+{
+  if (m_rd_tables.empty())
+    return 0;
+
+  auto len = sizeof(m_data_range) + m_rd_tables.size();
+  for (const auto& table : m_rd_tables)
+    len += table.size() * (sizeof(uint32_t) + sizeof(float));
+  return len;
+}
+
+void sperr::SPERR3D_OMP_C::m_write_rd_section(uint8_t* ptr) const
+{
+  // The rate-distortion section, if there is one, contains:
+  //  -- data range of the entire volume      (8 bytes)
+  //  -- for each chunk, the number of points (1 byte), followed by each point's
+  //     number of bytes and estimated SSE    ((4 + 4) x num_points)
+  //
+  if (m_rd_tables.empty())
+    return;
+
+  std::memcpy(ptr, &m_data_range, sizeof(m_data_range));
+  ptr += sizeof(m_data_range);
+  for (const auto& table : m_rd_tables) {
+    assert(table.size() <= std::numeric_limits<uint8_t>::max());
+    *ptr++ = static_cast<uint8_t>(table.size());
+    for (const auto& point : table) {
+      const uint32_t bytes = point.bytes;
+      const float sse = point.sse;
+      std::memcpy(ptr, &bytes, sizeof(bytes));
+      ptr += sizeof(bytes);
+      std::memcpy(ptr, &sse, sizeof(sse));
+      ptr += sizeof(sse);
+    }
+  }
+}
+
+auto sperr::SPERR3D_OMP_C::m_generate_header(const std::vector<size_t>& lens) const
+    -> sperr::vec8_type
 {
   auto header = sperr::vec8_type();
 
   // The header would contain the following information
-  //  -- a version number                     (1 byte)
+  //  -- a version number; `extended_header_version` if there is an RD section (1 byte)
   //  -- 8 booleans                           (1 byte)
   //  -- volume dimensions                    (4 x 3 = 12 bytes)
   //  -- (optional) chunk dimensions          (2 x 3 = 6 bytes)
   //  -- length of bitstream for each chunk   (4 x num_chunks)
+  //  -- (optional) length of the rate-distortion section (4 bytes)
+  //
+  // A large header contains the following information instead
+  //  -- a version number, `extended_header_version` (1 byte)
+  //  -- 8 booleans                           (1 byte)
+  //  -- length of the header                 (8 bytes)
+  //  -- offset of the chunk index            (8 bytes)
+  //  -- unused                               (2 bytes)
+  //  -- volume and chunk dimensions          (8 x 6 = 48 bytes)
+  //  -- (optional) length of the rate-distortion section (4 bytes)
+  //  -- (optional) chunk index, unless it's a footer (8 x (num_chunks + 1))
   //
   auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
   const auto num_chunks = chunk_idx.size();
   assert(num_chunks != 0);
-  if (num_chunks != m_encoded_streams.size())
+  if (num_chunks != lens.size())
     return header;
-  auto header_size = size_t{0};
-  if (num_chunks > 1)
-    header_size = m_header_magic_nchunks + num_chunks * 4;
-  else
-    header_size = m_header_magic_1chunk + num_chunks * 4;
+  const auto header_size = m_header_len(lens);
+  const auto has_rd = !m_rd_tables.empty();
+  const auto large = m_use_large_header(lens);
 
   header.resize(header_size);
 
-  // Version number
-  header[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  // Version number; a large header, or a header with an RD section, has its own.
+  header[0] = (large || has_rd) ? extended_header_version
+                                : static_cast<uint8_t>(SPERR_VERSION_MAJOR);
   size_t pos = 1;
 
   // 8 booleans:
@@ -193,19 +446,51 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
   // bool[1]  : if this bitstream is for 3D (true) or 2D (false) data.
   // bool[2]  : if the original data is float (true) or double (false).
   // bool[3]  : if there are multiple chunks (true) or a single chunk (false).
-  // bool[4-7]: unused
+  // bool[4]  : unused (for 3D bitstreams; see SPERR1D_OMP_C)
+  // bool[5]  : if there is a rate-distortion section following chunk bitstreams.
+  // bool[6]  : if this bitstream uses a large header.
+  // bool[7]  : unused
   //
   const auto b8 = std::array<bool, 8>{false,  // not a portion
                                       true,   // 3D
                                       m_orig_is_float,
                                       (num_chunks > 1),
-                                      false,   // unused
-                                      false,   // unused
-                                      false,   // unused
+                                      false,  // unused
+                                      has_rd,
+                                      large,
                                       false};  // unused
 
   header[pos++] = sperr::pack_8_booleans(b8);
 
+  if (large) {
+    const auto index = m_chunk_index(lens);
+    const auto rd_len = m_rd_section_len();
+    uint64_t index_offset = m_header_magic_large + (has_rd ? 4 : 0);
+    if (m_footer_index)
+      index_offset = index.back() + rd_len;
+    const uint64_t u64[2] = {header_size, index_offset};
+    std::memcpy(&header[pos], u64, sizeof(u64));
+    pos = m_header_magic_nchunks;
+
+    // A single chunk has the same dimensions as the volume.
+    const auto cdim = (num_chunks > 1 ? m_chunk_dims : m_dims);
+    const uint64_t long6[6] = {m_dims[0], m_dims[1], m_dims[2], cdim[0], cdim[1], cdim[2]};
+    std::memcpy(&header[pos], long6, sizeof(long6));
+    pos += sizeof(long6);
+
+    if (has_rd) {
+      const uint32_t len = rd_len;
+      std::memcpy(&header[pos], &len, sizeof(len));
+      pos += sizeof(len);
+    }
+    if (!m_footer_index) {
+      std::memcpy(&header[pos], index.data(), index.size() * sizeof(uint64_t));
+      pos += index.size() * sizeof(uint64_t);
+    }
+    assert(pos == header_size);
+    return header;
+  }
+
   // Volume dimensions
   const auto vdim = std::array{static_cast<uint32_t>(m_dims[0]), static_cast<uint32_t>(m_dims[1]),
                                static_cast<uint32_t>(m_dims[2])};
@@ -222,9 +507,16 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
   }
 
   // Length of bitstream for each chunk.
-  for (const auto& stream : m_encoded_streams) {
-    assert(stream.size() <= uint64_t{std::numeric_limits<uint32_t>::max()});
-    uint32_t len = stream.size();
+  for (auto stream_len : lens) {
+    assert(stream_len <= uint64_t{std::numeric_limits<uint32_t>::max()});
+    uint32_t len = stream_len;
+    std::memcpy(&header[pos], &len, sizeof(len));
+    pos += sizeof(len);
+  }
+
+  // Length of the rate-distortion section.
+  if (has_rd) {
+    const uint32_t len = m_rd_section_len();
     std::memcpy(&header[pos], &len, sizeof(len));
     pos += sizeof(len);
   }
@@ -234,16 +526,23 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
 }
 
 template <typename T>
-auto sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
+void sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
                                           dims_type vol_dim,
-                                          std::array<size_t, 6> chunk) -> vecd_type
+                                          std::array<size_t, 6> chunk,
+                                          vecd_type& chunk_buf,
+                                          Profile& profile)
 {
-  auto chunk_buf = vecd_type();
+  if (chunk_buf.get_allocator().policy() != m_mem_policy)
+    chunk_buf = vecd_type(vecd_type::allocator_type(m_mem_policy));
+  chunk_buf.clear();
   if (chunk[0] + chunk[1] > vol_dim[0] || chunk[2] + chunk[3] > vol_dim[1] ||
       chunk[4] + chunk[5] > vol_dim[2])
-    return chunk_buf;
+    return;
 
-  chunk_buf.resize(chunk[1] * chunk[3] * chunk[5]);
+  const auto len = chunk[1] * chunk[3] * chunk[5];
+  if constexpr (profiling)
+    profile.bytes_reused += std::min(len, chunk_buf.capacity()) * sizeof(double);
+  chunk_buf.resize(len);
   const auto row_len = chunk[1];
 
   size_t idx = 0;
@@ -255,13 +554,14 @@ auto sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
       idx += row_len;
     }
   }
-
-  // Will be subject to Named Return Value Optimization.
-  return chunk_buf;
 }
-template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const float*,
+template void sperr::SPERR3D_OMP_C::m_gather_chunk(const float*,
                                                    dims_type,
-                                                   std::array<size_t, 6>) -> vecd_type;
-template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const double*,
+                                                   std::array<size_t, 6>,
+                                                   vecd_type&,
+                                                   Profile&);
+template void sperr::SPERR3D_OMP_C::m_gather_chunk(const double*,
                                                    dims_type,
-                                                   std::array<size_t, 6>) -> vecd_type;
+                                                   std::array<size_t, 6>,
+                                                   vecd_type&,
+                                                   Profile&);
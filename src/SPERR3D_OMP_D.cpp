@@ -30,12 +30,17 @@ auto sperr::SPERR3D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTN
   auto header = tools.get_stream_header(p);
 
   // Verify some info.
-  if (header.major_version != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+  const auto version = (header.large_header || header.has_rd_table)
+                           ? extended_header_version
+                           : static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  if (header.major_version != version)
     return RTNType::VersionMismatch;
   if (!header.is_3D)
     return RTNType::SliceVolumeMismatch;
   if (header.stream_len != total_len)
     return RTNType::WrongLength;
+  if (header.footer_index)
+    tools.read_chunk_index(header, static_cast<const uint8_t*>(p) + header.index_offset);
 
   // Collect essential info.
   m_dims = header.vol_dims;
@@ -44,16 +49,57 @@ auto sperr::SPERR3D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTN
 
   // Finally, we keep a copy of the bitstream pointer
   m_bitstream_ptr = static_cast<const uint8_t*>(p);
+  m_can_refine = false;
 
   return RTNType::Good;
 }
 
+void sperr::SPERR3D_OMP_D::set_resumable(bool resumable)
+{
+  m_resumable = resumable;
+  if (!m_resumable) {
+    m_chunk_decompressors.clear();
+    m_can_refine = false;
+  }
+}
+
+void sperr::SPERR3D_OMP_D::set_mem_policy(MemPolicy policy)
+{
+  m_mem_policy = policy;
+}
+
 auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
 {
   if (p == nullptr || m_bitstream_ptr == nullptr)
     return RTNType::Error;
   if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
     return RTNType::Error;
+
+  auto rtn = m_decompress_chunks(multi_res, false);
+  m_can_refine = m_resumable && (rtn == RTNType::Good);
+  return rtn;
+}
+
+auto sperr::SPERR3D_OMP_D::refine(const void* p, size_t len, bool multi_res) -> RTNType
+{
+  // Without a resumable state, just decompress the new bitstream normally.
+  //    Note that `use_bitstream()` resets `m_can_refine`, so record it first.
+  const auto can_refine = m_can_refine;
+  const auto old_dims = m_dims;
+  const auto old_chunk_dims = m_chunk_dims;
+  auto rtn = use_bitstream(p, len);
+  if (rtn != RTNType::Good)
+    return rtn;
+  if (!can_refine || m_dims != old_dims || m_chunk_dims != old_chunk_dims)
+    return decompress(p, multi_res);
+
+  rtn = m_decompress_chunks(multi_res, true);
+  m_can_refine = (rtn == RTNType::Good);
+  return rtn;
+}
+
+auto sperr::SPERR3D_OMP_D::m_decompress_chunks(bool multi_res, bool refine) -> RTNType
+{
   auto eq0 = [](auto v) { return v == 0; };
   if (std::any_of(m_dims.cbegin(), m_dims.cend(), eq0) ||
       std::any_of(m_chunk_dims.cbegin(), m_chunk_dims.cend(), eq0))
@@ -64,7 +110,12 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
   const auto num_chunks = chunks.size();
   const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
 
-  // Allocate a buffer to store the entire volume
+  // Allocate a buffer to store the entire volume. It's left uninitialized: every chunk, including
+  //    ones without a bitstream, is scattered into it in the parallel loop below, so its pages are
+  //    first touched by the threads that write them.
+  auto alloc = vecd_type::allocator_type(m_mem_policy);
+  if (m_vol_buf.get_allocator() != alloc)
+    m_vol_buf = vecd_type(alloc);
   m_vol_buf.resize(total_vals);
 
   // A few variables to support multi-resolution decoding.
@@ -79,40 +130,74 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
     hierarchy_chunks.resize(vol_res.size());
     for (size_t h = 0; h < m_hierarchy.size(); h++) {
       const auto& res = vol_res[h];
+      if (m_hierarchy[h].get_allocator() != alloc)
+        m_hierarchy[h] = vecd_type(alloc);
       m_hierarchy[h].resize(res[0] * res[1] * res[2]);
       hierarchy_chunks[h] = sperr::chunk_volume(res, chunk_res[h]);
     }
   }
 
-  // Create number of decompressor instances equal to the number of threads
+  // Create number of decompressor instances equal to the number of threads, or
+  //    the number of chunks in resumable mode.
   auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
+  m_chunk_profiles.assign(num_chunks, {});
 
-#ifdef USE_OMP
-  m_decompressors.resize(m_num_threads);
-  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
-    if (p == nullptr)
-      p = std::make_unique<SPECK3D_FLT>();
-  });
-#else
-  if (m_decompressor == nullptr)
-    m_decompressor = std::make_unique<SPECK3D_FLT>();
-#endif
+  if (m_resumable) {
+    m_chunk_decompressors.resize(num_chunks);
+    std::for_each(m_chunk_decompressors.begin(), m_chunk_decompressors.end(), [](auto& p) {
+      if (p == nullptr)
+        p = std::make_unique<SPECK3D_FLT>();
+    });
+  }
+  else
+    m_make_thread_decompressors();
 
 #pragma omp parallel for num_threads(m_num_threads)
   for (size_t chunkI = 0; chunkI < num_chunks; chunkI++) {
 #ifdef USE_OMP
-    auto& decompressor = m_decompressors[omp_get_thread_num()];
+    auto& decompressor =
+        m_resumable ? m_chunk_decompressors[chunkI] : m_decompressors[omp_get_thread_num()];
 #else
-    auto& decompressor = m_decompressor;
+    auto& decompressor = m_resumable ? m_chunk_decompressors[chunkI] : m_decompressor;
 #endif
 
-    // Setup decompressor parameters, and decompress!
-    decompressor->set_dims({chunks[chunkI][1], chunks[chunkI][3], chunks[chunkI][5]});
-    chunk_rtn[chunkI * 2] = decompressor->use_bitstream(m_bitstream_ptr + m_offsets[chunkI * 2],
-                                                        m_offsets[chunkI * 2 + 1]);
-    chunk_rtn[chunkI * 2 + 1] = decompressor->decompress(multi_res);
+    // A chunk without any bitstream (e.g., outside of a region of interest) is left as zeros.
+    const auto* chunk_ptr = m_bitstream_ptr + m_offsets[chunkI * 2];
+    const auto chunk_len = m_offsets[chunkI * 2 + 1];
+    if (chunk_len == 0) {
+      const auto& c = chunks[chunkI];
+      m_scatter_chunk(m_vol_buf, m_dims, vecd_type(c[1] * c[3] * c[5], 0.0), c);
+      for (size_t h = 0; h < hierarchy_chunks.size(); h++) {
+        const auto& hc = hierarchy_chunks[h][chunkI];
+        m_scatter_chunk(m_hierarchy[h], vol_res[h], vecd_type(hc[1] * hc[3] * hc[5], 0.0), hc);
+      }
+      continue;
+    }
+
+    // Setup decompressor parameters, and decompress (or refine)! Dims are set for refining too,
+    //    because a chunk decoder might have never decoded anything, e.g., when the previous
+    //    bitstream only kept chunks of a region of interest.
+    const auto& c = chunks[chunkI];
+    decompressor->set_mem_policy(m_mem_policy);
+    decompressor->set_resumable(m_resumable);
+    decompressor->set_dims({c[1], c[3], c[5]});
+    if (refine)
+      chunk_rtn[chunkI * 2 + 1] = decompressor->refine(chunk_ptr, chunk_len, multi_res);
+    else {
+      chunk_rtn[chunkI * 2] = decompressor->use_bitstream(chunk_ptr, chunk_len);
+      chunk_rtn[chunkI * 2 + 1] = decompressor->decompress(multi_res);
+    }
+    auto& profile = m_chunk_profiles[chunkI];
+    profile = decompressor->view_profile();
     const auto& small_vol = decompressor->view_decoded_data();
-    m_scatter_chunk(m_vol_buf, m_dims, small_vol, chunks[chunkI]);
+    if (chunk_rtn[chunkI * 2] != RTNType::Good || chunk_rtn[chunkI * 2 + 1] != RTNType::Good ||
+        small_vol.size() != c[1] * c[3] * c[5]) {
+      if (chunk_rtn[chunkI * 2 + 1] == RTNType::Good)
+        chunk_rtn[chunkI * 2 + 1] = RTNType::Error;
+      continue;
+    }
+    auto timer = Stage_Timer(profile, Stage::Gather);
+    m_scatter_chunk(m_vol_buf, m_dims, small_vol, c);
 
     // Also assemble the full hierarchy.
     if (multi_res) {
@@ -134,6 +219,107 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
     return RTNType::Good;
 }
 
+void sperr::SPERR3D_OMP_D::m_make_thread_decompressors()
+{
+#ifdef USE_OMP
+  m_decompressors.resize(m_num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK3D_FLT>();
+  });
+#else
+  if (m_decompressor == nullptr)
+    m_decompressor = std::make_unique<SPECK3D_FLT>();
+#endif
+}
+
+auto sperr::SPERR3D_OMP_D::decompress_region(const void* p,
+                                             std::array<size_t, 6> region,
+                                             vecd_type& dst) -> RTNType
+{
+  if (p != m_bitstream_ptr)
+    return RTNType::Error;
+  auto eq0 = [](auto v) { return v == 0; };
+  if (std::any_of(m_dims.cbegin(), m_dims.cend(), eq0) ||
+      std::any_of(m_chunk_dims.cbegin(), m_chunk_dims.cend(), eq0))
+    return RTNType::Error;
+  for (size_t i = 0; i < 3; i++) {
+    if (region[i * 2 + 1] == 0 || region[i * 2] + region[i * 2 + 1] > m_dims[i])
+      return RTNType::Error;
+  }
+
+  // Find out chunks that intersect with the region.
+  const auto chunks = sperr::chunk_volume(m_dims, m_chunk_dims);
+  auto overlap = [&region](const std::array<size_t, 6>& c, size_t i) {
+    const auto beg = std::max(c[i * 2], region[i * 2]);
+    const auto end = std::min(c[i * 2] + c[i * 2 + 1], region[i * 2] + region[i * 2 + 1]);
+    return std::array<size_t, 2>{beg, end};
+  };
+  auto hits = std::vector<size_t>();
+  for (size_t i = 0; i < chunks.size(); i++) {
+    auto hit = true;
+    for (size_t d = 0; d < 3; d++) {
+      const auto [beg, end] = overlap(chunks[i], d);
+      hit = hit && (beg < end);
+    }
+    if (hit)
+      hits.push_back(i);
+  }
+
+  m_make_thread_decompressors();
+  m_chunk_profiles.assign(chunks.size(), {});
+  dst.resize(region[1] * region[3] * region[5]);
+  auto chunk_rtn = std::vector<RTNType>(hits.size(), RTNType::Good);
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < hits.size(); i++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    const auto chunkI = hits[i];
+    const auto& c = chunks[chunkI];
+    const auto chunk_len = m_offsets[chunkI * 2 + 1];
+    if (chunk_len == 0) {  // The bitstream doesn't have a chunk that the region needs.
+      chunk_rtn[i] = RTNType::WrongLength;
+      continue;
+    }
+    decompressor->set_mem_policy(m_mem_policy);
+    decompressor->set_resumable(false);
+    decompressor->set_dims({c[1], c[3], c[5]});
+    const auto* chunk_ptr = m_bitstream_ptr + m_offsets[chunkI * 2];
+    chunk_rtn[i] = decompressor->use_bitstream(chunk_ptr, chunk_len);
+    if (chunk_rtn[i] == RTNType::Good)
+      chunk_rtn[i] = decompressor->decompress(false);
+    if (chunk_rtn[i] != RTNType::Good)
+      continue;
+    auto& profile = m_chunk_profiles[chunkI];
+    profile = decompressor->view_profile();
+    auto timer = Stage_Timer(profile, Stage::Gather);
+
+    // Copy the part of this chunk that's inside of the region to `dst`.
+    const auto& small_vol = decompressor->view_decoded_data();
+    const auto [x0, x1] = overlap(c, 0);
+    const auto [y0, y1] = overlap(c, 1);
+    const auto [z0, z1] = overlap(c, 2);
+    for (size_t z = z0; z < z1; z++) {
+      for (size_t y = y0; y < y1; y++) {
+        const auto src = ((z - c[4]) * c[3] + (y - c[2])) * c[1] + (x0 - c[0]);
+        const auto dst_i = ((z - region[4]) * region[3] + (y - region[2])) * region[1] +
+                           (x0 - region[0]);
+        std::copy(small_vol.cbegin() + src, small_vol.cbegin() + src + (x1 - x0),
+                  dst.begin() + dst_i);
+      }
+    }
+  }
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  return (fail == chunk_rtn.end()) ? RTNType::Good : *fail;
+}
+
 auto sperr::SPERR3D_OMP_D::release_decoded_data() -> sperr::vecd_type&&
 {
   return std::move(m_vol_buf);
@@ -164,6 +350,11 @@ auto sperr::SPERR3D_OMP_D::get_chunk_dims() const -> std::array<size_t, 3>
   return m_chunk_dims;
 }
 
+auto sperr::SPERR3D_OMP_D::view_chunk_profiles() const -> const std::vector<Profile>&
+{
+  return m_chunk_profiles;
+}
+
 void sperr::SPERR3D_OMP_D::m_scatter_chunk(vecd_type& big_vol,
                                            dims_type vol_dim,
                                            const vecd_type& small_vol,
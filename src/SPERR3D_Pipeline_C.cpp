@@ -0,0 +1,300 @@
+#include "SPERR3D_Pipeline_C.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+auto seconds_since(clock_type::time_point start) -> double
+{
+  return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// A first-in-first-out queue holding at most `capacity` items. `pop()` blocks until an item is
+//    available, and returns an empty optional once the queue is closed and all items are taken.
+template <typename T>
+class Bounded_Queue {
+ public:
+  explicit Bounded_Queue(size_t capacity) : m_capacity(std::max(capacity, size_t{1})) {}
+
+  void push(T item)
+  {
+    auto lock = std::unique_lock(m_mutex);
+    m_not_full.wait(lock, [this] { return m_items.size() < m_capacity; });
+    m_items.push_back(std::move(item));
+    m_not_empty.notify_one();
+  }
+
+  auto pop() -> std::optional<T>
+  {
+    auto lock = std::unique_lock(m_mutex);
+    m_not_empty.wait(lock, [this] { return !m_items.empty() || m_closed; });
+    if (m_items.empty())
+      return std::nullopt;
+    auto item = std::optional<T>(std::move(m_items.front()));
+    m_items.pop_front();
+    m_not_full.notify_one();
+    return item;
+  }
+
+  // No more items will be pushed.
+  void close()
+  {
+    auto lock = std::lock_guard(m_mutex);
+    m_closed = true;
+    m_not_empty.notify_all();
+  }
+
+ private:
+  const size_t m_capacity;
+  bool m_closed = false;
+  std::deque<T> m_items;
+  std::mutex m_mutex;
+  std::condition_variable m_not_full, m_not_empty;
+};
+
+}  // anonymous namespace
+
+void sperr::SPERR3D_Pipeline_C::set_num_threads(size_t n)
+{
+  if (n == 0)
+    n = std::thread::hardware_concurrency();
+  m_num_workers = std::max(n, size_t{1});
+}
+
+void sperr::SPERR3D_Pipeline_C::set_queue_depth(size_t depth)
+{
+  m_queue_depth = depth;
+}
+
+void sperr::SPERR3D_Pipeline_C::set_footer_index(bool footer)
+{
+  m_footer_index = footer;
+}
+
+auto sperr::SPERR3D_Pipeline_C::get_elapsed_time() const -> double
+{
+  return m_elapsed;
+}
+
+auto sperr::SPERR3D_Pipeline_C::get_stage_utilization() const -> std::array<double, 3>
+{
+  auto util = std::array<double, 3>{0.0, 0.0, 0.0};
+  if (m_elapsed > 0.0)
+    std::transform(m_busy.cbegin(), m_busy.cend(), util.begin(),
+                   [elapsed = m_elapsed](auto b) { return std::min(b / elapsed, 1.0); });
+  return util;
+}
+
+template <typename T>
+auto sperr::SPERR3D_Pipeline_C::compress_file(const std::string& input, const std::string& output)
+    -> RTNType
+{
+  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
+  m_orig_is_float = std::is_same_v<T, float>;
+  m_large_header = true;
+  m_elapsed = 0.0;
+  m_busy = {0.0, 0.0, 0.0};
+
+  if (m_mode == sperr::CompMode::Unknown)
+    return RTNType::CompModeUnknown;
+
+  auto closer = [](std::FILE* f) { std::fclose(f); };  // bypass a compiler warning
+  std::unique_ptr<std::FILE, decltype(closer)> in(std::fopen(input.data(), "rb"), closer);
+  if (!in)
+    return RTNType::IOError;
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  if (std::fseek(in.get(), 0, SEEK_END) != 0)
+    return RTNType::IOError;
+  const long file_len = std::ftell(in.get());
+  if (file_len == -1L)
+    return RTNType::IOError;
+  if (static_cast<size_t>(file_len) != total_vals * sizeof(T))
+    return RTNType::WrongLength;
+  std::rewind(in.get());
+
+  std::unique_ptr<std::FILE, decltype(closer)> out(std::fopen(output.data(), "wb"), closer);
+  if (!out)
+    return RTNType::IOError;
+
+  // Chunks are ordered with Z being the slowest axis, so chunks sharing the same Z range make up
+  //    a contiguous slab of the input file, and slabs are read one after another.
+  const auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
+  const auto num_chunks = chunk_idx.size();
+  const auto depth = (m_queue_depth == 0 ? 2 * m_num_workers : m_queue_depth);
+
+  // Each chunk bitstream is kept in `m_encoded_streams` only until it's written out.
+  //    The large header has a fixed length, so chunks go right after it.
+  m_encoded_streams.assign(num_chunks, {});
+  m_chunk_profiles.assign(num_chunks, {});
+  if (m_rd_enabled)
+    m_rd_tables.assign(num_chunks, {});
+  else
+    m_rd_tables.clear();
+  auto lens = std::vector<size_t>(num_chunks, 0);
+  if (std::fseek(out.get(), long(m_header_len(lens)), SEEK_SET) != 0)
+    return RTNType::IOError;
+
+  m_pool.resize(m_num_workers);
+  for (auto& p : m_pool) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK3D_FLT>();
+  }
+
+  // State shared by all stages: the number of chunks written, the first error, and chunk buffers
+  //    that compressor threads are done with, so the reader can reuse their memory.
+  auto mutex = std::mutex();
+  auto written_cv = std::condition_variable();
+  size_t written = 0;
+  auto rtn = RTNType::Good;
+  auto spare_bufs = std::vector<vecd_type>();
+  auto fail = [&](RTNType r) {
+    auto lock = std::lock_guard(mutex);
+    if (rtn == RTNType::Good)
+      rtn = r;
+    written_cv.notify_all();
+  };
+
+  auto jobs = Bounded_Queue<std::pair<size_t, vecd_type>>(depth);
+  auto done = Bounded_Queue<std::pair<size_t, RTNType>>(depth);
+  auto worker_busy = std::vector<double>(m_num_workers, 0.0);
+  const auto start = clock_type::now();
+
+  // Stage 2: compressor threads.
+  auto workers = std::vector<std::thread>();
+  for (size_t w = 0; w < m_num_workers; w++) {
+    workers.emplace_back([&, w] {
+      while (auto job = jobs.pop()) {
+        const auto t0 = clock_type::now();
+        auto r = m_encode_chunk(*m_pool[w], job->first, chunk_idx[job->first], job->second);
+        worker_busy[w] += seconds_since(t0);
+        {
+          auto lock = std::lock_guard(mutex);
+          spare_bufs.push_back(std::move(job->second));
+        }
+        done.push({job->first, r});
+      }
+    });
+  }
+
+  // Stage 3: the writer, which writes chunk bitstreams in order as soon as they're available.
+  auto writer = std::thread([&] {
+    auto ready = std::vector<bool>(num_chunks, false);
+    size_t next = 0;
+    auto good = true;
+    while (auto item = done.pop()) {
+      if (item->second != RTNType::Good) {
+        fail(item->second);
+        good = false;
+      }
+      ready[item->first] = true;
+      while (good && next < num_chunks && ready[next]) {
+        const auto t0 = clock_type::now();
+        auto& stream = m_encoded_streams[next];
+        if (std::fwrite(stream.data(), 1, stream.size(), out.get()) != stream.size()) {
+          fail(RTNType::IOError);
+          good = false;
+        }
+        lens[next] = stream.size();
+        vec8_type().swap(stream);
+        m_busy[2] += seconds_since(t0);
+
+        auto lock = std::lock_guard(mutex);
+        written = ++next;
+        written_cv.notify_all();
+      }
+    }
+  });
+
+  // Stage 1: the reader, which runs in the calling thread. It stays at most `depth` chunks ahead
+  //    of the writer.
+  auto slab = uninit_vec_type<T>();
+  auto slab_z = std::numeric_limits<size_t>::max();
+  auto range = std::array<T, 2>{std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest()};
+  for (size_t i = 0; i < num_chunks; i++) {
+    auto buf = vecd_type();
+    {
+      auto lock = std::unique_lock(mutex);
+      written_cv.wait(lock, [&] { return i < written + depth || rtn != RTNType::Good; });
+      if (rtn != RTNType::Good)
+        break;
+      if (!spare_bufs.empty()) {
+        buf = std::move(spare_bufs.back());
+        spare_bufs.pop_back();
+      }
+    }
+
+    const auto t0 = clock_type::now();
+    auto chunk = chunk_idx[i];
+    if (chunk[4] != slab_z) {
+      slab_z = chunk[4];
+      slab.resize(m_dims[0] * m_dims[1] * chunk[5]);
+      if (std::fread(slab.data(), sizeof(T), slab.size(), in.get()) != slab.size()) {
+        fail(RTNType::IOError);
+        break;
+      }
+      if (m_rd_enabled) {
+        auto [min, max] = std::minmax_element(slab.cbegin(), slab.cend());
+        range = {std::min(range[0], *min), std::max(range[1], *max)};
+      }
+    }
+    chunk[4] = 0;  // Z offset within the slab.
+    {
+      auto timer = Stage_Timer(m_chunk_profiles[i], Stage::Gather);
+      m_gather_chunk(slab.data(), {m_dims[0], m_dims[1], chunk[5]}, chunk, buf,
+                     m_chunk_profiles[i]);
+    }
+    m_busy[0] += seconds_since(t0);
+    jobs.push({i, std::move(buf)});
+  }
+
+  jobs.close();
+  for (auto& t : workers)
+    t.join();
+  done.close();
+  writer.join();
+  if (rtn != RTNType::Good)
+    return rtn;
+
+  // Finally, write the rate-distortion section, the chunk index if it's a footer, and the header.
+  const auto t0 = clock_type::now();
+  if (m_rd_enabled)
+    m_data_range = double(range[1]) - double(range[0]);
+  auto tail = vec8_type(m_rd_section_len());
+  m_write_rd_section(tail.data());
+  if (m_footer_index) {
+    const auto index = m_chunk_index(lens);
+    const auto* p = reinterpret_cast<const uint8_t*>(index.data());
+    tail.insert(tail.end(), p, p + index.size() * sizeof(uint64_t));
+  }
+  const auto header = m_generate_header(lens);
+  if (header.empty())
+    return RTNType::Error;
+  if (std::fwrite(tail.data(), 1, tail.size(), out.get()) != tail.size() ||
+      std::fseek(out.get(), 0, SEEK_SET) != 0 ||
+      std::fwrite(header.data(), 1, header.size(), out.get()) != header.size())
+    return RTNType::IOError;
+  m_busy[2] += seconds_since(t0);
+
+  m_elapsed = seconds_since(start);
+  m_busy[1] = std::accumulate(worker_busy.cbegin(), worker_busy.cend(), 0.0) / m_num_workers;
+  m_encoded_streams.clear();
+  m_rd_tables.clear();
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR3D_Pipeline_C::compress_file<float>(const std::string&,
+                                                              const std::string&) -> RTNType;
+template auto sperr::SPERR3D_Pipeline_C::compress_file<double>(const std::string&,
+                                                               const std::string&) -> RTNType;
@@ -0,0 +1,68 @@
+#include "SPERR3D_Series_C.h"
+
+#include <algorithm>
+#include <cassert>
+
+template <typename T>
+auto sperr::SPERR3D_Series_C::compress(const T* buf, size_t buf_len, const T* next_buf)
+    -> RTNType
+{
+  if (m_dims != m_idx_dims || m_chunk_dims != m_idx_chunk_dims) {
+    m_chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
+    m_idx_dims = m_dims;
+    m_idx_chunk_dims = m_chunk_dims;
+    m_chunk_bufs.resize(m_chunk_idx.size());
+    m_staged = nullptr;
+  }
+  const auto num_chunks = m_chunk_idx.size();
+
+  auto rtn = m_prepare_chunks(buf, buf_len, num_chunks);
+  if (rtn != RTNType::Good) {
+    m_staged = nullptr;
+    return rtn;
+  }
+
+  // Chunks of `buf` were gathered during the previous call only if it was passed in as
+  //    `next_buf` back then.
+  const auto staged = (m_staged == buf && m_staged_is_float == std::is_same_v<T, float>);
+  auto chunk_rtn = std::vector<RTNType>(num_chunks, RTNType::Good);
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_chunks; i++) {
+    auto& chunk = m_chunk_bufs[i];
+    if (!staged) {
+      auto timer = Stage_Timer(m_chunk_profiles[i], Stage::Gather);
+      m_gather_chunk<T>(buf, m_dims, m_chunk_idx[i], chunk, m_chunk_profiles[i]);
+    }
+    assert(chunk.size() == m_chunk_idx[i][1] * m_chunk_idx[i][3] * m_chunk_idx[i][5]);
+    chunk_rtn[i] = m_encode_chunk(m_thread_compressor(), i, m_chunk_idx[i], chunk);
+
+    // While other threads are still encoding, gather the same chunk of the next time step.
+    if (next_buf) {
+      auto timer = Stage_Timer(m_chunk_profiles[i], Stage::Gather);
+      m_gather_chunk<T>(next_buf, m_dims, m_chunk_idx[i], chunk, m_chunk_profiles[i]);
+    }
+  }
+
+  m_staged = next_buf;
+  m_staged_is_float = std::is_same_v<T, float>;
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return (*fail);
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR3D_Series_C::compress(const float*, size_t, const float*) -> RTNType;
+template auto sperr::SPERR3D_Series_C::compress(const double*, size_t, const double*) -> RTNType;
+
+auto sperr::SPERR3D_Series_C::assemble_encoded_bitstream() -> const vec8_type&
+{
+  // Resizing a vector never gives its memory back, so the output stays at its high-water mark.
+  m_output.resize(get_encoded_bitstream_len());
+  if (write_encoded_bitstream(m_output.data(), m_output.size()) != RTNType::Good)
+    m_output.clear();
+
+  return m_output;
+}
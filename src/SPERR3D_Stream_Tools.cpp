@@ -7,12 +7,27 @@
 #include <cmath>
 #include <cstring>
 #include <numeric>
+#include <queue>
+
+void sperr::SPERR3D_Stream_Tools::set_num_threads(size_t n)
+{
+  m_num_threads = n;
+}
 
 auto sperr::SPERR3D_Stream_Tools::get_header_len(std::array<uint8_t, 20> magic) const -> size_t
 {
   // Step 1: Decode the 8 booleans, and decide if there are multiple chunks.
   const auto b8 = sperr::unpack_8_booleans(magic[1]);
   const auto multi_chunk = b8[3];
+  const auto has_rd_table = b8[5];
+  const auto large_header = b8[6];
+
+  // A large header records its own length.
+  if (large_header) {
+    uint64_t header_len = 0;
+    std::memcpy(&header_len, magic.data() + 2, sizeof(header_len));
+    return header_len;
+  }
 
   // Step 2: Extract volume and chunk dimensions
   size_t pos = 2;
@@ -39,6 +54,8 @@ auto sperr::SPERR3D_Stream_Tools::get_header_len(std::array<uint8_t, 20> magic)
     header_len += m_header_magic_nchunks;
   else
     header_len += m_header_magic_1chunk;
+  if (has_rd_table)
+    header_len += 4;
 
   return header_len;
 }
@@ -58,6 +75,39 @@ auto sperr::SPERR3D_Stream_Tools::get_stream_header(const void* p) const -> SPER
   header.is_3D = b8[1];
   header.is_float = b8[2];
   header.multi_chunk = b8[3];
+  header.has_rd_table = b8[5];
+  header.large_header = b8[6];
+
+  // Step 2.1: a large header has its own layout; see `SPERR3D_OMP_C::m_generate_header()`.
+  if (header.large_header) {
+    uint64_t u64 = 0;
+    std::memcpy(&u64, u8p + pos, sizeof(u64));
+    header.header_len = u64;
+    std::memcpy(&u64, u8p + pos + 8, sizeof(u64));
+    header.index_offset = u64;
+    pos = m_header_magic_nchunks;
+
+    uint64_t long6[6] = {0, 0, 0, 0, 0, 0};
+    std::memcpy(long6, u8p + pos, sizeof(long6));
+    pos += sizeof(long6);
+    header.vol_dims = {long6[0], long6[1], long6[2]};
+    header.chunk_dims = {long6[3], long6[4], long6[5]};
+    if (header.has_rd_table) {
+      uint32_t rd_len = 0;
+      std::memcpy(&rd_len, u8p + pos, sizeof(rd_len));
+      header.rd_table_len = rd_len;
+    }
+
+    const auto num_chunks = sperr::chunk_volume(header.vol_dims, header.chunk_dims).size();
+    header.index_len = (num_chunks + 1) * sizeof(uint64_t);
+    header.footer_index = (header.index_offset >= header.header_len);
+    if (header.footer_index)
+      header.stream_len = header.index_offset + header.index_len;
+    else
+      read_chunk_index(header, u8p + header.index_offset);
+
+    return header;
+  }
 
   // Step 3: volume and chunk dimensions
   uint32_t int3[3] = {0, 0, 0};
@@ -92,6 +142,15 @@ auto sperr::SPERR3D_Stream_Tools::get_stream_header(const void* p) const -> SPER
 
   const auto* chunk_len = reinterpret_cast<const uint32_t*>(u8p + pos);
   header.stream_len = std::accumulate(chunk_len, chunk_len + num_chunks, header.header_len);
+  header.rd_table_offset = header.stream_len;
+  if (header.has_rd_table) {
+    uint32_t rd_len = 0;
+    std::memcpy(&rd_len, u8p + pos + num_chunks * 4, sizeof(rd_len));
+    header.rd_table_len = rd_len;
+    header.header_len += sizeof(rd_len);
+    header.rd_table_offset += sizeof(rd_len);
+    header.stream_len += sizeof(rd_len) + rd_len;
+  }
 
   header.chunk_offsets.resize(num_chunks * 2);
   header.chunk_offsets[0] = header.header_len;
@@ -104,27 +163,83 @@ auto sperr::SPERR3D_Stream_Tools::get_stream_header(const void* p) const -> SPER
   return header;
 }
 
-auto sperr::SPERR3D_Stream_Tools::progressive_read(const std::string& filename,
-                                                   unsigned pct) const -> vec8_type
+void sperr::SPERR3D_Stream_Tools::read_chunk_index(SPERR3D_Header& header,
+                                                   const void* index_buf) const
+{
+  // The index keeps the absolute offset of every chunk, followed by where the last chunk ends.
+  const auto num_chunks = header.index_len / sizeof(uint64_t) - 1;
+  auto offsets = std::vector<uint64_t>(num_chunks + 1);
+  std::memcpy(offsets.data(), index_buf, header.index_len);
+
+  header.chunk_offsets.resize(num_chunks * 2);
+  for (size_t i = 0; i < num_chunks; i++) {
+    header.chunk_offsets[i * 2] = offsets[i];
+    header.chunk_offsets[i * 2 + 1] = offsets[i + 1] - offsets[i];
+  }
+  header.rd_table_offset = offsets[num_chunks];
+  if (!header.footer_index)
+    header.stream_len = offsets[num_chunks] + header.rd_table_len;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_read_header(const std::string& filename) const
+    -> std::tuple<vec8_type, SPERR3D_Header>
 {
+  auto rtn_val = std::tuple<vec8_type, SPERR3D_Header>();
+
   // Read the header of this bitstream.
   auto vec20 = sperr::read_n_bytes(filename, 20);
   if (vec20.empty())
-    return vec20;
+    return rtn_val;
   auto arr20 = std::array<uint8_t, 20>();
   std::copy(vec20.cbegin(), vec20.cend(), arr20.begin());
   const auto header_len = this->get_header_len(arr20);
   auto header_buf = sperr::read_n_bytes(filename, header_len);
+  if (header_buf.empty())
+    return rtn_val;
+  auto header = this->get_stream_header(header_buf.data());
+
+  // Read the chunk index too if it's in a footer.
+  if (header.footer_index) {
+    auto index_buf = vec8_type();
+    const auto section = std::vector<size_t>{header.index_offset, header.index_len};
+    if (sperr::read_sections(filename, section, index_buf) != RTNType::Good)
+      return rtn_val;
+    read_chunk_index(header, index_buf.data());
+  }
+
+  std::get<0>(rtn_val) = std::move(header_buf);
+  std::get<1>(rtn_val) = std::move(header);
+  return rtn_val;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_parse_stream(const void* stream, size_t stream_len) const
+    -> SPERR3D_Header
+{
+  assert(stream_len >= 20);
+  auto header = this->get_stream_header(stream);
+  if (header.footer_index) {
+    if (stream_len < header.stream_len)
+      return header;
+    read_chunk_index(header, static_cast<const uint8_t*>(stream) + header.index_offset);
+  }
+
+  return header;
+}
+
+auto sperr::SPERR3D_Stream_Tools::progressive_read(const std::string& filename,
+                                                   unsigned pct) const -> vec8_type
+{
+  // Read the header of this bitstream.
+  auto [header_buf, header] = m_read_header(filename);
   if (header_buf.empty())
     return header_buf;
 
   // Get the new header and chunk offsets to read.
-  auto [header_new, chunk_offsets] =
-      m_progressive_helper(header_buf.data(), header_buf.size(), pct);
+  auto [header_new, chunk_offsets] = m_progressive_helper(header_buf.data(), std::move(header), pct);
 
   // Read portions of the bitstream from disk!
   auto stream_new = std::move(header_new);
-  auto rtn = sperr::read_sections(filename, chunk_offsets, stream_new);
+  auto rtn = sperr::read_sections(filename, chunk_offsets, stream_new, m_num_threads);
   if (rtn != RTNType::Good)
     stream_new.clear();
 
@@ -135,16 +250,13 @@ auto sperr::SPERR3D_Stream_Tools::progressive_truncate(const void* stream,
                                                        size_t stream_len,
                                                        unsigned pct) const -> vec8_type
 {
-  const auto* u8p = static_cast<const uint8_t*>(stream);
-
-  // Get the header length of this bitstream.
-  assert(stream_len >= 20);
-  auto arr20 = std::array<uint8_t, 20>();
-  std::copy(u8p, u8p + 20, arr20.begin());
-  const auto header_len = this->get_header_len(arr20);
+  // Parse the header of this bitstream.
+  auto header = m_parse_stream(stream, stream_len);
+  if (header.chunk_offsets.empty())
+    return vec8_type();
 
   // Get the new header and chunk offsets to truncate.
-  auto [header_new, chunk_offsets] = m_progressive_helper(stream, header_len, pct);
+  auto [header_new, chunk_offsets] = m_progressive_helper(stream, std::move(header), pct);
 
   // Truncate portions of the bitstream!
   auto stream_new = std::move(header_new);
@@ -156,25 +268,20 @@ auto sperr::SPERR3D_Stream_Tools::progressive_truncate(const void* stream,
 }
 
 auto sperr::SPERR3D_Stream_Tools::m_progressive_helper(const void* header_buf,
-                                                       size_t buf_len,
+                                                       SPERR3D_Header header,
                                                        unsigned pct) const
     -> std::tuple<vec8_type, std::vector<size_t>>
 {
   auto rtn_val = std::tuple<vec8_type, std::vector<size_t>>();
   const auto* u8p = static_cast<const uint8_t*>(header_buf);
 
-  // Parse the header.
-  //
-  auto header = this->get_stream_header(header_buf);
-
   // If the request is beyond range, return the complete bitstream!
   //
   if (pct == 0 || pct >= 100) {
-    // Copy over the header.
+    // Copy over the header, and then everything following it.
     std::get<0>(rtn_val).reserve(header.header_len);
     std::copy(u8p, u8p + header.header_len, std::back_inserter(std::get<0>(rtn_val)));
-    // Copy over the chunks info
-    std::get<1>(rtn_val) = std::move(header.chunk_offsets);
+    std::get<1>(rtn_val) = {header.header_len, header.stream_len - header.header_len};
     return rtn_val;
   }
 
@@ -183,43 +290,381 @@ auto sperr::SPERR3D_Stream_Tools::m_progressive_helper(const void* header_buf,
   //    bytes, e.g., when it's a constant chunk.
   assert(header.chunk_offsets.size() % 2 == 0);
   auto nchunks = header.chunk_offsets.size() / 2;
-  for (size_t i = 0; i < nchunks; i++) {
-    // Only touch the value stored at `chunk_offsets_new[i * 2 + 1]` if it's bigger than
-    // the minimal number of bytes to keep.
-    auto orig_len = header.chunk_offsets[i * 2 + 1];
-    if (orig_len > m_progressive_min_chunk_bytes) {
-      auto request_len = static_cast<size_t>(double(pct) / 100.0 * double(orig_len));
-      request_len = std::max(m_progressive_min_chunk_bytes, request_len);
-      header.chunk_offsets[i * 2 + 1] = request_len;
-    }
-  }
+  for (size_t i = 0; i < nchunks; i++)
+    header.chunk_offsets[i * 2 + 1] = m_progressive_len(header.chunk_offsets[i * 2 + 1], pct);
 
   // Finally, create a new header.
   //
-  auto header_new = vec8_type(header.header_len);
-  header_new[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  std::get<0>(rtn_val) = m_portion_header(header, header.chunk_offsets);
+  std::get<1>(rtn_val) = std::move(header.chunk_offsets);
+
+  return rtn_val;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_progressive_len(size_t orig_len, unsigned pct) const -> size_t
+{
+  // Only truncate a chunk if it's bigger than the minimal number of bytes to keep.
+  if (pct == 0 || pct >= 100 || orig_len <= m_progressive_min_chunk_bytes)
+    return orig_len;
+
+  auto request_len = static_cast<size_t>(double(pct) / 100.0 * double(orig_len));
+  return std::max(m_progressive_min_chunk_bytes, request_len);
+}
+
+auto sperr::SPERR3D_Stream_Tools::plan_ranges(const SPERR3D_Header& header_in,
+                                              std::array<size_t, 6> region,
+                                              unsigned pct,
+                                              size_t max_gap) const -> SPERR3D_Range_Plan
+{
+  auto plan = SPERR3D_Range_Plan();
+  auto header = header_in;
+  const auto chunks = sperr::chunk_volume(header.vol_dims, header.chunk_dims);
+  assert(chunks.size() * 2 == header.chunk_offsets.size());
+
+  // Keep chunks that intersect with `region`, and decide how many bytes to keep of each.
+  auto intersect = [&region](const std::array<size_t, 6>& c) {
+    for (size_t d = 0; d < 3; d++) {
+      if (c[d * 2] >= region[d * 2] + region[d * 2 + 1] || region[d * 2] >= c[d * 2] + c[d * 2 + 1])
+        return false;
+    }
+    return true;
+  };
+  for (size_t i = 0; i < chunks.size(); i++) {
+    auto& len = header.chunk_offsets[i * 2 + 1];
+    len = intersect(chunks[i]) ? m_progressive_len(len, pct) : 0;
+  }
+
+  // Chunks are stored in order in the bitstream, so ranges are naturally sorted. Merge a range
+  //    into the previous one if they're close enough.
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto offset = header.chunk_offsets[i * 2];
+    const auto len = header.chunk_offsets[i * 2 + 1];
+    if (len == 0)
+      continue;
+    if (!plan.ranges.empty()) {
+      const auto prev_end = plan.ranges[plan.ranges.size() - 2] + plan.ranges.back();
+      if (offset <= prev_end || offset - prev_end <= max_gap) {
+        plan.ranges.back() = std::max(prev_end, offset + len) - plan.ranges[plan.ranges.size() - 2];
+        continue;
+      }
+    }
+    plan.ranges.push_back(offset);
+    plan.ranges.push_back(len);
+  }
+
+  plan.header = m_portion_header(header, header.chunk_offsets);
+  plan.chunk_offsets = std::move(header.chunk_offsets);
+
+  return plan;
+}
+
+auto sperr::SPERR3D_Stream_Tools::assemble_ranges(const SPERR3D_Range_Plan& plan,
+                                                  const void* fetched,
+                                                  size_t fetched_len) const -> vec8_type
+{
+  const auto* u8p = static_cast<const uint8_t*>(fetched);
+  auto stream = vec8_type();
+
+  // Make sure that all ranges are fetched.
+  auto total_len = size_t{0};
+  for (size_t i = 1; i < plan.ranges.size(); i += 2)
+    total_len += plan.ranges[i];
+  if (fetched_len < total_len)
+    return stream;
+
+  // Copy over the header, and then each chunk from the range containing it.
+  stream.reserve(plan.header.size() + total_len);
+  stream = plan.header;
+  size_t range_idx = 0, range_pos = 0;  // Range containing the current chunk, and its position.
+  for (size_t i = 0; i < plan.chunk_offsets.size() / 2; i++) {
+    const auto offset = plan.chunk_offsets[i * 2];
+    const auto len = plan.chunk_offsets[i * 2 + 1];
+    if (len == 0)
+      continue;
+    while (offset >= plan.ranges[range_idx * 2] + plan.ranges[range_idx * 2 + 1]) {
+      range_pos += plan.ranges[range_idx * 2 + 1];
+      range_idx++;
+    }
+    assert(offset >= plan.ranges[range_idx * 2]);
+    const auto* beg = u8p + range_pos + (offset - plan.ranges[range_idx * 2]);
+    std::copy(beg, beg + len, std::back_inserter(stream));
+  }
+
+  return stream;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_portion_header(const SPERR3D_Header& header,
+                                                   const std::vector<size_t>& chunk_offsets) const
+    -> vec8_type
+{
+  const auto nchunks = chunk_offsets.size() / 2;
+  assert(nchunks == header.chunk_offsets.size() / 2);
+
+  const auto header_len = m_portion_header_len(header);
+  auto header_new = vec8_type(header_len);
+  header_new[0] = header.large_header ? extended_header_version
+                                      : static_cast<uint8_t>(SPERR_VERSION_MAJOR);
   size_t pos = 1;
-  auto b8 = sperr::unpack_8_booleans(u8p[pos]);
+  auto b8 = std::array<bool, 8>{false, false, false, false, false, false, false, false};
   b8[0] = true;  // Record that this is a portion of another complete bitstream.
+  b8[1] = header.is_3D;
+  b8[2] = header.is_float;
+  b8[3] = header.multi_chunk;
+  b8[6] = header.large_header;  // Note: a portion doesn't carry the rate-distortion section.
   header_new[pos++] = sperr::pack_8_booleans(b8);
-  // Copy over the volume and chunk dimensions.
-  if (header.multi_chunk) {
-    std::copy(u8p + pos, u8p + m_header_magic_nchunks, header_new.begin() + pos);
+
+  // A large header records its length, followed by the chunk index which is kept inline.
+  if (header.large_header) {
+    const uint64_t u64[2] = {header_len, m_header_magic_large};
+    std::memcpy(&header_new[pos], u64, sizeof(u64));
     pos = m_header_magic_nchunks;
+    const uint64_t long6[6] = {header.vol_dims[0],   header.vol_dims[1],   header.vol_dims[2],
+                               header.chunk_dims[0], header.chunk_dims[1], header.chunk_dims[2]};
+    std::memcpy(&header_new[pos], long6, sizeof(long6));
+    pos += sizeof(long6);
+    uint64_t offset = header_len;
+    for (size_t i = 0; i <= nchunks; i++) {
+      std::memcpy(&header_new[pos], &offset, sizeof(offset));
+      pos += sizeof(offset);
+      if (i < nchunks)
+        offset += chunk_offsets[i * 2 + 1];
+    }
+    assert(pos == header_len);
+    return header_new;
   }
-  else {
-    std::copy(u8p + pos, u8p + m_header_magic_1chunk, header_new.begin() + pos);
-    pos = m_header_magic_1chunk;
+
+  // Record the volume and chunk dimensions.
+  const uint32_t int3[3] = {static_cast<uint32_t>(header.vol_dims[0]),
+                            static_cast<uint32_t>(header.vol_dims[1]),
+                            static_cast<uint32_t>(header.vol_dims[2])};
+  std::memcpy(&header_new[pos], int3, sizeof(int3));
+  pos += sizeof(int3);
+  if (header.multi_chunk) {
+    const uint16_t short3[3] = {static_cast<uint16_t>(header.chunk_dims[0]),
+                                static_cast<uint16_t>(header.chunk_dims[1]),
+                                static_cast<uint16_t>(header.chunk_dims[2])};
+    std::memcpy(&header_new[pos], short3, sizeof(short3));
+    pos += sizeof(short3);
   }
 
   // Record the length of bitstreams for each chunk.
   for (size_t i = 0; i < nchunks; i++) {
-    uint32_t len = header.chunk_offsets[i * 2 + 1];
+    uint32_t len = chunk_offsets[i * 2 + 1];
     std::memcpy(&header_new[pos], &len, sizeof(len));
     pos += sizeof(len);
   }
-  assert(pos == header.header_len);
-  std::get<0>(rtn_val) = std::move(header_new);
+  assert(pos == header_len);
+
+  return header_new;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_portion_header_len(const SPERR3D_Header& header) const
+    -> size_t
+{
+  const auto nchunks = header.chunk_offsets.size() / 2;
+  if (header.large_header)
+    return m_header_magic_large + (nchunks + 1) * sizeof(uint64_t);
+  else
+    return (header.multi_chunk ? m_header_magic_nchunks : m_header_magic_1chunk) + nchunks * 4;
+}
+
+auto sperr::SPERR3D_Stream_Tools::read_to_psnr(const std::string& filename,
+                                               double psnr) const -> vec8_type
+{
+  return m_rd_read(filename, psnr, std::numeric_limits<size_t>::max());
+}
+
+auto sperr::SPERR3D_Stream_Tools::read_to_bytes(const std::string& filename,
+                                                size_t num_bytes) const -> vec8_type
+{
+  return m_rd_read(filename, 0.0, num_bytes);
+}
+
+auto sperr::SPERR3D_Stream_Tools::truncate_to_psnr(const void* stream,
+                                                   size_t stream_len,
+                                                   double psnr) const -> vec8_type
+{
+  return m_rd_truncate(stream, stream_len, psnr, std::numeric_limits<size_t>::max());
+}
+
+auto sperr::SPERR3D_Stream_Tools::truncate_to_bytes(const void* stream,
+                                                    size_t stream_len,
+                                                    size_t num_bytes) const -> vec8_type
+{
+  return m_rd_truncate(stream, stream_len, 0.0, num_bytes);
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_rd_read(const std::string& filename,
+                                            double psnr,
+                                            size_t num_bytes) const -> vec8_type
+{
+  // Read the header of this bitstream.
+  auto [header_buf, header] = m_read_header(filename);
+  if (header_buf.empty())
+    return header_buf;
+
+  // Read the rate-distortion section, which follows all chunks.
+  auto rd_buf = vec8_type();
+  if (!header.has_rd_table)
+    return rd_buf;
+  const auto rd_section = std::vector<size_t>{header.rd_table_offset, header.rd_table_len};
+  if (sperr::read_sections(filename, rd_section, rd_buf) != RTNType::Good)
+    return vec8_type();
+
+  // Get the new header and chunk offsets to read.
+  auto [header_new, chunk_offsets] = m_rd_helper(std::move(header), rd_buf.data(), psnr, num_bytes);
+  if (header_new.empty())
+    return header_new;
+
+  // Read portions of the bitstream from disk!
+  auto stream_new = std::move(header_new);
+  auto rtn = sperr::read_sections(filename, chunk_offsets, stream_new, m_num_threads);
+  if (rtn != RTNType::Good)
+    stream_new.clear();
+
+  return stream_new;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_rd_truncate(const void* stream,
+                                                size_t stream_len,
+                                                double psnr,
+                                                size_t num_bytes) const -> vec8_type
+{
+  const auto* u8p = static_cast<const uint8_t*>(stream);
+
+  // The rate-distortion section follows all chunks of a complete bitstream.
+  auto header = m_parse_stream(stream, stream_len);
+  if (!header.has_rd_table || header.chunk_offsets.empty() || stream_len < header.stream_len)
+    return vec8_type();
+  const auto* rd_buf = u8p + header.rd_table_offset;
+
+  // Get the new header and chunk offsets to truncate.
+  auto [header_new, chunk_offsets] = m_rd_helper(std::move(header), rd_buf, psnr, num_bytes);
+  if (header_new.empty())
+    return header_new;
+
+  // Truncate portions of the bitstream!
+  auto stream_new = std::move(header_new);
+  auto rtn = sperr::extract_sections(stream, stream_len, chunk_offsets, stream_new);
+  if (rtn != RTNType::Good)
+    stream_new.clear();
+
+  return stream_new;
+}
+
+auto sperr::SPERR3D_Stream_Tools::m_rd_helper(SPERR3D_Header header,
+                                              const void* rd_buf,
+                                              double psnr,
+                                              size_t num_bytes) const
+    -> std::tuple<vec8_type, std::vector<size_t>>
+{
+  auto rtn_val = std::tuple<vec8_type, std::vector<size_t>>();
+  assert(header.chunk_offsets.size() % 2 == 0);
+  const auto nchunks = header.chunk_offsets.size() / 2;
+
+  // Parse the rate-distortion section; see `SPERR3D_OMP_C::write_encoded_bitstream()`.
+  //
+  const auto* rdp = static_cast<const uint8_t*>(rd_buf);
+  auto data_range = 0.0;
+  std::memcpy(&data_range, rdp, sizeof(data_range));
+  size_t pos = sizeof(data_range);
+  auto tables = std::vector<rd_table_type>(nchunks);
+  for (auto& table : tables) {
+    if (pos >= header.rd_table_len)
+      return rtn_val;
+    const auto num_points = rdp[pos++];
+    if (pos + num_points * (sizeof(uint32_t) + sizeof(float)) > header.rd_table_len)
+      return rtn_val;
+    table.resize(num_points);
+    for (auto& point : table) {
+      uint32_t bytes = 0;
+      float sse = 0.0f;
+      std::memcpy(&bytes, rdp + pos, sizeof(bytes));
+      pos += sizeof(bytes);
+      std::memcpy(&sse, rdp + pos, sizeof(sse));
+      pos += sizeof(sse);
+      point = {bytes, sse};
+    }
+  }
+
+  // Translate the quality targets to a target SSE and a byte budget for all chunks.
+  //
+  const auto total_vals = header.vol_dims[0] * header.vol_dims[1] * header.vol_dims[2];
+  auto target_sse = 0.0;
+  if (psnr > 0.0)
+    target_sse = data_range * data_range / std::pow(10.0, psnr / 10.0) * double(total_vals);
+  const auto header_len = m_portion_header_len(header);
+  const auto budget = num_bytes > header_len ? num_bytes - header_len : size_t{0};
+
+  // Every chunk starts from its first rate-distortion point, and moves along the lower convex
+  //    hull of its points. Chunks without points (e.g., constant chunks) are kept in whole.
+  //
+  auto hulls = std::vector<rd_table_type>(nchunks);
+  auto hull_idx = std::vector<size_t>(nchunks, 0);
+  auto used = size_t{0};
+  auto sse = 0.0;
+  for (size_t i = 0; i < nchunks; i++) {
+    auto& hull = hulls[i];
+    for (const auto& p : tables[i]) {
+      while (hull.size() >= 2) {
+        // Drop the last point if it's on or above the line from its previous point to `p`.
+        const auto& a = hull[hull.size() - 2];
+        const auto& b = hull.back();
+        auto cross = double(b.bytes - a.bytes) * (p.sse - a.sse) -
+                     (b.sse - a.sse) * double(p.bytes - a.bytes);
+        if (cross <= 0.0)
+          hull.pop_back();
+        else
+          break;
+      }
+      hull.push_back(p);
+    }
+    if (!hull.empty()) {
+      header.chunk_offsets[i * 2 + 1] = std::min(hull[0].bytes, header.chunk_offsets[i * 2 + 1]);
+      sse += hull[0].sse;
+    }
+    used += header.chunk_offsets[i * 2 + 1];
+  }
+
+  // Greedily advance the chunk with the steepest distortion-rate slope, which keeps the slopes of
+  //    all chunks about equal. The last step may stop in the middle of a bitplane.
+  //
+  auto slope = [&hulls, &hull_idx](size_t i) {
+    const auto& a = hulls[i][hull_idx[i]];
+    const auto& b = hulls[i][hull_idx[i] + 1];
+    return (a.sse - b.sse) / double(b.bytes - a.bytes);
+  };
+  auto queue = std::priority_queue<std::pair<double, size_t>>();
+  for (size_t i = 0; i < nchunks; i++) {
+    if (hulls[i].size() > 1)
+      queue.emplace(slope(i), i);
+  }
+  while (!queue.empty() && sse > target_sse && used < budget) {
+    const auto i = queue.top().second;
+    queue.pop();
+    const auto& a = hulls[i][hull_idx[i]];
+    const auto& b = hulls[i][hull_idx[i] + 1];
+    const auto cost = b.bytes - a.bytes;
+    const auto gain = a.sse - b.sse;
+    auto extra = std::min(cost, budget - used);
+    if (sse - gain < target_sse) {
+      auto needed = std::ceil((sse - target_sse) / gain * double(cost));
+      extra = std::min(extra, static_cast<size_t>(needed));
+    }
+    header.chunk_offsets[i * 2 + 1] += extra;
+    used += extra;
+    if (extra < cost) {
+      sse -= gain * double(extra) / double(cost);
+      break;
+    }
+    sse -= gain;
+    if (++hull_idx[i] + 1 < hulls[i].size())
+      queue.emplace(slope(i), i);
+  }
+
+  // Finally, create a new header.
+  //
+  std::get<0>(rtn_val) = m_portion_header(header, header.chunk_offsets);
   std::get<1>(rtn_val) = std::move(header.chunk_offsets);
 
   return rtn_val;
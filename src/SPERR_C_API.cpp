@@ -1,55 +1,121 @@
+#include <algorithm>
 #include <cassert>
 
 #include "SPERR_C_API.h"
 
 #include "SPECK2D_FLT.h"
+#include "SPERR2D_OMP_C.h"
+#include "SPERR2D_OMP_D.h"
 #include "SPERR3D_OMP_C.h"
 #include "SPERR3D_OMP_D.h"
 
+#include "SPERR3D_Container.h"
 #include "SPERR3D_Stream_Tools.h"
 
-auto C_API::sperr_comp_2d(const void* src,
-                          int is_float,
-                          size_t dimx,
-                          size_t dimy,
-                          int mode,
-                          double quality,
-                          int out_inc_header,
-                          void** dst,
-                          size_t* dst_len) -> int
-{
-  // Examine if `dst` is pointing to a NULL pointer
-  if (*dst != nullptr)
-    return 1;
-  if (quality <= 0.0)
-    return 2;
+//
+// A context keeps (de)compressor objects, and the buffers they own, alive across calls.
+//    Each object is only created when it's used for the first time.
+//
+struct C_API::sperr_ctx {
+  std::unique_ptr<sperr::SPECK2D_FLT> speck2d;  // 2D compression and decompression
+  std::unique_ptr<sperr::SPERR3D_OMP_C> comp3d;
+  std::unique_ptr<sperr::SPERR3D_OMP_D> decomp3d;
+  sperr::vec8_type stream;  // 2D output bitstream
+};
 
-  // The actual encoding steps are just the same as in `utilities/sperr2d.cpp`.
-  auto encoder = std::make_unique<sperr::SPECK2D_FLT>();
-  encoder->set_dims({dimx, dimy, 1});
-  if (is_float)
-    encoder->copy_data(static_cast<const float*>(src), dimx * dimy);
-  else
-    encoder->copy_data(static_cast<const double*>(src), dimx * dimy);
+struct C_API::sperr_container_writer {
+  sperr::SPERR3D_Container_Writer writer;
+};
+
+struct C_API::sperr_container_reader {
+  sperr::SPERR3D_Container_Reader reader;
+};
 
+namespace {
+
+// Note: the helper functions in this anonymous namespace return the same values as the C API.
+
+template <typename Encoder>
+auto set_comp_mode(Encoder& encoder, int mode, double quality) -> int
+{
   switch (mode) {
     case 1:  // fixed bitrate
-      encoder->set_bitrate(quality);
+      encoder.set_bitrate(quality);
       break;
     case 2:  // fixed PSNR
-      encoder->set_psnr(quality);
+      encoder.set_psnr(quality);
       break;
     case 3:  // fixed PWE
-      encoder->set_tolerance(quality);
+      encoder.set_tolerance(quality);
       break;
     default:
       return 2;
   }
-  auto rtn = encoder->compress();
+  return 0;
+}
+
+// Upper bound of the bitstream size of a single chunk (or slice). See `sperr_comp_2d_max_size()`
+//    in the header for the exact meaning.
+auto chunk_max_size(size_t num_vals, int mode, double quality) -> size_t
+{
+  // Every chunk starts with a conditioner header and a SPECK header.
+  constexpr auto overhead = sizeof(sperr::condi_type) + sperr::SPECK_INT<uint8_t>::header_size;
+
+  // In fixed-rate mode, the bit budget is the same as what `SPECK_FLT` uses.
+  //    Note that a budget of 0 means no budget; see `SPECK_INT::set_budget()`.
+  if (mode == 1) {
+    const auto budget = static_cast<size_t>(quality * double(num_vals));
+    if (budget > 0)
+      return overhead + (budget + 7) / 8;
+  }
+
+  // In PWE mode, there might also be an outlier coder bitstream.
+  auto size = overhead + num_vals * sizeof(double);
+  if (mode == 3)
+    size += sperr::SPECK_INT<uint8_t>::header_size + num_vals * sizeof(double);
+  return size;
+}
+
+// Copy decompressed values to an output buffer, converting to floats if requested.
+void copy_to_output(const sperr::vecd_type& vals, int output_float, void* dst)
+{
+  if (output_float)
+    std::copy(vals.cbegin(), vals.cend(), static_cast<float*>(dst));
+  else
+    std::copy(vals.cbegin(), vals.cend(), static_cast<double*>(dst));
+}
+
+// Compress a 2D slice and put the bitstream in `ctx.stream`.
+auto comp_2d(C_API::sperr_ctx& ctx,
+             const void* src,
+             int is_float,
+             size_t dimx,
+             size_t dimy,
+             int mode,
+             double quality,
+             int out_inc_header) -> int
+{
+  if (quality <= 0.0)
+    return 2;
+
+  // The actual encoding steps are just the same as in `utilities/sperr2d.cpp`.
+  if (ctx.speck2d == nullptr)
+    ctx.speck2d = std::make_unique<sperr::SPECK2D_FLT>();
+  auto& encoder = *ctx.speck2d;
+  encoder.set_dims({dimx, dimy, 1});
+  if (is_float)
+    encoder.copy_data(static_cast<const float*>(src), dimx * dimy);
+  else
+    encoder.copy_data(static_cast<const double*>(src), dimx * dimy);
+
+  if (set_comp_mode(encoder, mode, quality) != 0)
+    return 2;
+  auto rtn = encoder.compress();
   if (rtn != sperr::RTNType::Good)
     return -1;
 
-  auto stream = sperr::vec8_type();
+  auto& stream = ctx.stream;
+  stream.clear();
   if (out_inc_header) {  // Assemble a header that's the same as the header in SPERR3D_OMP_C().
     // The header would contain the following information
     //  -- a version number                     (1 byte)
@@ -83,10 +149,109 @@ auto C_API::sperr_comp_2d(const void* src,
   }
 
   // Append the actual SPERR bitstream.
-  encoder->append_encoded_bitstream(stream);
-  encoder.reset();  // Free up some memory.
+  encoder.append_encoded_bitstream(stream);
+
+  return 0;
+}
+
+// Decompress a 2D slice, and keep the decompressed values in `ctx.speck2d`.
+auto decomp_2d(C_API::sperr_ctx& ctx, const void* src, size_t src_len, size_t dimx, size_t dimy)
+    -> int
+{
+  // Use a decoder, similar steps as in `utilities/sperr2d.cpp`.
+  if (ctx.speck2d == nullptr)
+    ctx.speck2d = std::make_unique<sperr::SPECK2D_FLT>();
+  auto& decoder = *ctx.speck2d;
+  decoder.set_dims({dimx, dimy, 1});
+  auto rtn = decoder.use_bitstream(src, src_len);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  rtn = decoder.decompress();
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  assert(decoder.view_decoded_data().size() == size_t{dimx} * dimy);
+
+  return 0;
+}
+
+// Compress a 3D volume, and keep the bitstream in `ctx.comp3d`.
+auto comp_3d(C_API::sperr_ctx& ctx,
+             const void* src,
+             int is_float,
+             sperr::dims_type dims,
+             sperr::dims_type chunks,
+             int mode,
+             double quality,
+             size_t nthreads) -> int
+{
+  if (quality <= 0.0)
+    return 2;
+
+  // Setup the compressor. Very similar steps as in `utilities/sperr3d.cpp`.
+  const auto total_vals = dims[0] * dims[1] * dims[2];
+  if (ctx.comp3d == nullptr)
+    ctx.comp3d = std::make_unique<sperr::SPERR3D_OMP_C>();
+  auto& encoder = *ctx.comp3d;
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_num_threads(nthreads);
+  if (set_comp_mode(encoder, mode, quality) != 0)
+    return 2;
+
+  auto rtn = sperr::RTNType::Good;
+  if (is_float)
+    rtn = encoder.compress(static_cast<const float*>(src), total_vals);
+  else  // double
+    rtn = encoder.compress(static_cast<const double*>(src), total_vals);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  if (encoder.get_encoded_bitstream_len() == 0)
+    return -1;
+
+  return 0;
+}
+
+// Decompress a 3D volume, and keep the decompressed values in `ctx.decomp3d`.
+auto decomp_3d(C_API::sperr_ctx& ctx, const void* src, size_t src_len, size_t nthreads) -> int
+{
+  // Use a decompressor to decompress this bitstream
+  if (ctx.decomp3d == nullptr)
+    ctx.decomp3d = std::make_unique<sperr::SPERR3D_OMP_D>();
+  auto& decoder = *ctx.decomp3d;
+  decoder.set_num_threads(nthreads);
+  auto rtn = decoder.use_bitstream(src, src_len);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  rtn = decoder.decompress(src);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+
+  return 0;
+}
+
+}  // namespace
+
+auto C_API::sperr_comp_2d(const void* src,
+                          int is_float,
+                          size_t dimx,
+                          size_t dimy,
+                          int mode,
+                          double quality,
+                          int out_inc_header,
+                          void** dst,
+                          size_t* dst_len) -> int
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+
+  auto ctx = sperr_ctx();
+  auto rtn = comp_2d(ctx, src, is_float, dimx, dimy, mode, quality, out_inc_header);
+  if (rtn != 0)
+    return rtn;
+  ctx.speck2d.reset();  // Free up some memory.
 
   // Allocate buffer and copy over the content of stream.
+  const auto& stream = ctx.stream;
   *dst_len = stream.size();
   auto* buf = (uint8_t*)std::malloc(*dst_len);
   std::copy(stream.cbegin(), stream.cend(), buf);
@@ -106,28 +271,17 @@ auto C_API::sperr_decomp_2d(const void* src,
   if (*dst != nullptr)
     return 1;
 
-  // Use a decoder, similar steps as in `utilities/sperr2d.cpp`.
-  auto decoder = std::make_unique<sperr::SPECK2D_FLT>();
-  decoder->set_dims({dimx, dimy, 1});
-  decoder->use_bitstream(src, src_len);
-  auto rtn = decoder->decompress();
-  if (rtn != sperr::RTNType::Good)
-    return -1;
-  auto outputd = decoder->release_decoded_data();
-  assert(outputd.size() == size_t{dimx} * dimy);
-  decoder.reset();
+  auto ctx = sperr_ctx();
+  auto rtn = decomp_2d(ctx, src, src_len, dimx, dimy);
+  if (rtn != 0)
+    return rtn;
+  auto outputd = ctx.speck2d->release_decoded_data();
+  ctx.speck2d.reset();
 
   // Provide decompressed data to `dst`.
-  if (output_float) {
-    auto* buf = (float*)std::malloc(outputd.size() * sizeof(float));
-    std::copy(outputd.cbegin(), outputd.cend(), buf);
-    *dst = buf;
-  }
-  else {  // double
-    auto* buf = (double*)std::malloc(outputd.size() * sizeof(double));
-    std::copy(outputd.cbegin(), outputd.cend(), buf);
-    *dst = buf;
-  }
+  auto* buf = std::malloc(outputd.size() * (output_float ? sizeof(float) : sizeof(double)));
+  copy_to_output(outputd, output_float, buf);
+  *dst = buf;
 
   return 0;
 }
@@ -143,8 +297,29 @@ void C_API::sperr_parse_header(const void* src,
   auto is_3d = b8[1];
   *is_float = int(b8[2]);
 
+  auto is_batch = !is_3d && b8[3];  // A batch of 2D slices; see SPERR2D_OMP_C.
+  auto is_1d = !is_3d && b8[4];     // A 1D array; see SPERR1D_OMP_C.
+  if (is_1d) {
+    auto len = uint64_t{0};
+    std::memcpy(&len, srcp + 2, sizeof(len));
+    *dimx = len;
+    *dimy = 1;
+    *dimz = 1;
+    return;
+  }
+
+  auto is_large = is_3d && b8[6];  // A large 3D header; see SPERR3D_OMP_C::set_large_header().
+  if (is_large) {
+    auto dims = std::array<uint64_t, 3>{1, 1, 1};
+    std::memcpy(dims.data(), srcp + 20, sizeof(dims));
+    *dimx = dims[0];
+    *dimy = dims[1];
+    *dimz = dims[2];
+    return;
+  }
+
   auto dims = std::array<uint32_t, 3>{1, 1, 1};
-  if (is_3d)
+  if (is_3d || is_batch)
     std::memcpy(dims.data(), srcp + 2, sizeof(uint32_t) * 3);
   else
     std::memcpy(dims.data(), srcp + 2, sizeof(uint32_t) * 2);
@@ -153,6 +328,113 @@ void C_API::sperr_parse_header(const void* src,
   *dimz = dims[2];
 }
 
+auto C_API::sperr_comp_2d_batch(const void* src,
+                                int is_float,
+                                size_t dimx,
+                                size_t dimy,
+                                size_t num_slices,
+                                int mode,
+                                double quality,
+                                size_t nthreads,
+                                void** dst,
+                                size_t* dst_len) -> int
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+  if (quality <= 0.0 || dimx * dimy * num_slices == 0)
+    return 2;
+
+  auto encoder = std::make_unique<sperr::SPERR2D_OMP_C>();
+  encoder->set_dims({dimx, dimy, num_slices});
+  encoder->set_num_threads(nthreads);
+  if (set_comp_mode(*encoder, mode, quality) != 0)
+    return 2;
+
+  auto rtn = sperr::RTNType::Good;
+  const auto total_vals = dimx * dimy * num_slices;
+  if (is_float)
+    rtn = encoder->compress(static_cast<const float*>(src), total_vals);
+  else  // double
+    rtn = encoder->compress(static_cast<const double*>(src), total_vals);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+
+  auto stream = encoder->get_encoded_bitstream();
+  if (stream.empty())
+    return -1;
+  encoder.reset();
+  *dst_len = stream.size();
+  auto* buf = (uint8_t*)std::malloc(stream.size());
+  std::copy(stream.cbegin(), stream.cend(), buf);
+  *dst = buf;
+
+  return 0;
+}
+
+auto C_API::sperr_decomp_2d_batch(const void* src,
+                                  size_t src_len,
+                                  int output_float,
+                                  size_t nthreads,
+                                  size_t* dimx,
+                                  size_t* dimy,
+                                  size_t* num_slices,
+                                  void** dst) -> int
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+
+  auto decoder = std::make_unique<sperr::SPERR2D_OMP_D>();
+  decoder->set_num_threads(nthreads);
+  auto rtn = decoder->use_bitstream(src, src_len);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  rtn = decoder->decompress(src);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  const auto dims = decoder->get_dims();
+  auto outputd = decoder->release_decoded_data();
+  decoder.reset();
+
+  *dimx = dims[0];
+  *dimy = dims[1];
+  *num_slices = dims[2];
+  auto* buf = std::malloc(outputd.size() * (output_float ? sizeof(float) : sizeof(double)));
+  copy_to_output(outputd, output_float, buf);
+  *dst = buf;
+
+  return 0;
+}
+
+auto C_API::sperr_decomp_2d_slice(const void* src,
+                                  size_t src_len,
+                                  int output_float,
+                                  size_t idx,
+                                  void** dst) -> int
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+
+  auto decoder = sperr::SPERR2D_OMP_D();
+  auto rtn = decoder.use_bitstream(src, src_len);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  if (idx >= decoder.get_dims()[2])
+    return 2;
+  rtn = decoder.decompress_slice(src, idx);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  const auto& outputd = decoder.view_decoded_slice();
+
+  auto* buf = std::malloc(outputd.size() * (output_float ? sizeof(float) : sizeof(double)));
+  copy_to_output(outputd, output_float, buf);
+  *dst = buf;
+
+  return 0;
+}
+
 auto C_API::sperr_comp_3d(const void* src,
                           int is_float,
                           size_t dimx,
@@ -170,43 +452,18 @@ auto C_API::sperr_comp_3d(const void* src,
   // Examine if `dst` is pointing to a NULL pointer
   if (*dst != nullptr)
     return 1;
-  if (quality <= 0.0)
-    return 2;
 
-  const auto dims = sperr::dims_type{dimx, dimy, dimz};
-  const auto chunks = sperr::dims_type{chunk_x, chunk_y, chunk_z};
-
-  // Setup the compressor. Very similar steps as in `utilities/sperr3d.cpp`.
-  const auto total_vals = dimx * dimy * dimz;
-  auto encoder = std::make_unique<sperr::SPERR3D_OMP_C>();
-  encoder->set_dims_and_chunks(dims, chunks);
-  encoder->set_num_threads(nthreads);
-  switch (mode) {
-    case 1:  // fixed bitrate
-      encoder->set_bitrate(quality);
-      break;
-    case 2:  // fixed PSNR
-      encoder->set_psnr(quality);
-      break;
-    case 3:  // fixed PWE
-      encoder->set_tolerance(quality);
-      break;
-    default:
-      return 2;
-  }
-  auto rtn = sperr::RTNType::Good;
-  if (is_float)
-    rtn = encoder->compress(static_cast<const float*>(src), total_vals);
-  else  // double
-    rtn = encoder->compress(static_cast<const double*>(src), total_vals);
-  if (rtn != sperr::RTNType::Good)
-    return -1;
+  auto ctx = sperr_ctx();
+  auto rtn = comp_3d(ctx, src, is_float, {dimx, dimy, dimz}, {chunk_x, chunk_y, chunk_z}, mode,
+                     quality, nthreads);
+  if (rtn != 0)
+    return rtn;
 
   // Prepare the compressed bitstream.
-  auto stream = encoder->get_encoded_bitstream();
+  auto stream = ctx.comp3d->get_encoded_bitstream();
   if (stream.empty())
     return -1;
-  encoder.reset();
+  ctx.comp3d.reset();
   *dst_len = stream.size();
   auto* buf = (uint8_t*)std::malloc(stream.size());
   std::copy(stream.cbegin(), stream.cend(), buf);
@@ -228,31 +485,21 @@ auto C_API::sperr_decomp_3d(const void* src,
   if (*dst != nullptr)
     return 1;
 
-  // Use a decompressor to decompress this bitstream
-  auto decoder = std::make_unique<sperr::SPERR3D_OMP_D>();
-  decoder->set_num_threads(nthreads);
-  decoder->use_bitstream(src, src_len);
-  auto rtn = decoder->decompress(src);
-  if (rtn != sperr::RTNType::Good)
-    return -1;
-  auto dims = decoder->get_dims();
-  auto outputd = decoder->release_decoded_data();
-  decoder.reset();
+  auto ctx = sperr_ctx();
+  auto rtn = decomp_3d(ctx, src, src_len, nthreads);
+  if (rtn != 0)
+    return rtn;
+  auto dims = ctx.decomp3d->get_dims();
+  auto outputd = ctx.decomp3d->release_decoded_data();
+  ctx.decomp3d.reset();
 
   // Provide the decompressed volume.
   *dimx = dims[0];
   *dimy = dims[1];
   *dimz = dims[2];
-  if (output_float) {
-    auto* buf = (float*)std::malloc(outputd.size() * sizeof(float));
-    std::copy(outputd.cbegin(), outputd.cend(), buf);
-    *dst = buf;
-  }
-  else {  // double
-    auto* buf = (double*)std::malloc(outputd.size() * sizeof(double));
-    std::copy(outputd.cbegin(), outputd.cend(), buf);
-    *dst = buf;
-  }
+  auto* buf = std::malloc(outputd.size() * (output_float ? sizeof(float) : sizeof(double)));
+  copy_to_output(outputd, output_float, buf);
+  *dst = buf;
 
   return 0;
 }
@@ -278,3 +525,271 @@ auto C_API::sperr_trunc_3d(const void* src,
     return 0;
   }
 }
+
+auto C_API::sperr_ctx_create() -> sperr_ctx*
+{
+  return new (std::nothrow) sperr_ctx();
+}
+
+void C_API::sperr_ctx_free(sperr_ctx* ctx)
+{
+  delete ctx;
+}
+
+auto C_API::sperr_comp_2d_max_size(size_t dimx,
+                                   size_t dimy,
+                                   int mode,
+                                   double quality,
+                                   int out_inc_header) -> size_t
+{
+  if (dimx * dimy == 0 || mode < 1 || mode > 3 || quality <= 0.0)
+    return 0;
+
+  auto size = chunk_max_size(dimx * dimy, mode, quality);
+  if (out_inc_header)
+    size += 10;
+  return size;
+}
+
+auto C_API::sperr_comp_3d_max_size(size_t dimx,
+                                   size_t dimy,
+                                   size_t dimz,
+                                   size_t chunk_x,
+                                   size_t chunk_y,
+                                   size_t chunk_z,
+                                   int mode,
+                                   double quality) -> size_t
+{
+  if (dimx * dimy * dimz == 0 || mode < 1 || mode > 3 || quality <= 0.0)
+    return 0;
+
+  // Let a compressor with the same settings as `comp_3d()` count its header, which might be
+  //    a large header depending on the dimensions and chunk lengths.
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks({dimx, dimy, dimz}, {chunk_x, chunk_y, chunk_z});
+  const auto chunks = sperr::chunk_volume({dimx, dimy, dimz}, {chunk_x, chunk_y, chunk_z});
+  auto lens = std::vector<size_t>(chunks.size());
+  std::transform(chunks.cbegin(), chunks.cend(), lens.begin(), [mode, quality](const auto& c) {
+    return chunk_max_size(c[1] * c[3] * c[5], mode, quality);
+  });
+  return encoder.max_encoded_bitstream_len(lens);
+}
+
+auto C_API::sperr_ctx_comp_2d(sperr_ctx* ctx,
+                              const void* src,
+                              int is_float,
+                              size_t dimx,
+                              size_t dimy,
+                              int mode,
+                              double quality,
+                              int out_inc_header,
+                              void* dst,
+                              size_t dst_cap,
+                              size_t* dst_len) -> int
+{
+  if (ctx == nullptr || dst == nullptr)
+    return 2;
+
+  auto rtn = comp_2d(*ctx, src, is_float, dimx, dimy, mode, quality, out_inc_header);
+  if (rtn != 0)
+    return rtn;
+
+  const auto& stream = ctx->stream;
+  *dst_len = stream.size();
+  if (dst_cap < stream.size())
+    return 3;
+  std::copy(stream.cbegin(), stream.cend(), static_cast<uint8_t*>(dst));
+
+  return 0;
+}
+
+auto C_API::sperr_ctx_decomp_2d(sperr_ctx* ctx,
+                                const void* src,
+                                size_t src_len,
+                                int output_float,
+                                size_t dimx,
+                                size_t dimy,
+                                void* dst) -> int
+{
+  if (ctx == nullptr || dst == nullptr)
+    return 2;
+
+  auto rtn = decomp_2d(*ctx, src, src_len, dimx, dimy);
+  if (rtn != 0)
+    return rtn;
+  copy_to_output(ctx->speck2d->view_decoded_data(), output_float, dst);
+
+  return 0;
+}
+
+auto C_API::sperr_ctx_comp_3d(sperr_ctx* ctx,
+                              const void* src,
+                              int is_float,
+                              size_t dimx,
+                              size_t dimy,
+                              size_t dimz,
+                              size_t chunk_x,
+                              size_t chunk_y,
+                              size_t chunk_z,
+                              int mode,
+                              double quality,
+                              size_t nthreads,
+                              void* dst,
+                              size_t dst_cap,
+                              size_t* dst_len) -> int
+{
+  if (ctx == nullptr || dst == nullptr)
+    return 2;
+
+  auto rtn = comp_3d(*ctx, src, is_float, {dimx, dimy, dimz}, {chunk_x, chunk_y, chunk_z}, mode,
+                     quality, nthreads);
+  if (rtn != 0)
+    return rtn;
+
+  *dst_len = ctx->comp3d->get_encoded_bitstream_len();
+  if (dst_cap < *dst_len)
+    return 3;
+  if (ctx->comp3d->write_encoded_bitstream(dst, dst_cap) != sperr::RTNType::Good)
+    return -1;
+
+  return 0;
+}
+
+auto C_API::sperr_ctx_decomp_3d(sperr_ctx* ctx,
+                                const void* src,
+                                size_t src_len,
+                                int output_float,
+                                size_t nthreads,
+                                size_t* dimx,
+                                size_t* dimy,
+                                size_t* dimz,
+                                void* dst,
+                                size_t dst_cap,
+                                size_t* dst_len) -> int
+{
+  if (ctx == nullptr || dst == nullptr)
+    return 2;
+
+  auto rtn = decomp_3d(*ctx, src, src_len, nthreads);
+  if (rtn != 0)
+    return rtn;
+
+  const auto dims = ctx->decomp3d->get_dims();
+  *dimx = dims[0];
+  *dimy = dims[1];
+  *dimz = dims[2];
+  const auto& outputd = ctx->decomp3d->view_decoded_data();
+  *dst_len = outputd.size() * (output_float ? sizeof(float) : sizeof(double));
+  if (dst_cap < *dst_len)
+    return 3;
+  copy_to_output(outputd, output_float, dst);
+
+  return 0;
+}
+
+auto C_API::sperr_container_writer_open(const char* filename, int append)
+    -> sperr_container_writer*
+{
+  auto* writer = new (std::nothrow) sperr_container_writer();
+  if (writer == nullptr)
+    return nullptr;
+  if (writer->writer.open(filename, append != 0) != sperr::RTNType::Good) {
+    delete writer;
+    return nullptr;
+  }
+  return writer;
+}
+
+auto C_API::sperr_container_append_3d(sperr_container_writer* writer,
+                                      const char* name,
+                                      size_t timestep,
+                                      const void* src,
+                                      int is_float,
+                                      size_t dimx,
+                                      size_t dimy,
+                                      size_t dimz,
+                                      size_t chunk_x,
+                                      size_t chunk_y,
+                                      size_t chunk_z,
+                                      int mode,
+                                      double quality,
+                                      size_t nthreads) -> int
+{
+  if (writer == nullptr || name == nullptr)
+    return 2;
+
+  // Each call compresses with its own context, so multiple threads can compress at the same time.
+  auto ctx = sperr_ctx();
+  auto rtn = comp_3d(ctx, src, is_float, {dimx, dimy, dimz}, {chunk_x, chunk_y, chunk_z}, mode,
+                     quality, nthreads);
+  if (rtn != 0)
+    return rtn;
+
+  switch (writer->writer.append(name, timestep, *ctx.comp3d)) {
+    case sperr::RTNType::Good:
+      return 0;
+    case sperr::RTNType::Error:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+auto C_API::sperr_container_writer_close(sperr_container_writer* writer) -> int
+{
+  if (writer == nullptr)
+    return -1;
+  auto rtn = writer->writer.close();
+  delete writer;
+  return (rtn == sperr::RTNType::Good ? 0 : -1);
+}
+
+auto C_API::sperr_container_reader_open(const char* filename) -> sperr_container_reader*
+{
+  auto* reader = new (std::nothrow) sperr_container_reader();
+  if (reader == nullptr)
+    return nullptr;
+  if (reader->reader.open(filename) != sperr::RTNType::Good) {
+    delete reader;
+    return nullptr;
+  }
+  return reader;
+}
+
+void C_API::sperr_container_reader_close(sperr_container_reader* reader)
+{
+  delete reader;
+}
+
+auto C_API::sperr_container_decomp_3d(const sperr_container_reader* reader,
+                                      const char* name,
+                                      size_t timestep,
+                                      size_t x0,
+                                      size_t y0,
+                                      size_t z0,
+                                      size_t lenx,
+                                      size_t leny,
+                                      size_t lenz,
+                                      int output_float,
+                                      size_t nthreads,
+                                      void** dst) -> int
+{
+  if (*dst != nullptr)
+    return 1;
+  if (reader == nullptr || name == nullptr || reader->reader.find(name, timestep) == nullptr)
+    return 2;
+
+  auto outputd = sperr::vecd_type();
+  const auto region = std::array<size_t, 6>{x0, lenx, y0, leny, z0, lenz};
+  auto rtn = reader->reader.decompress_region(name, timestep, region, outputd, nthreads);
+  if (rtn == sperr::RTNType::Error)  // The region isn't in the volume.
+    return 2;
+  else if (rtn != sperr::RTNType::Good)
+    return -1;
+
+  auto* buf = std::malloc(outputd.size() * (output_float ? sizeof(float) : sizeof(double)));
+  copy_to_output(outputd, output_float, buf);
+  *dst = buf;
+
+  return 0;
+}
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <new>
 #include <numeric>
 
 #if __cplusplus >= 202002L
@@ -15,6 +16,21 @@
 #include <omp.h>
 #endif
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <climits>  // IOV_MAX
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+#endif
+
 auto sperr::aligned_malloc(size_t alignment, size_t size) -> void*
 {
 #ifdef _WIN32
@@ -33,6 +49,50 @@ void sperr::aligned_free(void* p)
 #endif
 }
 
+auto sperr::huge_page_alloc(size_t bytes, MemPolicy policy) -> void*
+{
+#ifdef __linux__
+  const auto len = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+  const auto prot = PROT_READ | PROT_WRITE;
+  if (policy == MemPolicy::HugeTLB) {
+    auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+    flags |= MAP_HUGE_2MB;
+#endif
+    auto* p = ::mmap(nullptr, len, prot, flags, -1, 0);
+    if (p != MAP_FAILED)
+      return p;
+  }
+
+  // Transparent huge pages need memory aligned to `huge_page_size`, so map one extra huge page,
+  //    and unmap the unaligned head and the rest of the tail.
+  auto* raw = ::mmap(nullptr, len + huge_page_size, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED)
+    throw std::bad_alloc();
+  const auto begin = reinterpret_cast<uintptr_t>(raw);
+  const auto aligned = (begin + huge_page_size - 1) / huge_page_size * huge_page_size;
+  if (aligned > begin)
+    ::munmap(raw, aligned - begin);
+  if (begin + huge_page_size > aligned)
+    ::munmap(reinterpret_cast<void*>(aligned + len), begin + huge_page_size - aligned);
+  ::madvise(reinterpret_cast<void*>(aligned), len, MADV_HUGEPAGE);  // Just advice.
+  return reinterpret_cast<void*>(aligned);
+#else
+  (void)policy;
+  return ::operator new(bytes);
+#endif
+}
+
+void sperr::huge_page_free(void* p, size_t bytes)
+{
+#ifdef __linux__
+  const auto len = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+  ::munmap(p, len);
+#else
+  ::operator delete(p);
+#endif
+}
+
 auto sperr::num_of_xforms(size_t len) -> size_t
 {
   assert(len > 0);
@@ -338,8 +398,8 @@ auto sperr::read_whole_file(std::string filename) -> vec_type<T>
 
   return buf;
 }
-template auto sperr::read_whole_file(std::string) -> vecf_type;
-template auto sperr::read_whole_file(std::string) -> vecd_type;
+template auto sperr::read_whole_file(std::string) -> vec_type<float>;
+template auto sperr::read_whole_file(std::string) -> vec_type<double>;
 template auto sperr::read_whole_file(std::string) -> vec8_type;
 
 auto sperr::write_n_bytes(std::string filename, size_t n_bytes, const void* buffer) -> RTNType
@@ -357,13 +417,115 @@ auto sperr::write_n_bytes(std::string filename, size_t n_bytes, const void* buff
 
 auto sperr::read_sections(std::string filename,
                           const std::vector<size_t>& sections,
-                          vec8_type& dst) -> RTNType
+                          vec8_type& dst,
+                          size_t num_threads,
+                          size_t gap_threshold) -> RTNType
 {
+  const auto num_sections = sections.size() / 2;
+
   // Calculate the farthest file location to be read.
   size_t far = 0;
-  for (size_t i = 0; i < sections.size() / 2; i++)
+  for (size_t i = 0; i < num_sections; i++)
     far = std::max(far, sections[i * 2] + sections[i * 2 + 1]);
 
+  // Calculate where each section goes in `dst`, and the resulting size of `dst`.
+  auto dst_pos = std::vector<size_t>(num_sections);
+  auto total_len = dst.size();
+  for (size_t i = 0; i < num_sections; i++) {
+    dst_pos[i] = total_len;
+    total_len += sections[i * 2 + 1];
+  }
+
+#ifdef __unix__
+  // Prepare to read the file, and retrieve the file length in bytes.
+  const int fd = ::open(filename.data(), O_RDONLY);
+  if (fd < 0)
+    return RTNType::IOError;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || size_t(st.st_size) < far) {
+    ::close(fd);
+    return RTNType::WrongLength;
+  }
+
+  dst.resize(total_len);
+
+  // Sort non-empty sections by their file offsets, and coalesce the ones that are close to each
+  //    other into runs. A run is read with (ideally) a single `preadv()` call, which scatters
+  //    section data directly to their positions in `dst`, and small gaps in between to a scratch
+  //    buffer. Overlapping sections start new runs.
+  auto order = std::vector<size_t>();
+  order.reserve(num_sections);
+  for (size_t i = 0; i < num_sections; i++) {
+    if (sections[i * 2 + 1] > 0)
+      order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&sections](auto a, auto b) { return sections[a * 2] < sections[b * 2]; });
+  auto runs = std::vector<size_t>();  // Indices into `order` where each run begins.
+  auto run_end = size_t{0};
+  for (size_t i = 0; i < order.size(); i++) {
+    const auto offset = sections[order[i] * 2];
+    if (i == 0 || offset < run_end || offset - run_end > gap_threshold)
+      runs.push_back(i);
+    run_end = offset + sections[order[i] * 2 + 1];
+  }
+  runs.push_back(order.size());
+
+  // Use the maximum possible threads if 0 is passed in.
+#ifdef USE_OMP
+  if (num_threads == 0)
+    num_threads = omp_get_max_threads();
+#endif
+
+  // Read in runs of the file, possibly in parallel!
+  size_t num_failed = 0;
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) reduction(+ : num_failed)
+  for (size_t r = 0; r < runs.size() - 1; r++) {
+    // Assemble I/O vectors of this run.
+    auto iov = std::vector<iovec>();
+    auto scratch = vec8_type();
+    auto file_pos = sections[order[runs[r]] * 2];
+    const auto run_begin = file_pos;
+    for (size_t i = runs[r]; i < runs[r + 1]; i++) {
+      const auto idx = order[i];
+      const auto gap = sections[idx * 2] - file_pos;
+      if (gap > 0) {
+        scratch.resize(std::max(scratch.size(), gap));
+        iov.push_back({nullptr, gap});  // Pointing to `scratch` after it's fully sized.
+      }
+      iov.push_back({dst.data() + dst_pos[idx], sections[idx * 2 + 1]});
+      file_pos = sections[idx * 2] + sections[idx * 2 + 1];
+    }
+    for (auto& v : iov) {
+      if (v.iov_base == nullptr)
+        v.iov_base = scratch.data();
+    }
+
+    // Issue `preadv()` calls until all bytes of the run are read.
+    auto offset = run_begin;
+    size_t k = 0;
+    while (k < iov.size()) {
+      const auto cnt = static_cast<int>(std::min(iov.size() - k, size_t{IOV_MAX}));
+      const auto nread = ::preadv(fd, iov.data() + k, cnt, off_t(offset));
+      if (nread <= 0) {
+        num_failed++;
+        break;
+      }
+      offset += nread;
+      auto n = size_t(nread);
+      while (k < iov.size() && n >= iov[k].iov_len)
+        n -= iov[k++].iov_len;
+      if (n > 0) {
+        iov[k].iov_base = static_cast<uint8_t*>(iov[k].iov_base) + n;
+        iov[k].iov_len -= n;
+      }
+    }
+  }
+
+  ::close(fd);
+  if (num_failed > 0)
+    return RTNType::IOError;
+#else
   // Prepare to read the file.
   auto closer = [](std::FILE* f) { std::fclose(f); };  // bypass a compiler warning
   std::unique_ptr<std::FILE, decltype(closer)> fp(std::fopen(filename.data(), "rb"), closer);
@@ -379,21 +541,17 @@ auto sperr::read_sections(std::string filename,
   if (file_len < far)
     return RTNType::WrongLength;
 
-  // Calculate the resulting size of `dst`, and allocate enough memory.
-  auto dst_pos = dst.size();  // keep track of the current position to write section data.
-  auto total_len = dst.size();
-  for (size_t i = 0; i < sections.size() / 2; i++)
-    total_len += sections[i * 2 + 1];
   dst.resize(total_len);
 
   // Read in sections of the file!
-  for (size_t i = 0; i < sections.size() / 2; i++) {
+  for (size_t i = 0; i < num_sections; i++) {
     sk = std::fseek(fp.get(), sections[i * 2], SEEK_SET);
     assert(sk == 0);
-    auto nread = std::fread(dst.data() + dst_pos, 1, sections[i * 2 + 1], fp.get());
-    assert(nread == sections[i * 2 + 1]);
-    dst_pos += nread;
+    auto nread = std::fread(dst.data() + dst_pos[i], 1, sections[i * 2 + 1], fp.get());
+    if (nread != sections[i * 2 + 1])
+      return RTNType::IOError;
   }
+#endif
 
   return RTNType::Good;
 }
@@ -3,6 +3,7 @@
 #include "Bitmask.h"
 #include "Bitstream.h"
 
+#include <algorithm>
 #include <random>
 #include <vector>
 
@@ -421,6 +422,52 @@ END_LABEL:
   {}
 }
 
+TEST(Bitmask, true_bits)
+{
+  // Masks long enough to have runs of all-0 words that are skipped in blocks, with true bits
+  //    that are sparse, dense, or clustered, and a size that's not a multiple of 64.
+  const size_t mask_size = 5000;
+  std::mt19937 gen(17);
+  for (size_t every : {1, 3, 64, 700, 4999, 10000}) {
+    auto mask = Mask(mask_size);
+    for (size_t i = 0; i < mask_size; i += every)
+      mask.wtrue(i);
+    for (size_t i = 2800; i < 2830; i++)
+      mask.wtrue(i);
+    mask.resize(4990);  // Bits beyond the size are still in the buffer.
+
+    auto found = std::vector<size_t>();
+    for (auto i : mask.true_bits())
+      found.push_back(i);
+    auto expected = std::vector<size_t>();
+    for (size_t i = 0; i < mask.size(); i++)
+      if (mask.rbit(i))
+        expected.push_back(i);
+    EXPECT_EQ(found, expected) << "every = " << every;
+    EXPECT_EQ(mask.count_true(), expected.size()) << "every = " << every;
+
+    // Long ranges of `has_true()` and `find_true()` with random ends.
+    auto distrib = std::uniform_int_distribution<size_t>(0, mask.size());
+    for (size_t t = 0; t < 500; t++) {
+      auto start = distrib(gen);
+      auto len = std::uniform_int_distribution<size_t>(0, mask.size() - start)(gen);
+      auto itr = std::lower_bound(expected.cbegin(), expected.cend(), start);
+      auto ans = -1l;
+      if (itr != expected.cend() && *itr < start + len)
+        ans = *itr - start;
+      EXPECT_EQ(mask.find_true(start, len), ans) << "start = " << start << ", len = " << len;
+      EXPECT_EQ(mask.has_true(start, len), ans >= 0);
+    }
+  }
+
+  // Masks without any true bit.
+  for (size_t len : {0, 1000}) {
+    auto mask = Mask(len);
+    for (auto i : mask.true_bits())
+      ADD_FAILURE() << "true bit at " << i;
+  }
+}
+
 #if __cplusplus >= 201907L && defined __cpp_lib_three_way_comparison
 TEST(Bitmask, spaceship)
 {
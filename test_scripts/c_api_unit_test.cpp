@@ -0,0 +1,237 @@
+#include "SPERR_C_API.h"
+
+#include "sperr_helper.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "gtest/gtest.h"
+
+namespace {
+
+//
+// The context versions should produce exactly the same bitstreams and decompressed data
+//    as the non-context versions, even when the same context is used many times.
+//
+TEST(c_api_ctx, comp_2d)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/90x90.float");
+  ASSERT_EQ(input.size(), 90 * 90);
+  const size_t dimx = 90, dimy = 90;
+
+  auto* ctx = C_API::sperr_ctx_create();
+  ASSERT_NE(ctx, nullptr);
+
+  for (int mode = 1; mode <= 3; mode++) {
+    const auto quality = std::array{0.0, 2.5, 80.0, 1e-2}[mode];
+    const auto cap = C_API::sperr_comp_2d_max_size(dimx, dimy, mode, quality, 1);
+    auto buf = sperr::vec8_type(cap);
+
+    // Compress the same slice twice with the context.
+    for (int rep = 0; rep < 2; rep++) {
+      size_t len = 0;
+      auto rtn = C_API::sperr_ctx_comp_2d(ctx, input.data(), 1, dimx, dimy, mode, quality, 1,
+                                          buf.data(), buf.size(), &len);
+      EXPECT_EQ(rtn, 0);
+      EXPECT_LE(len, cap);
+
+      void* ref = nullptr;
+      size_t ref_len = 0;
+      rtn = C_API::sperr_comp_2d(input.data(), 1, dimx, dimy, mode, quality, 1, &ref, &ref_len);
+      EXPECT_EQ(rtn, 0);
+      ASSERT_EQ(len, ref_len);
+      EXPECT_EQ(std::memcmp(buf.data(), ref, len), 0);
+
+      // A buffer that's too small is reported.
+      size_t len2 = 0;
+      rtn = C_API::sperr_ctx_comp_2d(ctx, input.data(), 1, dimx, dimy, mode, quality, 1,
+                                     buf.data(), len - 1, &len2);
+      EXPECT_EQ(rtn, 3);
+      EXPECT_EQ(len2, len);
+
+      // Decompress with the context, and compare against the non-context version.
+      auto output = std::vector<double>(dimx * dimy);
+      rtn = C_API::sperr_ctx_decomp_2d(ctx, buf.data() + 10, len - 10, 0, dimx, dimy,
+                                       output.data());
+      EXPECT_EQ(rtn, 0);
+      void* ref_out = nullptr;
+      rtn = C_API::sperr_decomp_2d(static_cast<uint8_t*>(ref) + 10, ref_len - 10, 0, dimx, dimy,
+                                   &ref_out);
+      EXPECT_EQ(rtn, 0);
+      EXPECT_EQ(std::memcmp(output.data(), ref_out, output.size() * sizeof(double)), 0);
+
+      std::free(ref);
+      std::free(ref_out);
+    }
+  }
+
+  C_API::sperr_ctx_free(ctx);
+}
+
+TEST(c_api_ctx, comp_3d)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(input.size(), 128 * 128 * 41);
+  const size_t dimx = 128, dimy = 128, dimz = 41;
+
+  auto* ctx = C_API::sperr_ctx_create();
+  ASSERT_NE(ctx, nullptr);
+
+  for (int mode = 1; mode <= 3; mode++) {
+    const auto quality = std::array{0.0, 1.5, 80.0, 1e-3}[mode];
+    const auto cap = C_API::sperr_comp_3d_max_size(dimx, dimy, dimz, 64, 64, 64, mode, quality);
+    auto buf = sperr::vec8_type(cap);
+    size_t len = 0;
+    auto rtn = C_API::sperr_ctx_comp_3d(ctx, input.data(), 1, dimx, dimy, dimz, 64, 64, 64, mode,
+                                        quality, 2, buf.data(), buf.size(), &len);
+    EXPECT_EQ(rtn, 0);
+    EXPECT_LE(len, cap);
+
+    void* ref = nullptr;
+    size_t ref_len = 0;
+    rtn = C_API::sperr_comp_3d(input.data(), 1, dimx, dimy, dimz, 64, 64, 64, mode, quality, 2,
+                               &ref, &ref_len);
+    EXPECT_EQ(rtn, 0);
+    ASSERT_EQ(len, ref_len);
+    EXPECT_EQ(std::memcmp(buf.data(), ref, len), 0);
+
+    // Decompress into a buffer that's too small, then one that's big enough.
+    auto output = std::vector<float>(input.size());
+    size_t x = 0, y = 0, z = 0, out_len = 0;
+    rtn = C_API::sperr_ctx_decomp_3d(ctx, buf.data(), len, 1, 2, &x, &y, &z, output.data(),
+                                     output.size() * sizeof(float) - 1, &out_len);
+    EXPECT_EQ(rtn, 3);
+    EXPECT_EQ(out_len, output.size() * sizeof(float));
+    rtn = C_API::sperr_ctx_decomp_3d(ctx, buf.data(), len, 1, 2, &x, &y, &z, output.data(),
+                                     output.size() * sizeof(float), &out_len);
+    EXPECT_EQ(rtn, 0);
+    EXPECT_EQ(x, dimx);
+    EXPECT_EQ(y, dimy);
+    EXPECT_EQ(z, dimz);
+
+    void* ref_out = nullptr;
+    rtn = C_API::sperr_decomp_3d(ref, ref_len, 1, 2, &x, &y, &z, &ref_out);
+    EXPECT_EQ(rtn, 0);
+    EXPECT_EQ(std::memcmp(output.data(), ref_out, out_len), 0);
+
+    std::free(ref);
+    std::free(ref_out);
+  }
+
+  C_API::sperr_ctx_free(ctx);
+}
+
+// Chunks longer than 65,535 in a dimension make the compressor switch to a large header; the
+//    maximum size accounts for that too.
+TEST(c_api_ctx, comp_3d_large_header)
+{
+  const size_t dimx = 140'000, dimy = 2, dimz = 1;
+  auto input = std::vector<float>(dimx * dimy * dimz);
+  for (size_t i = 0; i < input.size(); i++)
+    input[i] = std::sin(double(i) * 1e-3) * 100.0;
+
+  auto* ctx = C_API::sperr_ctx_create();
+  ASSERT_NE(ctx, nullptr);
+
+  for (int mode = 1; mode <= 3; mode++) {
+    const auto quality = std::array{0.0, 4.0, 80.0, 1e-2}[mode];
+    const auto cap =
+        C_API::sperr_comp_3d_max_size(dimx, dimy, dimz, 70'000, 2, 1, mode, quality);
+    auto buf = sperr::vec8_type(cap);
+    size_t len = 0;
+    auto rtn = C_API::sperr_ctx_comp_3d(ctx, input.data(), 1, dimx, dimy, dimz, 70'000, 2, 1,
+                                        mode, quality, 1, buf.data(), buf.size(), &len);
+    ASSERT_EQ(rtn, 0);
+    EXPECT_LE(len, cap);
+    EXPECT_TRUE(sperr::unpack_8_booleans(buf[1])[6]);  // A large header.
+
+    auto output = std::vector<float>(input.size());
+    size_t x = 0, y = 0, z = 0, out_len = 0;
+    rtn = C_API::sperr_ctx_decomp_3d(ctx, buf.data(), len, 1, 1, &x, &y, &z, output.data(),
+                                     output.size() * sizeof(float), &out_len);
+    EXPECT_EQ(rtn, 0);
+    EXPECT_EQ(x, dimx);
+    EXPECT_EQ(y, dimy);
+    EXPECT_EQ(z, dimz);
+  }
+
+  C_API::sperr_ctx_free(ctx);
+}
+
+TEST(c_api, comp_2d_batch)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const size_t dimx = 128, dimy = 128, num_slices = 41;
+  ASSERT_EQ(input.size(), dimx * dimy * num_slices);
+
+  void* stream = nullptr;
+  size_t stream_len = 0;
+  auto rtn = C_API::sperr_comp_2d_batch(input.data(), 1, dimx, dimy, num_slices, 3, 1e-3, 0,
+                                        &stream, &stream_len);
+  ASSERT_EQ(rtn, 0);
+
+  size_t x = 0, y = 0, z = 0;
+  int is_float = 0;
+  C_API::sperr_parse_header(stream, &x, &y, &z, &is_float);
+  EXPECT_EQ(x, dimx);
+  EXPECT_EQ(y, dimy);
+  EXPECT_EQ(z, num_slices);
+  EXPECT_EQ(is_float, 1);
+
+  void* all = nullptr;
+  rtn = C_API::sperr_decomp_2d_batch(stream, stream_len, 1, 0, &x, &y, &z, &all);
+  ASSERT_EQ(rtn, 0);
+  const auto* allf = static_cast<float*>(all);
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_LE(std::abs(double(input[i]) - double(allf[i])), 1e-3);
+
+  void* slice = nullptr;
+  rtn = C_API::sperr_decomp_2d_slice(stream, stream_len, 1, num_slices - 1, &slice);
+  ASSERT_EQ(rtn, 0);
+  const auto slice_bytes = dimx * dimy * sizeof(float);
+  EXPECT_EQ(std::memcmp(slice, allf + (num_slices - 1) * dimx * dimy, slice_bytes), 0);
+
+  void* bad = nullptr;
+  EXPECT_EQ(C_API::sperr_decomp_2d_slice(stream, stream_len, 1, num_slices, &bad), 2);
+
+  std::free(stream);
+  std::free(all);
+  std::free(slice);
+}
+
+TEST(c_api, container)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const size_t dimx = 128, dimy = 128, dimz = 41;
+  const char* filename = "./c_api_container.tmp";
+
+  auto* writer = C_API::sperr_container_writer_open(filename, 0);
+  ASSERT_NE(writer, nullptr);
+  auto rtn = C_API::sperr_container_append_3d(writer, "vort", 7, input.data(), 1, dimx, dimy, dimz,
+                                              64, 64, 64, 3, 1e-3, 0);
+  EXPECT_EQ(rtn, 0);
+  rtn = C_API::sperr_container_append_3d(writer, "vort", 7, input.data(), 1, dimx, dimy, dimz, 64,
+                                         64, 64, 3, 1e-3, 0);
+  EXPECT_EQ(rtn, 2);
+  EXPECT_EQ(C_API::sperr_container_writer_close(writer), 0);
+
+  auto* reader = C_API::sperr_container_reader_open(filename);
+  ASSERT_NE(reader, nullptr);
+  void* dst = nullptr;
+  rtn = C_API::sperr_container_decomp_3d(reader, "vort", 6, 0, 0, 0, 8, 8, 8, 1, 0, &dst);
+  EXPECT_EQ(rtn, 2);
+  rtn = C_API::sperr_container_decomp_3d(reader, "vort", 7, 70, 20, 30, 40, 50, 8, 1, 0, &dst);
+  ASSERT_EQ(rtn, 0);
+  const auto* dstf = static_cast<float*>(dst);
+  for (size_t z = 0; z < 8; z++)
+    for (size_t y = 0; y < 50; y++)
+      for (size_t x = 0; x < 40; x++) {
+        const auto orig = input[(z + 30) * dimx * dimy + (y + 20) * dimx + x + 70];
+        EXPECT_LE(std::abs(double(orig) - double(dstf[z * 40 * 50 + y * 40 + x])), 1e-3);
+      }
+  std::free(dst);
+  C_API::sperr_container_reader_close(reader);
+  std::remove(filename);
+}
+
+}  // namespace
@@ -0,0 +1,117 @@
+#include "SPERR3D_Container.h"
+#include "SPERR3D_OMP_D.h"
+
+#include <cstdio>
+#include <thread>
+#include "gtest/gtest.h"
+
+namespace {
+
+using sperr::RTNType;
+
+// Produce a bitstream of the vorticity data set, scaled differently for each time step.
+auto ProduceStream(size_t timestep) -> sperr::vec8_type
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  for (auto& v : input)
+    v *= float(timestep + 1);
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks({128, 128, 41}, {64, 64, 32});
+  encoder.set_psnr(80.0);
+  encoder.compress(input.data(), input.size());
+  return encoder.get_encoded_bitstream();
+}
+
+TEST(container, write_and_read)
+{
+  const auto filename = std::string("./container.tmp");
+  const auto names = std::array<std::string, 2>{"vort", "vort_copy"};
+  auto streams = std::vector<sperr::vec8_type>();
+  for (size_t t = 0; t < 3; t++)
+    streams.push_back(ProduceStream(t));
+
+  // Multiple threads append to the same container, in no particular order.
+  auto writer = sperr::SPERR3D_Container_Writer();
+  ASSERT_EQ(writer.open(filename), RTNType::Good);
+  auto threads = std::vector<std::thread>();
+  for (size_t t = 0; t < 3; t++)
+    for (const auto& name : names) {
+      threads.emplace_back([&writer, &streams, name, t]() {
+        EXPECT_EQ(writer.append(name, t, streams[t].data(), streams[t].size()), RTNType::Good);
+      });
+    }
+  for (auto& th : threads)
+    th.join();
+  EXPECT_EQ(writer.append(names[0], 1, streams[1].data(), streams[1].size()), RTNType::Error);
+  EXPECT_EQ(writer.close(), RTNType::Good);
+
+  // Read every bitstream back.
+  auto reader = sperr::SPERR3D_Container_Reader();
+  ASSERT_EQ(reader.open(filename), RTNType::Good);
+  const auto& entries = reader.view_entries();
+  ASSERT_EQ(entries.size(), 6);
+  EXPECT_EQ(entries[0].name, names[0]);
+  EXPECT_EQ(entries[2].timestep, 2);
+  EXPECT_EQ(reader.find("vort", 3), nullptr);
+  for (size_t t = 0; t < 3; t++)
+    for (const auto& name : names)
+      EXPECT_EQ(reader.get_stream(name, t), streams[t]);
+  EXPECT_LT(reader.get_stream(names[1], 2, 30).size(), streams[2].size() / 2);
+
+  // Decompress a region, and compare with decompressing the whole volume.
+  const auto region = std::array<size_t, 6>{50, 30, 60, 20, 10, 25};
+  auto output = sperr::vecd_type();
+  EXPECT_EQ(reader.decompress_region(names[1], 2, region, output), RTNType::Good);
+  ASSERT_EQ(output.size(), region[1] * region[3] * region[5]);
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.use_bitstream(streams[2].data(), streams[2].size());
+  decoder.decompress(streams[2].data());
+  const auto& vol = decoder.view_decoded_data();
+  size_t idx = 0;
+  for (size_t z = region[4]; z < region[4] + region[5]; z++)
+    for (size_t y = region[2]; y < region[2] + region[3]; y++)
+      for (size_t x = region[0]; x < region[0] + region[1]; x++)
+        EXPECT_EQ(output[idx++], vol[z * 128 * 128 + y * 128 + x]);
+  const auto outside = std::array<size_t, 6>{100, 30, 0, 10, 0, 10};
+  EXPECT_EQ(reader.decompress_region(names[1], 2, outside, output), RTNType::Error);
+
+  // Append one more time step to the existing container.
+  ASSERT_EQ(writer.open(filename, true), RTNType::Good);
+  auto more = ProduceStream(3);
+  EXPECT_EQ(writer.append(names[0], 0, more.data(), more.size()), RTNType::Error);
+  EXPECT_EQ(writer.append(names[0], 3, more.data(), more.size()), RTNType::Good);
+  EXPECT_EQ(writer.close(), RTNType::Good);
+
+  ASSERT_EQ(reader.open(filename), RTNType::Good);
+  EXPECT_EQ(reader.view_entries().size(), 7);
+  EXPECT_EQ(reader.get_stream(names[0], 3), more);
+  EXPECT_EQ(reader.get_stream(names[0], 0), streams[0]);
+
+  std::remove(filename.data());
+}
+
+TEST(container, corrupt_trailer)
+{
+  const auto filename = std::string("./container_corrupt.tmp");
+  const auto stream = ProduceStream(0);
+  auto writer = sperr::SPERR3D_Container_Writer();
+  ASSERT_EQ(writer.open(filename), RTNType::Good);
+  ASSERT_EQ(writer.append("vort", 0, stream.data(), stream.size()), RTNType::Good);
+  ASSERT_EQ(writer.close(), RTNType::Good);
+
+  // Claim more entries in the trailer than the index could possibly hold.
+  auto* f = std::fopen(filename.data(), "r+b");
+  ASSERT_NE(f, nullptr);
+  const uint64_t num_entries = uint64_t{1} << 60;
+  std::fseek(f, -16, SEEK_END);
+  std::fwrite(&num_entries, sizeof(num_entries), 1, f);
+  std::fclose(f);
+
+  auto reader = sperr::SPERR3D_Container_Reader();
+  EXPECT_EQ(reader.open(filename), RTNType::Error);
+  EXPECT_EQ(writer.open(filename, true), RTNType::Error);
+
+  std::remove(filename.data());
+}
+
+}  // anonymous namespace
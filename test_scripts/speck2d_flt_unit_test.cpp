@@ -15,7 +15,7 @@ TEST(SPECK2D_FLT, ConstantField)
 {
   const auto dims = sperr::dims_type{12, 13, 1};
   const auto total_vals = dims[0] * dims[1] * dims[2];
-  auto input = std::vector<double>(total_vals, 4.332);
+  auto input = sperr::vecd_type(total_vals, 4.332);
   auto tmp = input;
 
   auto encoder = sperr::SPECK2D_FLT();
@@ -3,6 +3,7 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <iostream>
 
@@ -15,7 +16,7 @@ TEST(SPECK3D_FLT, ConstantField)
 {
   const auto dims = sperr::dims_type{12, 13, 15};
   const auto total_vals = dims[0] * dims[1] * dims[2];
-  auto input = std::vector<double>(total_vals, 4.332);
+  auto input = sperr::vecd_type(total_vals, 4.332);
   auto tmp = input;
 
   auto encoder = sperr::SPECK3D_FLT();
@@ -146,6 +147,81 @@ TEST(SPECK3D_FLT, IntegerLen)
   EXPECT_EQ(decoder.integer_len(), 8);
 }
 
+//
+// An encoder that always picks 8-bit integers before quantization, so quantization has to move to a
+//    wider integer type whenever the biggest quantized integer is over 255.
+//
+class Narrow_SPECK3D_FLT : public sperr::SPECK3D_FLT {
+ public:
+  auto max_integer() const -> uint64_t { return m_max_ui; }
+  auto max_quantized() const -> double { return m_max_mag / m_q; }
+
+ protected:
+  double m_max_mag = 0.0;
+
+  auto m_decide_integer_len(double max_mag) -> sperr::RTNType override
+  {
+    m_max_mag = max_mag;
+    auto rtn = SPECK_FLT::m_decide_integer_len(max_mag);
+    m_uint_flag = sperr::UINTType::UINT8;
+    return rtn;
+  }
+};
+
+//
+// Scale the data so that the biggest quantized integer is right at the boundary of 8-bit integers.
+//    When it doesn't fit, the integer type is widened, giving the same bitstream as the encoder
+//    that picked the right integer length to begin with.
+//
+TEST(SPECK3D_FLT, IntegerLenBoundary)
+{
+  auto inputf = sperr::read_whole_file<float>("../test_data/wmag17.float");
+  const auto dims = sperr::dims_type{17, 17, 17};
+  const auto total_vals = inputf.size();
+  auto inputd = sperr::vecd_type(inputf.cbegin(), inputf.cend());
+  const auto tol = 0.05;
+
+  auto narrow = Narrow_SPECK3D_FLT();
+  narrow.set_dims(dims);
+  narrow.set_tolerance(tol);
+  narrow.copy_data(inputd.data(), total_vals);
+  ASSERT_EQ(narrow.compress(), sperr::RTNType::Good);
+  const auto ratio = narrow.max_quantized();
+
+  for (uint64_t target : {255, 256}) {
+    auto scaled = inputd;
+    for (auto& v : scaled)
+      v *= double(target) / ratio;
+
+    narrow.set_tolerance(tol);
+    narrow.copy_data(scaled.data(), total_vals);
+    ASSERT_EQ(narrow.compress(), sperr::RTNType::Good);
+    EXPECT_EQ(narrow.max_integer(), target);
+    EXPECT_EQ(narrow.integer_len(), target > 255 ? 2 : 1);
+    auto bitstream = sperr::vec8_type();
+    narrow.append_encoded_bitstream(bitstream);
+
+    auto encoder = sperr::SPECK3D_FLT();
+    encoder.set_dims(dims);
+    encoder.set_tolerance(tol);
+    encoder.copy_data(scaled.data(), total_vals);
+    ASSERT_EQ(encoder.compress(), sperr::RTNType::Good);
+    EXPECT_EQ(encoder.integer_len(), narrow.integer_len());
+    auto expected = sperr::vec8_type();
+    encoder.append_encoded_bitstream(expected);
+    EXPECT_EQ(bitstream, expected);
+
+    auto decoder = sperr::SPECK3D_FLT();
+    decoder.set_dims(dims);
+    ASSERT_EQ(decoder.use_bitstream(bitstream.data(), bitstream.size()), sperr::RTNType::Good);
+    ASSERT_EQ(decoder.decompress(), sperr::RTNType::Good);
+    const auto& output = decoder.view_decoded_data();
+    ASSERT_EQ(output.size(), total_vals);
+    for (size_t i = 0; i < total_vals; i++)
+      EXPECT_LE(std::abs(output[i] - scaled[i]), tol) << "i = " << i;
+  }
+}
+
 //
 // Test outlier correction
 //
@@ -12,12 +12,13 @@
 #include <algorithm>
 #include <cmath>
 #include <random>
+#include <string>
 
 namespace {
 
 template <typename T>
 auto ProduceRandomArray(size_t len, float stddev, uint32_t seed)
-    -> std::pair<std::vector<T>, sperr::Bitmask>
+    -> std::pair<sperr::uninit_vec_type<T>, sperr::Bitmask>
 {
   std::mt19937 gen{seed};
   std::normal_distribution<float> d{0.0, stddev};
@@ -25,7 +26,7 @@ auto ProduceRandomArray(size_t len, float stddev, uint32_t seed)
   auto tmp = std::vector<float>(len);
   std::generate(tmp.begin(), tmp.end(), [&gen, &d]() { return d(gen); });
 
-  auto coeffs = std::vector<T>(len);
+  auto coeffs = sperr::uninit_vec_type<T>(len);
   auto signs = sperr::Bitmask(len);
   signs.reset_true();
   for (size_t i = 0; i < len; i++) {
@@ -42,6 +43,77 @@ auto ProduceRandomArray(size_t len, float stddev, uint32_t seed)
   return {coeffs, signs};
 }
 
+//
+// Progressive decoding: decoding a partial bitstream and then resuming with more bits should
+//    give exactly the same result as decoding the longer bitstream from scratch.
+//
+template <typename Enc, typename Dec, typename T>
+void TestResumeDecoding(sperr::dims_type dims, float stddev)
+{
+  const auto total_vals = dims[0] * dims[1] * dims[2];
+  auto [input, input_signs] = ProduceRandomArray<T>(total_vals, stddev, 7);
+
+  auto encoder = Enc();
+  encoder.use_coeffs(input, input_signs);
+  encoder.set_dims(dims);
+  encoder.encode();
+  auto bitstream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(bitstream);
+
+  const auto header = sperr::SPECK_INT<T>::header_size;
+  auto progressive = Dec();
+  progressive.set_dims(dims);
+  progressive.set_resumable(true);
+  progressive.use_bitstream(bitstream.data(), header + (bitstream.size() - header) / 10);
+  progressive.decode();
+  EXPECT_TRUE(progressive.can_resume());
+
+  for (size_t pct : {15, 40, 41, 100}) {
+    const auto len = header + (bitstream.size() - header) * pct / 100;
+    EXPECT_EQ(progressive.decode_more(bitstream.data(), len), sperr::RTNType::Good);
+
+    auto scratch = Dec();
+    scratch.set_dims(dims);
+    scratch.use_bitstream(bitstream.data(), len);
+    scratch.decode();
+
+    EXPECT_EQ(progressive.view_coeffs(), scratch.view_coeffs());
+    EXPECT_EQ(progressive.view_signs().view_buffer(), scratch.view_signs().view_buffer());
+  }
+
+  // All bits are decoded; nothing left to resume.
+  EXPECT_FALSE(progressive.can_resume());
+  EXPECT_EQ(progressive.view_coeffs(), input);
+}
+
+//
+// Encode `input` and its signs, decode the bitstream, and expect the same coefficients back, as
+//    well as the same signs wherever a coefficient is non-zero.
+//
+template <typename Enc, typename Dec, typename T>
+void TestRoundTrip(sperr::dims_type dims,
+                   const sperr::uninit_vec_type<T>& input,
+                   const sperr::Bitmask& input_signs)
+{
+  auto encoder = Enc();
+  encoder.set_dims(dims);
+  encoder.use_coeffs(input, input_signs);
+  encoder.encode();
+  auto bitstream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(bitstream);
+
+  auto decoder = Dec();
+  decoder.set_dims(dims);
+  decoder.use_bitstream(bitstream.data(), bitstream.size());
+  decoder.decode();
+  EXPECT_EQ(decoder.view_coeffs(), input);
+  for (size_t i = 0; i < input.size(); i++) {
+    if (input[i] != 0) {
+      EXPECT_EQ(decoder.view_signs().rbit(i), input_signs.rbit(i)) << "i = " << i;
+    }
+  }
+}
+
 //
 // Start 1D test cases
 //
@@ -49,7 +121,7 @@ TEST(SPECK1D_INT, minimal)
 {
   const auto dims = sperr::dims_type{40, 1, 1};
 
-  auto input = std::vector<uint8_t>(dims[0], 0);
+  auto input = sperr::uninit_vec_type<uint8_t>(dims[0], 0);
   auto input_signs = sperr::Bitmask(input.size());
   input_signs.reset_true();
   input[4] = 1;
@@ -97,7 +169,7 @@ TEST(SPECK1D_INT, minimal)
   //
   // Test 2-byte integer
   //
-  auto input16 = std::vector<uint16_t>(dims[0], 0);
+  auto input16 = sperr::uninit_vec_type<uint16_t>(dims[0], 0);
   std::copy(input.cbegin(), input.cend(), input16.begin());
   input16[30] = 300;
   {
@@ -126,7 +198,7 @@ TEST(SPECK1D_INT, minimal)
   //
   // Test 4-byte integer
   //
-  auto input32 = std::vector<uint32_t>(dims[0], 0);
+  auto input32 = sperr::uninit_vec_type<uint32_t>(dims[0], 0);
   std::copy(input16.cbegin(), input16.cend(), input32.begin());
   input32[20] = 70'000;
   {
@@ -155,7 +227,7 @@ TEST(SPECK1D_INT, minimal)
   //
   // Test 8-byte integer
   //
-  auto input64 = std::vector<uint64_t>(dims[0], 0);
+  auto input64 = sperr::uninit_vec_type<uint64_t>(dims[0], 0);
   std::copy(input32.cbegin(), input32.cend(), input64.begin());
   input64[23] = 5'000'700'000;
   {
@@ -182,6 +254,12 @@ TEST(SPECK1D_INT, minimal)
   }
 }
 
+TEST(SPECK1D_INT, ResumeDecoding)
+{
+  TestResumeDecoding<sperr::SPECK1D_INT_ENC<uint16_t>, sperr::SPECK1D_INT_DEC<uint16_t>, uint16_t>(
+      {5000, 1, 1}, 500.0);
+}
+
 TEST(SPECK1D_INT, Random1)
 {
   const auto dims = sperr::dims_type{2000, 1, 1};
@@ -238,6 +316,27 @@ TEST(SPECK1D_INT, Random2)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+//
+// Sparse coefficients, including a few at the very ends, exercise the encoder's max-tree on
+//    sets that start and end in the middle of a block.
+//
+TEST(SPECK1D_INT, Sparse)
+{
+  for (size_t len : {size_t{127}, size_t{1000}, size_t{64 * 1025 + 3}}) {
+    auto input = sperr::uninit_vec_type<uint32_t>(len, 0);
+    auto input_signs = sperr::Bitmask(len);
+    input_signs.reset_true();
+    for (size_t i = 5; i < len; i += 331) {
+      input[i] = uint32_t(i * 7919 % 100'003);
+      input_signs.wbit(i, i % 3 != 0);
+    }
+    input[len - 1] = 3;
+
+    TestRoundTrip<sperr::SPECK1D_INT_ENC<uint32_t>, sperr::SPECK1D_INT_DEC<uint32_t>>(
+        {len, 1, 1}, input, input_signs);
+  }
+}
+
 TEST(SPECK1D_INT, RandomRandom)
 {
   const auto dims = sperr::dims_type{63 * 64 * 119, 1, 1};
@@ -274,7 +373,7 @@ TEST(SPECK2D_INT, minimal)
 {
   const auto dims = sperr::dims_type{9, 8, 1};
 
-  auto input = std::vector<uint8_t>(dims[0] * dims[1], 0);
+  auto input = sperr::uninit_vec_type<uint8_t>(dims[0] * dims[1], 0);
   auto input_signs = sperr::Bitmask(input.size());
   input_signs.reset_true();
   input[2] = 1;
@@ -327,7 +426,7 @@ TEST(SPECK2D_INT, minimal)
   //
   // Test 2-byte integer
   //
-  auto input16 = std::vector<uint16_t>(input.size());
+  auto input16 = sperr::uninit_vec_type<uint16_t>(input.size());
   std::copy(input.cbegin(), input.cend(), input16.begin());
   input16[71] = 300;
   {
@@ -356,7 +455,7 @@ TEST(SPECK2D_INT, minimal)
   //
   // Test 4-byte integer
   //
-  auto input32 = std::vector<uint32_t>(input.size());
+  auto input32 = sperr::uninit_vec_type<uint32_t>(input.size());
   std::copy(input16.cbegin(), input16.cend(), input32.begin());
   input32[66] = 70'000;
   {
@@ -385,7 +484,7 @@ TEST(SPECK2D_INT, minimal)
   //
   // Test 8-byte integer
   //
-  auto input64 = std::vector<uint64_t>(input.size());
+  auto input64 = sperr::uninit_vec_type<uint64_t>(input.size());
   std::copy(input32.cbegin(), input32.cend(), input64.begin());
   input64[57] = 5'000'700'000;
   {
@@ -412,6 +511,12 @@ TEST(SPECK2D_INT, minimal)
   }
 }
 
+TEST(SPECK2D_INT, ResumeDecoding)
+{
+  TestResumeDecoding<sperr::SPECK2D_INT_ENC<uint16_t>, sperr::SPECK2D_INT_DEC<uint16_t>, uint16_t>(
+      {97, 113, 1}, 500.0);
+}
+
 TEST(SPECK2D_INT, Random1)
 {
   const auto dims = sperr::dims_type{9, 20, 1};
@@ -468,6 +573,27 @@ TEST(SPECK2D_INT, Random2)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+//
+// Sparse coefficients leave most sets insignificant for many bitplanes, which exercises the
+//    encoder's max-MSB quadtree; elongated and odd dimensions give uneven partitions.
+//
+TEST(SPECK2D_INT, Sparse)
+{
+  for (auto dims : {sperr::dims_type{1000, 7, 1}, sperr::dims_type{257, 129, 1}}) {
+    const auto total_vals = dims[0] * dims[1];
+    auto input = sperr::uninit_vec_type<uint32_t>(total_vals, 0);
+    auto input_signs = sperr::Bitmask(total_vals);
+    input_signs.reset_true();
+    for (size_t i = 0; i < total_vals; i += 97) {
+      input[i] = uint32_t(i * 7919 % 100'003);
+      input_signs.wbit(i, i % 3 != 0);
+    }
+
+    TestRoundTrip<sperr::SPECK2D_INT_ENC<uint32_t>, sperr::SPECK2D_INT_DEC<uint32_t>>(
+        dims, input, input_signs);
+  }
+}
+
 TEST(SPECK2D_INT, RandomRandom)
 {
   const auto dims = sperr::dims_type{63, 256, 1};
@@ -504,7 +630,7 @@ TEST(SPECK3D_INT, minimal)
 {
   const auto dims = sperr::dims_type{4, 3, 8};
   const auto total_vals = dims[0] * dims[1] * dims[2];
-  auto input = std::vector<uint8_t>(total_vals, 0);
+  auto input = sperr::uninit_vec_type<uint8_t>(total_vals, 0);
   auto input_signs = sperr::Bitmask(input.size());
   input_signs.reset_true();
   input[4] = 1;
@@ -555,7 +681,7 @@ TEST(SPECK3D_INT, minimal)
   //
   // Test 2-byte integers
   //
-  auto input16 = std::vector<uint16_t>(total_vals, 0);
+  auto input16 = sperr::uninit_vec_type<uint16_t>(total_vals, 0);
   std::copy(input.begin(), input.end(), input16.begin());
   input16[30] = 300;
   input_signs.wfalse(30);
@@ -589,7 +715,7 @@ TEST(SPECK3D_INT, minimal)
   //
   // Test 4-byte integers
   //
-  auto input32 = std::vector<uint32_t>(total_vals, 0);
+  auto input32 = sperr::uninit_vec_type<uint32_t>(total_vals, 0);
   std::copy(input16.begin(), input16.end(), input32.begin());
   input32[20] = 7'0300;
   input_signs.wfalse(20);
@@ -622,7 +748,7 @@ TEST(SPECK3D_INT, minimal)
   //
   // Test 8-byte integers
   //
-  auto input64 = std::vector<uint64_t>(total_vals, 0);
+  auto input64 = sperr::uninit_vec_type<uint64_t>(total_vals, 0);
   std::copy(input32.begin(), input32.end(), input64.begin());
   input64[27] = 5'000'700'990;
   input_signs.wfalse(27);
@@ -654,6 +780,12 @@ TEST(SPECK3D_INT, minimal)
   }
 }
 
+TEST(SPECK3D_INT, ResumeDecoding)
+{
+  TestResumeDecoding<sperr::SPECK3D_INT_ENC<uint32_t>, sperr::SPECK3D_INT_DEC<uint32_t>, uint32_t>(
+      {33, 40, 47}, 9000.0);
+}
+
 TEST(SPECK3D_INT, Random1)
 {
   const auto dims = sperr::dims_type{10, 20, 30};
@@ -712,6 +844,55 @@ TEST(SPECK3D_INT, Random2)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+//
+// Power-of-two cubes take a separate path in both the encoder and decoder.
+//
+TEST(SPECK3D_INT, PowerOfTwoCubes)
+{
+  for (size_t side : {2, 4, 32, 64}) {
+    SCOPED_TRACE("side = " + std::to_string(side));
+    auto [input, input_signs] = ProduceRandomArray<uint16_t>(side * side * side, 499.0, 4);
+    TestRoundTrip<sperr::SPECK3D_INT_ENC<uint16_t>, sperr::SPECK3D_INT_DEC<uint16_t>>(
+        {side, side, side}, input, input_signs);
+  }
+}
+
+//
+// Initial lists and morton layouts are cached by dimensions, from the second time they're used.
+//    Cycle through a few dimensions three times, releasing the caches before the last round,
+//    and expect the same bitstreams every time.
+//
+TEST(SPECK3D_INT, CachedLayouts)
+{
+  auto encoder = sperr::SPECK3D_INT_ENC<uint16_t>();
+  auto decoder = sperr::SPECK3D_INT_DEC<uint16_t>();
+  auto first_round = std::vector<sperr::vec8_type>();
+  for (size_t round = 0; round < 3; round++) {
+    if (round == 2)
+      sperr::release_shape_caches();
+    for (size_t i = 0; i < 10; i++) {
+      const auto dims = sperr::dims_type{10 + i, 20 - i, 9 + 2 * i};
+      const auto total_vals = dims[0] * dims[1] * dims[2];
+      auto [input, input_signs] = ProduceRandomArray<uint16_t>(total_vals, 499.0, i);
+
+      encoder.use_coeffs(input, input_signs);
+      encoder.set_dims(dims);
+      encoder.encode();
+      sperr::vec8_type bitstream;
+      encoder.append_encoded_bitstream(bitstream);
+      if (round == 0)
+        first_round.push_back(bitstream);
+      else
+        EXPECT_EQ(bitstream, first_round[i]) << "i = " << i;
+
+      decoder.set_dims(dims);
+      decoder.use_bitstream(bitstream.data(), bitstream.size());
+      decoder.decode();
+      EXPECT_EQ(decoder.view_coeffs(), input) << "i = " << i;
+    }
+  }
+}
+
 TEST(SPECK3D_INT, RandomRandom)
 {
   const auto dims = sperr::dims_type{63, 64, 119};
@@ -742,4 +923,55 @@ TEST(SPECK3D_INT, RandomRandom)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+TEST(SPECK3D_INT, WideSets)
+{
+  // Sets with 32-bit coordinates produce the same bitstream as sets with 16-bit coordinates.
+  auto dims = sperr::dims_type{10, 20, 30};
+  auto [input, input_signs] = ProduceRandomArray<uint16_t>(dims[0] * dims[1] * dims[2], 499.0, 3);
+  auto encoder16 = sperr::SPECK3D_INT_ENC<uint16_t>();
+  encoder16.use_coeffs(input, input_signs);
+  encoder16.set_dims(dims);
+  encoder16.encode();
+  sperr::vec8_type bitstream16;
+  encoder16.append_encoded_bitstream(bitstream16);
+  auto encoder = sperr::SPECK3D_INT_ENC<uint16_t, uint32_t>();
+  encoder.use_coeffs(input, input_signs);
+  encoder.set_dims(dims);
+  encoder.encode();
+  sperr::vec8_type bitstream;
+  encoder.append_encoded_bitstream(bitstream);
+  EXPECT_EQ(bitstream, bitstream16);
+
+  // A dimension that's longer than what 16-bit coordinates can hold.
+  dims = sperr::dims_type{70000, 3, 2};
+  const auto total_vals = dims[0] * dims[1] * dims[2];
+  std::tie(input, input_signs) = ProduceRandomArray<uint16_t>(total_vals, 499.0, 4);
+  encoder.use_coeffs(input, input_signs);
+  encoder.set_dims(dims);
+  EXPECT_EQ(encoder.encode(), sperr::RTNType::Good);
+  bitstream.clear();
+  encoder.append_encoded_bitstream(bitstream);
+
+  // Coders with 16-bit coordinates reject it, instead of truncating it.
+  encoder16.use_coeffs(input, input_signs);
+  encoder16.set_dims(dims);
+  EXPECT_EQ(encoder16.encode(), sperr::RTNType::Error);
+  auto decoder16 = sperr::SPECK3D_INT_DEC<uint16_t>();
+  decoder16.set_dims(dims);
+  decoder16.use_bitstream(bitstream.data(), bitstream.size());
+  EXPECT_EQ(decoder16.decode(), sperr::RTNType::Error);
+
+  auto decoder = sperr::SPECK3D_INT_DEC<uint16_t, uint32_t>();
+  decoder.set_dims(dims);
+  decoder.use_bitstream(bitstream.data(), bitstream.size());
+  EXPECT_EQ(decoder.decode(), sperr::RTNType::Good);
+  auto output = decoder.release_coeffs();
+  auto output_signs = decoder.release_signs();
+
+  EXPECT_EQ(input, output);
+  EXPECT_EQ(input_signs.size(), output_signs.size());
+  for (size_t i = 0; i < input_signs.size(); i++)
+    EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
+}
+
 }  // namespace
@@ -0,0 +1,86 @@
+#include "SPERR1D_OMP_C.h"
+#include "SPERR1D_OMP_D.h"
+
+#include <cmath>
+#include "gtest/gtest.h"
+
+namespace {
+
+using sperr::RTNType;
+
+auto make_signal(size_t len) -> std::vector<float>
+{
+  auto sig = std::vector<float>(len);
+  for (size_t i = 0; i < len; i++)
+    sig[i] = std::sin(double(i) * 0.001) * 10.0 + std::cos(double(i) * 0.037);
+  return sig;
+}
+
+TEST(sperr1d_omp, pwe_and_ranges)
+{
+  const size_t len = 100'003;  // So the last segment is shorter.
+  const size_t seg_len = 10'000;
+  const double tol = 1e-4;
+  auto input = make_signal(len);
+
+  auto encoder = sperr::SPERR1D_OMP_C();
+  encoder.set_num_threads(4);
+  encoder.set_length_and_segment(len, seg_len);
+  encoder.set_tolerance(tol);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  ASSERT_FALSE(stream.empty());
+
+  auto decoder = sperr::SPERR1D_OMP_D();
+  decoder.set_num_threads(4);
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  EXPECT_EQ(decoder.get_length(), len);
+  EXPECT_EQ(decoder.get_segment_len(), seg_len);
+
+  // Decode everything.
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  const auto full = decoder.release_decoded_data();
+  ASSERT_EQ(full.size(), len);
+  for (size_t i = 0; i < len; i++)
+    ASSERT_LE(std::abs(double(input[i]) - full[i]), tol);
+
+  // Decode a few ranges, including ones crossing segment boundaries.
+  const auto ranges = std::vector<std::array<size_t, 2>>{
+      {0, 1}, {9'999, 2}, {15'000, 30'000}, {100'000, 3}, {0, len}};
+  for (auto [start, n] : ranges) {
+    ASSERT_EQ(decoder.decompress_range(stream.data(), start, n), RTNType::Good);
+    const auto& part = decoder.view_decoded_data();
+    ASSERT_EQ(part.size(), n);
+    EXPECT_TRUE(std::equal(part.cbegin(), part.cend(), full.cbegin() + start));
+  }
+
+  // Invalid ranges.
+  EXPECT_EQ(decoder.decompress_range(stream.data(), len, 1), RTNType::Error);
+  EXPECT_EQ(decoder.decompress_range(stream.data(), 10, len), RTNType::Error);
+  EXPECT_EQ(decoder.decompress_range(stream.data(), 0, 0), RTNType::Error);
+}
+
+TEST(sperr1d_omp, one_segment)
+{
+  const size_t len = 4'000;
+  auto input = make_signal(len);
+
+  auto encoder = sperr::SPERR1D_OMP_C();
+  encoder.set_length_and_segment(len, len * 10);  // Bigger than the array.
+  encoder.set_psnr(100.0);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR1D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(stream.data(), stream.size() + 1), RTNType::WrongLength);
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  EXPECT_EQ(decoder.get_segment_len(), len);
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  const auto& output = decoder.view_decoded_data();
+  ASSERT_EQ(output.size(), len);
+  auto inputd = sperr::vecd_type(input.cbegin(), input.cend());
+  auto stats = sperr::calc_stats(inputd.data(), output.data(), len, 0);
+  EXPECT_GE(stats[2], 99.0);  // PSNR
+}
+
+}  // namespace
@@ -0,0 +1,91 @@
+#include "SPECK2D_FLT.h"
+#include "SPERR2D_OMP_C.h"
+#include "SPERR2D_OMP_D.h"
+
+#include <cstring>
+#include "gtest/gtest.h"
+
+namespace {
+
+using sperr::RTNType;
+
+//
+// Compress the 41 levels of a 3D field as 2D slices. Each slice in the batch should be
+//    identical to compressing that slice alone using SPECK2D_FLT.
+//
+TEST(sperr2d_omp, batch_vs_individual)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto slice_len = dims[0] * dims[1];
+  ASSERT_EQ(input.size(), slice_len * dims[2]);
+
+  auto encoder = sperr::SPERR2D_OMP_C();
+  encoder.set_dims(dims);
+  encoder.set_num_threads(4);
+  encoder.set_psnr(90.0);
+  auto rtn = encoder.compress(input.data(), input.size());
+  ASSERT_EQ(rtn, RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  ASSERT_FALSE(stream.empty());
+
+  auto decoder = sperr::SPERR2D_OMP_D();
+  decoder.set_num_threads(4);
+  rtn = decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(rtn, RTNType::Good);
+  EXPECT_EQ(decoder.get_dims(), dims);
+  rtn = decoder.decompress(stream.data());
+  ASSERT_EQ(rtn, RTNType::Good);
+  const auto& all_slices = decoder.view_decoded_data();
+  ASSERT_EQ(all_slices.size(), input.size());
+
+  auto speck = sperr::SPECK2D_FLT();
+  for (size_t i = 0; i < dims[2]; i += 10) {
+    // Compress this slice individually.
+    speck.set_dims({dims[0], dims[1], 1});
+    speck.copy_data(input.data() + i * slice_len, slice_len);
+    speck.set_psnr(90.0);
+    ASSERT_EQ(speck.compress(), RTNType::Good);
+    auto slice_stream = sperr::vec8_type();
+    speck.append_encoded_bitstream(slice_stream);
+
+    // The bitstream in the batch should be the same.
+    auto [offset, len] = decoder.get_slice_range(i);
+    ASSERT_EQ(len, slice_stream.size());
+    EXPECT_EQ(std::memcmp(stream.data() + offset, slice_stream.data(), len), 0);
+
+    // Random access to this slice should give the same values as decompressing everything.
+    rtn = decoder.decompress_slice(stream.data(), i);
+    ASSERT_EQ(rtn, RTNType::Good);
+    const auto& slice = decoder.view_decoded_slice();
+    ASSERT_EQ(slice.size(), slice_len);
+    EXPECT_TRUE(std::equal(slice.cbegin(), slice.cend(), all_slices.cbegin() + i * slice_len));
+  }
+
+  EXPECT_EQ(decoder.decompress_slice(stream.data(), dims[2]), RTNType::Error);
+}
+
+TEST(sperr2d_omp, header_errors)
+{
+  auto input = sperr::vecd_type(16 * 16 * 3);
+  for (size_t i = 0; i < input.size(); i++)
+    input[i] = double(i % 17) * 0.5;
+
+  auto encoder = sperr::SPERR2D_OMP_C();
+  encoder.set_dims({16, 16, 3});
+  encoder.set_tolerance(1e-3);
+  EXPECT_EQ(encoder.compress(input.data(), input.size() - 1), RTNType::WrongLength);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR2D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(stream.data(), stream.size() - 1), RTNType::WrongLength);
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  const auto& output = decoder.view_decoded_data();
+  ASSERT_EQ(output.size(), input.size());
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_LE(std::abs(input[i] - output[i]), 1e-3);
+}
+
+}  // namespace
@@ -1,5 +1,8 @@
 #include "SPERR3D_OMP_C.h"
 #include "SPERR3D_OMP_D.h"
+#include "SPERR3D_Pipeline_C.h"
+#include "SPERR3D_Series_C.h"
+#include "SPERR3D_Stream_Tools.h"
 
 #include <cstring>
 #include "gtest/gtest.h"
@@ -252,6 +255,32 @@ TEST(sperr3d_target_psnr, small_data_range)
   EXPECT_LT(stats[2], 126.8867);
 }
 
+//
+// Test a long thin chunk, which has a dimension longer than 65,535.
+//
+TEST(sperr3d_target_psnr, long_chunk)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{70000, 4, 2};
+  const auto total_len = dims[0] * dims[1] * dims[2];
+  input.resize(total_len);
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, dims);
+  encoder.set_psnr(90.0);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  EXPECT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  EXPECT_EQ(decoder.get_dims(), dims);
+  const auto& output = decoder.view_decoded_data();
+  auto inputd = sperr::vecd_type(input.cbegin(), input.cend());
+  auto stats = sperr::calc_stats(inputd.data(), output.data(), total_len, 4);
+  EXPECT_GT(stats[2], 90.0);
+}
+
 //
 // Test fixed-size mode
 //
@@ -344,4 +373,253 @@ TEST(sperr3d_multi_res, canonical)
   }
 }
 
+//
+// Test resumable progressive decoding
+//
+TEST(sperr3d_refine, vorticity)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 41};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_bitrate(4.0);
+  encoder.set_num_threads(2);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto part10 = tools.progressive_truncate(stream.data(), stream.size(), 10);
+  auto part30 = tools.progressive_truncate(stream.data(), stream.size(), 30);
+
+  // Decode 10% of the bitstream, then refine with 30%, then with the full bitstream.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(2);
+  decoder.set_resumable(true);
+  decoder.use_bitstream(part10.data(), part10.size());
+  EXPECT_EQ(decoder.decompress(part10.data()), RTNType::Good);
+
+  auto scratch = sperr::SPERR3D_OMP_D();
+  for (const auto* part : {&part30, &stream}) {
+    EXPECT_EQ(decoder.refine(part->data(), part->size()), RTNType::Good);
+    scratch.use_bitstream(part->data(), part->size());
+    EXPECT_EQ(scratch.decompress(part->data()), RTNType::Good);
+    EXPECT_EQ(decoder.get_dims(), dims);
+    EXPECT_EQ(decoder.view_decoded_data(), scratch.view_decoded_data());
+  }
+}
+
+//
+// Refine a bitstream of a region of interest, where chunks outside of the region are empty, with
+//    the full bitstream. Chunks that weren't decoded before are decoded from scratch.
+//
+TEST(sperr3d_refine, region_then_full)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {64, 64, 41});
+  encoder.set_bitrate(4.0);
+  encoder.set_num_threads(2);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  const auto header = tools.get_stream_header(stream.data());
+  const auto plan = tools.plan_ranges(header, {0, 10, 0, 10, 0, 10}, 100);
+  auto fetched = sperr::vec8_type();
+  for (size_t i = 0; i < plan.ranges.size(); i += 2) {
+    const auto* begin = stream.data() + plan.ranges[i];
+    fetched.insert(fetched.end(), begin, begin + plan.ranges[i + 1]);
+  }
+  auto part = tools.assemble_ranges(plan, fetched.data(), fetched.size());
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(2);
+  decoder.set_resumable(true);
+  decoder.use_bitstream(part.data(), part.size());
+  EXPECT_EQ(decoder.decompress(part.data()), RTNType::Good);
+  EXPECT_EQ(decoder.refine(stream.data(), stream.size()), RTNType::Good);
+
+  auto scratch = sperr::SPERR3D_OMP_D();
+  scratch.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(scratch.decompress(stream.data()), RTNType::Good);
+  EXPECT_EQ(decoder.view_decoded_data(), scratch.view_decoded_data());
+}
+
+//
+// Test time-series compression
+//
+TEST(sperr3d_series, same_as_omp_c)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 41};
+
+  // Make up a few time steps.
+  auto steps = std::vector<std::vector<float>>(4, input);
+  for (size_t t = 1; t < steps.size(); t++)
+    for (size_t i = 0; i < input.size(); i++)
+      steps[t][i] = input[i] * float(t + 1) + float(i % 7) * 1e-6f;
+
+  auto series = sperr::SPERR3D_Series_C();
+  series.set_dims_and_chunks(dims, chunks);
+  series.set_tolerance(1.5e-6);
+  series.set_num_threads(3);
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_tolerance(1.5e-6);
+  encoder.set_num_threads(2);
+
+  // The third time step is not gathered ahead of time.
+  for (size_t t = 0; t < steps.size(); t++) {
+    const float* next = (t + 1 < steps.size() && t != 1) ? steps[t + 1].data() : nullptr;
+    EXPECT_EQ(series.compress(steps[t].data(), input.size(), next), RTNType::Good);
+    EXPECT_EQ(encoder.compress(steps[t].data(), input.size()), RTNType::Good);
+    EXPECT_EQ(series.assemble_encoded_bitstream(), encoder.get_encoded_bitstream());
+  }
+
+  // Change the compression mode and the data type.
+  auto inputd = sperr::vecd_type(input.begin(), input.end());
+  series.set_bitrate(2.5);
+  encoder.set_bitrate(2.5);
+  EXPECT_EQ(series.compress(inputd.data(), inputd.size()), RTNType::Good);
+  EXPECT_EQ(encoder.compress(inputd.data(), inputd.size()), RTNType::Good);
+  EXPECT_EQ(series.assemble_encoded_bitstream(), encoder.get_encoded_bitstream());
+  EXPECT_EQ(series.compress(inputd.data(), 10), RTNType::WrongLength);
+}
+
+//
+// Test pipelined compression from file to file
+//
+TEST(sperr3d_pipeline, same_as_omp_c)
+{
+  const auto filename = std::string("../test_data/vorticity.128_128_41");
+  auto input = sperr::read_whole_file<float>(filename);
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{32, 48, 20};
+  const auto output = std::string("pipeline.tmp");
+
+  for (auto footer : {false, true}) {
+    auto pipeline = sperr::SPERR3D_Pipeline_C();
+    pipeline.set_dims_and_chunks(dims, chunks);
+    pipeline.set_psnr(90.0);
+    pipeline.enable_rd_table(true);
+    pipeline.set_footer_index(footer);
+    pipeline.set_num_threads(3);
+    pipeline.set_queue_depth(4);
+    EXPECT_EQ(pipeline.compress_file<float>(filename, output), RTNType::Good);
+    auto stream = sperr::read_whole_file<uint8_t>(output);
+
+    auto encoder = sperr::SPERR3D_OMP_C();
+    encoder.set_dims_and_chunks(dims, chunks);
+    encoder.set_psnr(90.0);
+    encoder.enable_rd_table(true);
+    encoder.set_large_header(true, footer);
+    encoder.set_num_threads(2);
+    encoder.compress(input.data(), input.size());
+    EXPECT_EQ(stream, encoder.get_encoded_bitstream());
+
+    EXPECT_GT(pipeline.get_elapsed_time(), 0.0);
+    for (auto u : pipeline.get_stage_utilization()) {
+      EXPECT_GE(u, 0.0);
+      EXPECT_LE(u, 1.0);
+    }
+  }
+
+  // The input file has a wrong length as doubles.
+  auto pipeline = sperr::SPERR3D_Pipeline_C();
+  pipeline.set_dims_and_chunks(dims, chunks);
+  pipeline.set_bitrate(2.0);
+  EXPECT_EQ(pipeline.compress_file<double>(filename, output), RTNType::WrongLength);
+  std::remove(output.data());
+}
+
+//
+// Test memory policies, which shouldn't change any result.
+//
+TEST(sperr3d_mem_policy, same_results)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+
+  // A single chunk, so that chunk buffers are big enough to use huge pages.
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, dims);
+  encoder.set_tolerance(1e-4);
+  encoder.compress(input.data(), input.size());
+  const auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data(), true);
+  const auto output = decoder.view_decoded_data();
+  const auto hierarchy = decoder.view_hierarchy();
+
+  for (auto policy : {sperr::MemPolicy::HugePages, sperr::MemPolicy::HugeTLB}) {
+    encoder.set_mem_policy(policy);
+    EXPECT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+    EXPECT_EQ(encoder.get_encoded_bitstream(), stream);
+
+    decoder.set_mem_policy(policy);
+    decoder.use_bitstream(stream.data(), stream.size());
+    EXPECT_EQ(decoder.decompress(stream.data(), true), RTNType::Good);
+    EXPECT_EQ(decoder.view_decoded_data(), output);
+    EXPECT_EQ(decoder.view_hierarchy(), hierarchy);
+    EXPECT_EQ(decoder.view_decoded_data().get_allocator().policy(), policy);
+  }
+}
+
+TEST(sperr3d_profile, chunk_profiles)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 41};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_psnr(80.0);
+  encoder.set_num_threads(2);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  const auto& enc_profiles = encoder.view_chunk_profiles();
+  EXPECT_EQ(enc_profiles.size(), 4);
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(2);
+  decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  const auto& dec_profiles = decoder.view_chunk_profiles();
+  EXPECT_EQ(dec_profiles.size(), 4);
+
+  auto json = sperr::profile_report_json(enc_profiles);
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_NE(json.find("\"chunks\""), std::string::npos);
+
+  if constexpr (sperr::profiling) {
+    for (const auto& p : enc_profiles) {
+      EXPECT_FALSE(p.sorting_bits.empty());
+      EXPECT_GT(p.seconds[size_t(sperr::Stage::DWT)], 0.0);
+      EXPECT_GT(p.bytes_allocated, 0);
+    }
+    // There are more chunks than threads, so some chunks are gathered into reused memory.
+    auto total = sperr::Profile();
+    for (const auto& p : enc_profiles)
+      total.merge(p);
+    EXPECT_GT(total.bytes_reused, 0);
+    // The decoder consumes the same bits as the encoder produces.
+    for (size_t i = 0; i < enc_profiles.size(); i++) {
+      EXPECT_EQ(enc_profiles[i].sorting_bits, dec_profiles[i].sorting_bits);
+      EXPECT_EQ(enc_profiles[i].refinement_bits, dec_profiles[i].refinement_bits);
+    }
+  }
+  else {
+    for (const auto& p : enc_profiles)
+      EXPECT_TRUE(p.sorting_bits.empty());
+  }
+}
+
 }  // anonymous namespace
@@ -293,6 +293,30 @@ TEST(sperr_helper, read_sections)
   EXPECT_EQ(buf, buf2);
 }
 
+TEST(sperr_helper, read_sections_coalesced)
+{
+  auto vec = std::vector<uint8_t>(100'000);
+  for (size_t i = 0; i < vec.size(); i++)
+    vec[i] = static_cast<uint8_t>(i * 7 + i / 256);
+  sperr::write_n_bytes("test.tmp", vec.size(), vec.data());
+
+  // Sections that are out of order, adjacent, far apart, overlapping, duplicated, and empty.
+  auto secs = std::vector<size_t>{90'000, 100, 10, 20,  30, 5,    35,     64, 0,  7,
+                                  20,     30,  50, 0,   30, 5,    60'000, 10, 99'990, 10};
+  auto truth = sperr::vec8_type{1, 2, 3};
+  sperr::extract_sections(vec.data(), vec.size(), secs, truth);
+
+  // Try different gap thresholds and numbers of threads.
+  for (size_t gap : {0, 16, 1'000'000}) {
+    for (size_t nthreads : {1, 3}) {
+      auto buf = sperr::vec8_type{1, 2, 3};
+      auto rtn = sperr::read_sections("test.tmp", secs, buf, nthreads, gap);
+      EXPECT_EQ(rtn, sperr::RTNType::Good);
+      EXPECT_EQ(buf, truth);
+    }
+  }
+}
+
 TEST(sperr_helper, msb_position)
 {
   // Zero returns -1
@@ -324,4 +348,38 @@ TEST(sperr_helper, msb_position)
   EXPECT_EQ(sperr::msb_position(uint64_t{1} << 62), 62);
 }
 
+TEST(sperr_helper, uninit_vec_policy)
+{
+  const auto big = 3 * sperr::huge_page_size / sizeof(double) + 5;
+  for (auto policy :
+       {sperr::MemPolicy::Default, sperr::MemPolicy::HugePages, sperr::MemPolicy::HugeTLB}) {
+    auto alloc = sperr::vecd_type::allocator_type(policy);
+    auto vec = sperr::vecd_type(alloc);
+    vec.resize(big);
+    for (size_t i = 0; i < vec.size(); i++)
+      vec[i] = double(i);
+#ifdef __linux__
+    if (policy != sperr::MemPolicy::Default) {
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(vec.data()) % sperr::huge_page_size, 0);
+    }
+#endif
+
+    // Small buffers and explicit values work as usual.
+    auto small = sperr::vecd_type(10, 1.5, alloc);
+    EXPECT_EQ(small, sperr::vecd_type(10, 1.5));
+
+    // The policy travels with the memory.
+    auto copy = sperr::vecd_type();
+    copy = vec;
+    EXPECT_EQ(copy.get_allocator().policy(), policy);
+    EXPECT_EQ(copy, vec);
+    auto moved = std::move(vec);
+    EXPECT_EQ(moved.get_allocator().policy(), policy);
+    EXPECT_EQ(moved, copy);
+    moved.resize(big * 2, 2.5);
+    EXPECT_EQ(moved[big - 1], double(big - 1));
+    EXPECT_EQ(moved.back(), 2.5);
+  }
+}
+
 }  // namespace
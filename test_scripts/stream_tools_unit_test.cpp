@@ -1,4 +1,5 @@
 #include "SPERR3D_OMP_C.h"
+#include "SPERR3D_OMP_D.h"
 #include "SPERR3D_Stream_Tools.h"
 
 #include "gtest/gtest.h"
@@ -183,4 +184,203 @@ TEST(stream_tools, min_chunk_len)
   EXPECT_EQ(trunc, part);
 }
 
+//
+// Test quality-targeted truncation with rate-distortion tables.
+//
+auto DecodeAndPSNR(const sperr::vec8_type& stream, const std::vector<float>& orig) -> double
+{
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data());
+  auto outputf = std::vector<float>(orig.size());
+  const auto& output = decoder.view_decoded_data();
+  std::copy(output.cbegin(), output.cend(), outputf.begin());
+  return sperr::calc_stats(orig.data(), outputf.data(), orig.size(), 1)[2];
+}
+
+TEST(stream_tools, rd_table)
+{
+  auto filename = std::string("./test.tmp");
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  assert(!input.empty());
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks({128, 128, 41}, {31, 40, 21});
+  encoder.set_psnr(100.0);
+  encoder.compress(input.data(), input.size());
+  auto plain = encoder.get_encoded_bitstream();
+  encoder.enable_rd_table(true);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+  sperr::write_n_bytes(filename, stream.size(), stream.data());
+
+  // The rate-distortion section doesn't change the decoded result.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto header = tools.get_stream_header(stream.data());
+  EXPECT_TRUE(header.has_rd_table);
+  EXPECT_EQ(header.stream_len, stream.size());
+  EXPECT_EQ(stream[0], sperr::extended_header_version);
+  EXPECT_EQ(plain[0], static_cast<uint8_t>(SPERR_VERSION_MAJOR));
+  EXPECT_GT(stream.size(), plain.size());
+  auto psnr_full = DecodeAndPSNR(stream, input);
+  EXPECT_EQ(psnr_full, DecodeAndPSNR(plain, input));
+  EXPECT_EQ(tools.progressive_truncate(stream.data(), stream.size(), 100), stream);
+
+  // Bitstreams without rate-distortion tables can't be truncated this way.
+  EXPECT_TRUE(tools.truncate_to_psnr(plain.data(), plain.size(), 60.0).empty());
+
+  // Target a PSNR; the estimate should be reasonably close.
+  auto part = tools.read_to_psnr(filename, 60.0);
+  EXPECT_EQ(part, tools.truncate_to_psnr(stream.data(), stream.size(), 60.0));
+  EXPECT_FALSE(tools.get_stream_header(part.data()).has_rd_table);
+  EXPECT_EQ(part[0], static_cast<uint8_t>(SPERR_VERSION_MAJOR));
+  EXPECT_LT(part.size(), stream.size());
+  auto psnr = DecodeAndPSNR(part, input);
+  EXPECT_NEAR(psnr, 60.0, 1.0);
+
+  // Target a number of bytes, and compare with keeping the same percentage of every chunk.
+  auto pct_part = tools.progressive_truncate(stream.data(), stream.size(), 10);
+  part = tools.read_to_bytes(filename, pct_part.size());
+  EXPECT_EQ(part, tools.truncate_to_bytes(stream.data(), stream.size(), pct_part.size()));
+  EXPECT_LE(part.size(), pct_part.size());
+  auto psnr_rd = DecodeAndPSNR(part, input);
+  auto psnr_pct = DecodeAndPSNR(pct_part, input);
+  EXPECT_GT(psnr_rd, psnr_pct);
+
+  // A header with an RD section but the plain version number, which decoders before RD sections
+  //    expect, is rejected as a version mismatch.
+  auto old_version = stream;
+  old_version[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  auto decoder = sperr::SPERR3D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(old_version.data(), old_version.size()),
+            RTNType::VersionMismatch);
+}
+
+//
+// Test planning byte ranges to fetch for a region of interest.
+//
+TEST(stream_tools, plan_ranges)
+{
+  auto filename = std::string("./test.tmp");
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  assert(!input.empty());
+  const auto dims = sperr::dims_type{128, 128, 41};
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {31, 40, 21});
+  encoder.set_psnr(100.0);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+  sperr::write_n_bytes(filename, stream.size(), stream.data());
+
+  // Only the header is read before planning.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto arr20 = std::array<uint8_t, 20>();
+  std::copy(stream.begin(), stream.begin() + 20, arr20.begin());
+  auto header_buf = sperr::read_n_bytes(filename, tools.get_header_len(arr20));
+  const auto region = std::array<size_t, 6>{20, 30, 30, 20, 15, 10};
+  const auto header = tools.get_stream_header(header_buf.data());
+  auto plan = tools.plan_ranges(header, region, 50);
+  auto merged = tools.plan_ranges(header, region, 50, 65536);
+  EXPECT_LT(merged.ranges.size(), plan.ranges.size());
+  EXPECT_EQ(merged.chunk_offsets, plan.chunk_offsets);
+
+  // Fetch the planned ranges, and assemble a partial bitstream.
+  auto fetched = sperr::vec8_type();
+  sperr::read_sections(filename, plan.ranges, fetched);
+  auto part = tools.assemble_ranges(plan, fetched.data(), fetched.size());
+  fetched.clear();
+  sperr::read_sections(filename, merged.ranges, fetched);
+  EXPECT_EQ(tools.assemble_ranges(merged, fetched.data(), fetched.size()), part);
+
+  // The region decodes the same as in a progressively truncated bitstream, and chunks that
+  //    don't intersect with the region are zeros.
+  auto trunc = tools.progressive_truncate(stream.data(), stream.size(), 50);
+  auto decoder = sperr::SPERR3D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(part.data(), part.size()), RTNType::Good);
+  EXPECT_EQ(decoder.decompress(part.data()), RTNType::Good);
+  auto output = decoder.release_decoded_data();
+  decoder.use_bitstream(trunc.data(), trunc.size());
+  decoder.decompress(trunc.data());
+  const auto& truth = decoder.view_decoded_data();
+  for (size_t z = region[4]; z < region[4] + region[5]; z++)
+    for (size_t y = region[2]; y < region[2] + region[3]; y++)
+      for (size_t x = region[0]; x < region[0] + region[1]; x++) {
+        const auto idx = z * dims[0] * dims[1] + y * dims[0] + x;
+        EXPECT_EQ(output[idx], truth[idx]);
+      }
+  EXPECT_EQ(output.back(), 0.0);
+  EXPECT_LT(part.size(), trunc.size());
+}
+
+//
+// Test bitstreams with a large header, with the chunk index inline or in a footer.
+//
+TEST(stream_tools, large_header)
+{
+  auto filename = std::string("./test.tmp");
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  assert(!input.empty());
+  const auto dims = sperr::dims_type{128, 128, 41};
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {31, 40, 21});
+  encoder.set_psnr(100.0);
+  encoder.enable_rd_table(true);
+  encoder.compress(input.data(), input.size());
+  auto plain = encoder.get_encoded_bitstream();
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto plain_header = tools.get_stream_header(plain.data());
+  auto psnr_pct = DecodeAndPSNR(tools.progressive_truncate(plain.data(), plain.size(), 35), input);
+  auto psnr_rd = DecodeAndPSNR(tools.truncate_to_psnr(plain.data(), plain.size(), 60.0), input);
+
+  for (auto footer : {false, true}) {
+    encoder.set_large_header(true, footer);
+    auto stream = encoder.get_encoded_bitstream();
+    sperr::write_n_bytes(filename, stream.size(), stream.data());
+
+    // The header records the same info, and chunks are stored the same.
+    auto header = tools.get_stream_header(stream.data());
+    EXPECT_TRUE(header.large_header);
+    EXPECT_EQ(header.major_version, sperr::extended_header_version);
+    EXPECT_EQ(header.footer_index, footer);
+    EXPECT_EQ(header.vol_dims, dims);
+    EXPECT_EQ(header.stream_len, stream.size());
+    EXPECT_EQ(header.chunk_offsets.empty(), footer);
+    if (footer)
+      tools.read_chunk_index(header, stream.data() + header.index_offset);
+    ASSERT_EQ(header.chunk_offsets.size(), plain_header.chunk_offsets.size());
+    for (size_t i = 1; i < header.chunk_offsets.size(); i += 2)
+      EXPECT_EQ(header.chunk_offsets[i], plain_header.chunk_offsets[i]);
+    EXPECT_EQ(header.rd_table_len, plain_header.rd_table_len);
+    EXPECT_EQ(header.stream_len - header.rd_table_offset - (footer ? header.index_len : 0),
+              header.rd_table_len);
+
+    // Decoding, and all kinds of partial access, give the same results as the default header.
+    EXPECT_EQ(DecodeAndPSNR(stream, input), DecodeAndPSNR(plain, input));
+    auto part = tools.progressive_read(filename, 35);
+    EXPECT_EQ(part, tools.progressive_truncate(stream.data(), stream.size(), 35));
+    EXPECT_TRUE(tools.get_stream_header(part.data()).large_header);
+    EXPECT_EQ(DecodeAndPSNR(part, input), psnr_pct);
+    EXPECT_EQ(tools.progressive_read(filename, 100), stream);
+    part = tools.read_to_psnr(filename, 60.0);
+    EXPECT_EQ(part, tools.truncate_to_psnr(stream.data(), stream.size(), 60.0));
+    EXPECT_EQ(DecodeAndPSNR(part, input), psnr_rd);
+
+    const auto region = std::array<size_t, 6>{20, 30, 30, 20, 15, 10};
+    auto plan = tools.plan_ranges(header, region, 50, 65536);
+    auto fetched = sperr::vec8_type();
+    sperr::read_sections(filename, plan.ranges, fetched);
+    part = tools.assemble_ranges(plan, fetched.data(), fetched.size());
+    auto decoder = sperr::SPERR3D_OMP_D();
+    EXPECT_EQ(decoder.use_bitstream(part.data(), part.size()), RTNType::Good);
+    EXPECT_EQ(decoder.decompress(part.data()), RTNType::Good);
+    EXPECT_EQ(part[0], sperr::extended_header_version);
+
+    // A large header with the plain version number, which decoders before large headers expect,
+    //    is rejected as a version mismatch.
+    auto old_version = stream;
+    old_version[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+    EXPECT_EQ(decoder.use_bitstream(old_version.data(), old_version.size()),
+              RTNType::VersionMismatch);
+  }
+}
+
 }  // anonymous namespace
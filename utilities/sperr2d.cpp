@@ -23,7 +23,7 @@ auto create_filenames(std::string name, sperr::dims_type dims) -> std::vector<st
 }
 
 // This function is used to output coarsened levels of the resolution hierarchy.
-auto output_hierarchy(const std::vector<std::vector<double>>& hierarchy,
+auto output_hierarchy(const std::vector<sperr::vecd_type>& hierarchy,
                       sperr::dims_type dims,
                       const std::string& lowres_f64,
                       const std::string& lowres_f32) -> int
@@ -46,7 +46,7 @@ auto output_hierarchy(const std::vector<std::vector<double>>& hierarchy,
   if (!lowres_f32.empty()) {
     auto filenames = create_filenames(lowres_f32, dims);
     assert(hierarchy.size() == filenames.size());
-    auto buf = std::vector<float>(hierarchy.back().size());
+    auto buf = sperr::vecf_type(hierarchy.back().size());
     for (size_t i = 0; i < filenames.size(); i++) {
       const auto& level = hierarchy[i];
       std::copy(level.begin(), level.end(), buf.begin());
@@ -89,6 +89,24 @@ auto output_buffer(const sperr::vecd_type& buf,
   return 0;
 }
 
+// Output the timers and counters collected during (de)compression as JSON, if a name is given.
+auto output_profile(const sperr::Profile& prof, const std::string& name) -> int
+{
+  if (name.empty())
+    return 0;
+  if (!sperr::profiling)
+    std::cout << "Warning: SPERR is built without SPERR_PROFILE; the profile will be empty."
+              << std::endl;
+  const auto json = sperr::profile_report_json({prof});
+  auto rtn = sperr::write_n_bytes(name, json.size(), json.data());
+  if (rtn != sperr::RTNType::Good) {
+    std::cout << "Writing profile failed: " << name << std::endl;
+    return __LINE__;
+  }
+
+  return 0;
+}
+
 int main(int argc, char* argv[])
 {
   // Parse command line options
@@ -156,6 +174,12 @@ int main(int argc, char* argv[])
       ->needs(cptr)
       ->group("Output settings");
 
+  auto profile = std::string();
+  app.add_option("--profile", profile,
+                 "Output per-stage timers and counters as JSON.\n"
+                 "(Needs SPERR built with SPERR_PROFILE=ON.)")
+      ->group("Output settings");
+
   //
   // Compression settings
   //
@@ -288,6 +312,8 @@ int main(int argc, char* argv[])
     stream[1] = sperr::pack_8_booleans(b8);
     std::memcpy(stream.data() + 2, dim2d.data(), sizeof(dim2d));
     encoder->append_encoded_bitstream(stream);
+    if (output_profile(encoder->view_profile(), profile))
+      return __LINE__ % 256;
     encoder.reset();  // Free up some more memory.
 
     // Output the compressed bitstream (maybe).
@@ -395,6 +421,9 @@ int main(int argc, char* argv[])
       return __LINE__ % 256;
     }
 
+    if (output_profile(decoder->view_profile(), profile))
+      return __LINE__ % 256;
+
     // Save the decompressed data, and then deconstruct the decoder to free up some memory!
     auto hierarchy = decoder->release_hierarchy();
     auto outputd = decoder->release_decoded_data();
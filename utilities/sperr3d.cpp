@@ -1,5 +1,6 @@
 #include "SPERR3D_OMP_C.h"
 #include "SPERR3D_OMP_D.h"
+#include "SPERR3D_Pipeline_C.h"
 
 #include "CLI/App.hpp"
 #include "CLI/Config.hpp"
@@ -27,7 +28,7 @@ auto create_filenames(std::string name,
 }
 
 // This function is used to output coarsened levels of the resolution hierarchy.
-auto output_hierarchy(const std::vector<std::vector<double>>& hierarchy,
+auto output_hierarchy(const std::vector<sperr::vecd_type>& hierarchy,
                       sperr::dims_type vdims,
                       sperr::dims_type cdims,
                       const std::string& lowres_f64,
@@ -51,7 +52,7 @@ auto output_hierarchy(const std::vector<std::vector<double>>& hierarchy,
   if (!lowres_f32.empty()) {
     auto filenames = create_filenames(lowres_f32, vdims, cdims);
     assert(hierarchy.size() == filenames.size());
-    auto buf = std::vector<float>(hierarchy.back().size());
+    auto buf = sperr::vecf_type(hierarchy.back().size());
     for (size_t i = 0; i < filenames.size(); i++) {
       const auto& level = hierarchy[i];
       std::copy(level.begin(), level.end(), buf.begin());
@@ -94,6 +95,24 @@ auto output_buffer(const sperr::vecd_type& buf,
   return 0;
 }
 
+// Output the timers and counters collected during (de)compression as JSON, if a name is given.
+auto output_profile(const std::vector<sperr::Profile>& profiles, const std::string& name) -> int
+{
+  if (name.empty())
+    return 0;
+  if (!sperr::profiling)
+    std::cout << "Warning: SPERR is built without SPERR_PROFILE; the profile will be empty."
+              << std::endl;
+  const auto json = sperr::profile_report_json(profiles);
+  auto rtn = sperr::write_n_bytes(name, json.size(), json.data());
+  if (rtn != sperr::RTNType::Good) {
+    std::cout << "Writing profile failed: " << name << std::endl;
+    return __LINE__;
+  }
+
+  return 0;
+}
+
 int main(int argc, char* argv[])
 {
   // Parse command line options
@@ -124,6 +143,14 @@ int main(int argc, char* argv[])
       ->group("Execution settings");
 #endif
 
+  auto pipeline = bool{false};
+  app.add_flag("--pipeline", pipeline,
+               "Stream the input file to the output bitstream, overlapping reading,\n"
+               "compressing, and writing, and report how busy each stage was.\n"
+               "It always uses a large header (see --large_header).")
+      ->needs(cptr)
+      ->group("Execution settings");
+
   //
   // Input properties
   //
@@ -168,6 +195,12 @@ int main(int argc, char* argv[])
       ->needs(cptr)
       ->group("Output settings");
 
+  auto profile = std::string();
+  app.add_option("--profile", profile,
+                 "Output per-stage timers and counters as JSON.\n"
+                 "(Needs SPERR built with SPERR_PROFILE=ON.)")
+      ->group("Output settings");
+
   //
   // Compression settings
   //
@@ -193,6 +226,24 @@ int main(int argc, char* argv[])
                       ->excludes(psnr_ptr)
                       ->group("Compression settings");
 
+  auto rd_table = false;
+  app.add_flag("--rd_table", rd_table,
+               "Record rate-distortion tables in the bitstream, so it can be truncated\n"
+               "to a target PSNR or size later (see `sperr3d_trunc`).")
+      ->group("Compression settings");
+
+  auto large_header = false;
+  app.add_flag("--large_header", large_header,
+               "Use a header with 64-bit dimensions and chunk offsets. It's used anyway\n"
+               "when the volume or a chunk is too big for the default header.")
+      ->group("Compression settings");
+
+  auto footer_index = false;
+  app.add_flag("--footer_index", footer_index,
+               "Put the index of chunk offsets at the end of the bitstream.\n"
+               "It implies --large_header.")
+      ->group("Compression settings");
+
 #ifdef EXPERIMENTING
   auto direct_q = 0.0;
   auto* dq_ptr = app.add_option("--dq", direct_q, "Directly provide the quantization step size q.")
@@ -255,6 +306,18 @@ int main(int argc, char* argv[])
       return __LINE__ % 256;
     }
   }
+  if (pipeline && (bitstream.empty() || print_stats || !decomp_f32.empty() ||
+                   !decomp_f64.empty() || !decomp_lowres_f32.empty() ||
+                   !decomp_lowres_f64.empty())) {
+    std::cout << "--pipeline only supports writing to --bitstream!" << std::endl;
+    return __LINE__ % 256;
+  }
+#ifdef EXPERIMENTING
+  if (pipeline && direct_q != 0.0) {
+    std::cout << "--pipeline doesn't support --dq!" << std::endl;
+    return __LINE__ % 256;
+  }
+#endif
   // Print a warning message if there's no output specified
   if (cflag && bitstream.empty())
     std::cout << "Warning: no output file provided. Consider using --bitstream option."
@@ -266,6 +329,39 @@ int main(int argc, char* argv[])
   //
   // Really starting the real work!
   //
+  // Pipelined compression reads the input file by itself.
+  if (pipeline) {
+    auto encoder = sperr::SPERR3D_Pipeline_C();
+    encoder.set_dims_and_chunks(dims, chunks);
+    encoder.set_num_threads(omp_num_threads);
+    encoder.enable_rd_table(rd_table);
+    encoder.set_footer_index(footer_index);
+    if (pwe != 0.0)
+      encoder.set_tolerance(pwe);
+    else if (psnr != 0.0)
+      encoder.set_psnr(psnr);
+    else
+      encoder.set_bitrate(bpp);
+
+    auto rtn = sperr::RTNType::Good;
+    if (ftype == 32)
+      rtn = encoder.compress_file<float>(input_file, bitstream);
+    else
+      rtn = encoder.compress_file<double>(input_file, bitstream);
+    if (rtn != sperr::RTNType::Good) {
+      std::cout << "Compression failed!" << std::endl;
+      return __LINE__ % 256;
+    }
+
+    const auto util = encoder.get_stage_utilization();
+    std::printf("Pipeline took %.3f seconds. Stage utilization: read = %.1f%%, "
+                "compress = %.1f%%, write = %.1f%%\n",
+                encoder.get_elapsed_time(), util[0] * 100.0, util[1] * 100.0, util[2] * 100.0);
+    if (output_profile(encoder.view_chunk_profiles(), profile))
+      return __LINE__ % 256;
+    return 0;
+  }
+
   auto input = sperr::read_whole_file<uint8_t>(input_file);
   if (cflag) {
     const auto total_vals = dims[0] * dims[1] * dims[2];
@@ -277,6 +373,9 @@ int main(int argc, char* argv[])
     auto encoder = std::make_unique<sperr::SPERR3D_OMP_C>();
     encoder->set_dims_and_chunks(dims, chunks);
     encoder->set_num_threads(omp_num_threads);
+    encoder->enable_rd_table(rd_table);
+    if (large_header || footer_index)
+      encoder->set_large_header(true, footer_index);
     if (pwe != 0.0)
       encoder->set_tolerance(pwe);
     else if (psnr != 0.0)
@@ -306,6 +405,8 @@ int main(int argc, char* argv[])
       input.shrink_to_fit();
     }
 
+    if (output_profile(encoder->view_chunk_profiles(), profile))
+      return __LINE__ % 256;
     auto stream = encoder->get_encoded_bitstream();
     encoder.reset();  // Free up some more memory.
 
@@ -398,6 +499,8 @@ int main(int argc, char* argv[])
       return __LINE__ % 256;
     }
 
+    if (output_profile(decoder->view_chunk_profiles(), profile))
+      return __LINE__ % 256;
     auto hierarchy = decoder->release_hierarchy();
     auto outputd = decoder->release_decoded_data();
     auto vdims = decoder->get_dims();
@@ -14,7 +14,9 @@ int main(int argc, char* argv[])
 {
   // Parse command line options
   CLI::App app(
-      "Truncate a SPERR3D bitstream to keep a percentage of its original length.\n"
+      "Truncate a SPERR3D bitstream to keep a percentage of its original length,\n"
+      "or to achieve a target PSNR or size (which needs the bitstream to carry\n"
+      "rate-distortion tables; see `sperr3d --rd_table`).\n"
       "Optionally, it can also evaluate the compression quality after truncation.\n");
 
   // Input specification
@@ -26,9 +28,20 @@ int main(int argc, char* argv[])
   // Truncation settings
   //
   auto pct = uint32_t{0};
-  app.add_option("--pct", pct, "Percentage (1--100) of the original bitstream to truncate.")
-      ->required()
-      ->group("Truncation settings");
+  auto* pct_ptr =
+      app.add_option("--pct", pct, "Percentage (1--100) of the original bitstream to truncate.")
+          ->group("Truncation settings");
+
+  auto psnr = 0.0;
+  auto* psnr_ptr = app.add_option("--psnr", psnr, "Target PSNR (estimated) to truncate to.")
+                       ->excludes(pct_ptr)
+                       ->group("Truncation settings");
+
+  auto num_bytes = size_t{0};
+  auto* bytes_ptr = app.add_option("--bytes", num_bytes, "Target size in bytes to truncate to.")
+                        ->excludes(pct_ptr)
+                        ->excludes(psnr_ptr)
+                        ->group("Truncation settings");
 
   auto omp_num_threads = size_t{0};  // meaning to use the maximum number of threads.
 #ifdef USE_OMP
@@ -62,6 +75,10 @@ int main(int argc, char* argv[])
   //
   // A little sanity check
   //
+  if (pct_ptr->count() + psnr_ptr->count() + bytes_ptr->count() == 0) {
+    std::cout << "Please specify one of --pct, --psnr, or --bytes." << std::endl;
+    return __LINE__;
+  }
   if (!orig32_file.empty() && !orig64_file.empty()) {
     std::cout << "Is the original data in 32 or 64 bit precision?" << std::endl;
     return __LINE__;
@@ -71,7 +88,14 @@ int main(int argc, char* argv[])
   // Really starting the real work!
   //
   auto tool = sperr::SPERR3D_Stream_Tools();
-  auto stream_trunc = tool.progressive_read(input_file, pct);
+  tool.set_num_threads(omp_num_threads);
+  auto stream_trunc = sperr::vec8_type();
+  if (psnr_ptr->count())
+    stream_trunc = tool.read_to_psnr(input_file, psnr);
+  else if (bytes_ptr->count())
+    stream_trunc = tool.read_to_bytes(input_file, num_bytes);
+  else
+    stream_trunc = tool.progressive_read(input_file, pct);
   if (stream_trunc.empty()) {
     std::cout << "Error while truncating bitstream " << input_file << std::endl;
     return __LINE__;
@@ -120,7 +144,7 @@ int main(int argc, char* argv[])
       sigma = std::sqrt(mean_var[1]);
     }
     else {
-      auto outputf = std::vector<float>(total_vals);
+      auto outputf = sperr::vecf_type(total_vals);
       std::copy(outputd.begin(), outputd.end(), outputf.begin());
       outputd.clear();
       outputd.shrink_to_fit();